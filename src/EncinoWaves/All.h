@@ -35,7 +35,9 @@
 #ifndef _EncinoWaves_All_h_
 #define _EncinoWaves_All_h_
 
+#include "AsyncPropagation.h"
 #include "Basics.h"
+#include "CompactInitialState.h"
 #include "DirectionalSpreading.h"
 #include "Dispersion.h"
 #include "FftwWrapper.h"
@@ -47,8 +49,10 @@
 #include "Parameters.h"
 #include "Propagation.h"
 #include "Random.h"
+#include "SnapshotPublisher.h"
 #include "Spectra.h"
 #include "SpectralSpatialField.h"
+#include "SpectralStats.h"
 #include "Stats.h"
 
 #endif
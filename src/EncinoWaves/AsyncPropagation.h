@@ -0,0 +1,297 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#ifndef _EncinoWaves_AsyncPropagation_h_
+#define _EncinoWaves_AsyncPropagation_h_
+
+#include "Foundation.h"
+#include "Parameters.h"
+#include "InitialState.h"
+#include "Propagation.h"
+#include "Normals.h"
+
+namespace EncinoWaves {
+
+//-*****************************************************************************
+// A frame of asynchronous propagation: the propagated state, its normals if
+// they were asked for, and the time it was propagated to.
+template <typename T> struct AsyncPropagatedFrame {
+  PropagatedState<T> State;
+  std::vector<Imath::Vec3<T>> Normals;
+  T Time;
+
+  AsyncPropagatedFrame(const Parameters<T> &i_params, unsigned int i_channels,
+                       bool i_normals)
+      : State(i_params, i_channels), Time(0) {
+    if (i_normals) {
+      Normals.resize(State.Height.size());
+    }
+  }
+};
+
+//-*****************************************************************************
+// Propagates on a producer thread of its own, into a ring of frames, so
+// that a consumer can read one frame while the next is being computed. The
+// cost of a frame is then the larger of propagating and consuming it,
+// rather than their sum.
+//
+// A single consumer thread requests times, and acquires the newest
+// published frame, which stays untouched until the consumer acquires
+// another or releases it. Acquiring takes no locks. With a ring of three
+// frames the producer never waits for the consumer; with two it waits
+// until the consumer lets go of a frame older than the newest one.
+//
+// The producer publishes a frame by storing its index once it is complete,
+// which releases the frame's contents to a consumer that loads the index.
+// The consumer marks the frame it is about to read, then checks that it is
+// still the newest, and the producer only writes frames that are neither
+// the newest nor marked. Each side stores then loads, which needs
+// sequentially consistent operations rather than just acquire and release.
+template <typename T> class AsyncPropagation {
+public:
+  typedef AsyncPropagatedFrame<T> frame_type;
+
+  // The frames have the channels in i_channels, and normals if i_normals is
+  // set. The thread budget, transform and plan options are those of
+  // Propagation.
+  explicit AsyncPropagation(
+      const Parameters<T> &i_params, int i_numFrames = 3,
+      unsigned int i_channels = kAllChannels, bool i_normals = false,
+      int i_nthreads = -1,
+      PropagationTransform i_transform = kRealPropagationTransform,
+      const FftPlanOptions &i_planOptions = FftPlanOptions())
+      : m_params(i_params), m_istate(nullptr),
+        m_propagation(i_params, i_nthreads, i_transform, i_planOptions),
+        m_channels(i_channels), m_published(-1), m_pinned(-1),
+        m_starved(false), m_requestTime(0), m_requested(false),
+        m_busy(false), m_stop(false) {
+    EWAV_ASSERT(i_numFrames >= 2, "Bad number of frames: " << i_numFrames);
+    EWAV_ASSERT(!i_normals || (ResolvePropagatedChannels(i_channels) &
+                               kDisplacementChannels) == kDisplacementChannels,
+                "Normals need the Height, Dx and Dy channels");
+    for (int i = 0; i < i_numFrames; ++i) {
+      m_frames.emplace_back(new frame_type(i_params, i_channels, i_normals));
+    }
+    m_thread = std::thread([this] { run(); });
+  }
+
+  ~AsyncPropagation() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+  }
+
+  // Waits for the frame in progress, then propagates later requests from
+  // i_istate, which must outlive them. The previous initial state can be
+  // destroyed once this returns.
+  void setInitialState(const InitialState<T> *i_istate) {
+    wait();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_istate = i_istate;
+  }
+
+  // The propagation, to change its playback settings. Only touch it
+  // between wait and the next request.
+  Propagation<T> &propagation() { return m_propagation; }
+
+  // Asks for a frame propagated with i_params to i_time, and returns
+  // without waiting. A request that the producer hasn't started yet is
+  // replaced by a newer one.
+  void request(const Parameters<T> &i_params, T i_time) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      EWAV_ASSERT(m_istate, "Propagation requested without initial state");
+      m_requestParams = i_params;
+      m_requestTime = i_time;
+      m_requested = true;
+    }
+    m_wake.notify_all();
+  }
+
+  // Waits until the last request is published, and rethrows the error of
+  // the producer if a frame failed. With a ring of two frames, the
+  // acquired frame is released if the producer needs it, so acquire again
+  // after waiting.
+  void wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_requested || m_busy) {
+      if (m_starved.load()) {
+        m_pinned.store(-1);
+        m_wake.notify_all();
+      }
+      m_idle.wait(lock);
+    }
+    if (m_error) {
+      std::exception_ptr error = m_error;
+      m_error = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  // The newest published frame, or null if there's none yet. It stays valid
+  // until the next acquire or release.
+  const frame_type *acquire() {
+    int frame = m_published.load();
+    while (frame >= 0) {
+      m_pinned.store(frame);
+      const int published = m_published.load();
+      if (published == frame) {
+        break;
+      }
+      frame = published;
+    }
+    unpinned();
+    return frame < 0 ? nullptr : m_frames[frame].get();
+  }
+
+  // Lets go of the acquired frame.
+  void release() {
+    m_pinned.store(-1);
+    unpinned();
+  }
+
+protected:
+  // A frame that's neither published nor pinned, or -1.
+  int freeFrame() const {
+    const int published = m_published.load();
+    const int pinned = m_pinned.load();
+    for (int i = 0; i < int(m_frames.size()); ++i) {
+      if (i != published && i != pinned) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Wakes the producer if it was waiting for the consumer to unpin a frame.
+  void unpinned() {
+    if (m_starved.load()) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_wake.notify_all();
+    }
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+      m_wake.wait(lock, [this] { return m_stop || m_requested; });
+      if (m_stop) {
+        return;
+      }
+
+      int frame = freeFrame();
+      if (frame < 0) {
+        m_starved.store(true);
+        m_idle.notify_all();
+        m_wake.wait(lock, [&] {
+          return m_stop || ((frame = freeFrame()) >= 0);
+        });
+        m_starved.store(false);
+      }
+      if (m_stop) {
+        return;
+      }
+
+      // Take the newest request.
+      m_params = m_requestParams;
+      const T time = m_requestTime;
+      m_requested = false;
+      m_busy = true;
+      lock.unlock();
+
+      std::exception_ptr error;
+      try {
+        frame_type &f = *m_frames[frame];
+        m_propagation.propagate(m_params, *m_istate, f.State, time,
+                                m_channels);
+        if (!f.Normals.empty()) {
+          ComputeNormals(m_params, f.State, f.Normals.data(),
+                         m_propagation.arena());
+        }
+        f.Time = time;
+        m_published.store(frame);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      if (error) {
+        m_error = error;
+      }
+      m_busy = false;
+      m_idle.notify_all();
+    }
+  }
+
+  // Parameters of the frame in progress.
+  Parameters<T> m_params;
+  const InitialState<T> *m_istate;
+  Propagation<T> m_propagation;
+  unsigned int m_channels;
+  std::vector<std::unique_ptr<frame_type>> m_frames;
+
+  // The newest published frame, the frame the consumer is reading, and
+  // whether the producer is waiting for a frame to be unpinned.
+  std::atomic<int> m_published;
+  std::atomic<int> m_pinned;
+  std::atomic<bool> m_starved;
+
+  // Requests and the producer's state, guarded by m_mutex. The producer
+  // waits on m_wake, and signals m_idle when it finishes a frame.
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_idle;
+  Parameters<T> m_requestParams;
+  T m_requestTime;
+  bool m_requested;
+  bool m_busy;
+  bool m_stop;
+  std::exception_ptr m_error;
+
+  std::thread m_thread;
+};
+
+//-*****************************************************************************
+typedef AsyncPropagatedFrame<float> AsyncPropagatedFramef;
+typedef AsyncPropagatedFrame<double> AsyncPropagatedFramed;
+
+typedef AsyncPropagation<float> AsyncPropagationf;
+typedef AsyncPropagation<double> AsyncPropagationd;
+
+} // namespace EncinoWaves
+
+#endif
@@ -186,33 +186,48 @@ public:
 
 protected:
   const STATE* m_state;
-  real_type m_domain;
-  int N;
+  real_type m_domainX;
+  real_type m_domainY;
+  int Nx;
+  int Ny;
 
   std::size_t m_strideJ;
-  real_type m_maxKmag;
   real_type m_dK;
 
 public:
-  // Constructor.
-  SpectralIterationFunctor(const STATE* i_state, real_type i_domain, int i_N)
+  // Iterates over the half spectrum of a real field on an Nx by Ny grid,
+  // covering a domain of i_domainX by i_domainY. The dK given to the
+  // processor is the square root of the area of a bin, so that dK * dK is
+  // the area however the bins are shaped.
+  SpectralIterationFunctor(const STATE* i_state, real_type i_domainX,
+                           real_type i_domainY, int i_Nx, int i_Ny)
       : m_state(i_state)
-      , m_domain(i_domain)
-      , N(i_N) {
-    int width  = (N / 2) + 1;
-    int height = N;
+      , m_domainX(i_domainX)
+      , m_domainY(i_domainY)
+      , Nx(i_Nx)
+      , Ny(i_Ny) {
+    int width  = (Nx / 2) + 1;
+    int height = Ny;
 
     // Constants
-    m_strideJ = (N / 2) + 1;
-    m_maxKmag = real_type(N / 2) * TAU<T> / m_domain;
-    m_dK      = real_type(1) * TAU<T> / m_domain;
+    m_strideJ = (Nx / 2) + 1;
+    m_dK      = TAU<T> / std::sqrt(m_domainX * m_domainY);
 
     // Execute it!
-    int grainSize = std::min(512, N);
+    int grainSize = std::min(512, Nx);
     tbb::parallel_for(
       tbb::blocked_range2d<int>(0, height, 1, 0, width, grainSize), *this);
   }
 
+  SpectralIterationFunctor(const STATE* i_state, real_type i_domainX,
+                           real_type i_domainY, const GridSize& i_size)
+      : SpectralIterationFunctor(i_state, i_domainX, i_domainY, i_size.Width,
+                                 i_size.Height) {}
+
+  // Square N by N grid over a square domain.
+  SpectralIterationFunctor(const STATE* i_state, real_type i_domain, int i_N)
+      : SpectralIterationFunctor(i_state, i_domain, i_domain, i_N, i_N) {}
+
   // Creates a processor from the state.
   void operator()(const tbb::blocked_range2d<int>& i_range) const {
     // Make a processor.
@@ -220,8 +235,8 @@ public:
 
     for (int j = i_range.rows().begin(); j != i_range.rows().end(); ++j) {
       // kj is the wave number in the j direction.
-      int realJ    = j <= (N / 2) ? j : j - N;
-      real_type kj = real_type(realJ) * TAU<T> / m_domain;
+      int realJ    = j <= (Ny / 2) ? j : j - Ny;
+      real_type kj = real_type(realJ) * TAU<T> / m_domainY;
 
       // Compute start index.
       std::size_t index =
@@ -231,13 +246,10 @@ public:
       for (int i = i_range.cols().begin(); i != i_range.cols().end();
            ++i, ++index) {
         // ki is the wave number in the i direction
-        real_type ki   = real_type(i) * TAU<T> / m_domain;
+        real_type ki   = real_type(i) * TAU<T> / m_domainX;
         real_type kMag = std::hypot(ki, kj);
 
-        // By restricting to make sure kMag isn't too big, we
-        // avoid diagonal aliasing. It's very very hard to see,
-        // aesthetically, but this makes it correct.
-        if ((i == 0 && realJ == 0) /*|| ( kMag > m_maxKmag )*/) {
+        if (i == 0 && realJ == 0) {
           proc(index);
         } else {
           proc(vec_type(ki, kj), kMag, m_dK, index);
@@ -247,6 +259,87 @@ public:
   }
 };
 
+//-*****************************************************************************
+// Like SpectralIterationFunctor, but for processors with terms that only
+// depend on the magnitude of the wavenumber. The rows of j and -j have the
+// same magnitudes, column by column, so they are visited together, and the
+// processor makes those terms once per column for both, with
+//   void radial(real_type kMag, real_type dK, radial_type& o_radial);
+// which are then given to
+//   void operator()(const vec_type& k, const radial_type& radial,
+//                   real_type kMag, real_type dK, std::size_t index);
+// The wavenumbers, their magnitudes, and dK are exactly those
+// SpectralIterationFunctor gives.
+template <typename T, typename STATE, typename PROCESSOR>
+class RadialSpectralIterationFunctor {
+public:
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+  typedef typename PROCESSOR::radial_type radial_type;
+
+protected:
+  const STATE* m_state;
+  real_type m_domainX;
+  real_type m_domainY;
+  int Nx;
+  int Ny;
+
+  std::size_t m_strideJ;
+  real_type m_dK;
+
+public:
+  RadialSpectralIterationFunctor(const STATE* i_state, real_type i_domainX,
+                                 real_type i_domainY, const GridSize& i_size)
+      : m_state(i_state)
+      , m_domainX(i_domainX)
+      , m_domainY(i_domainY)
+      , Nx(i_size.Width)
+      , Ny(i_size.Height) {
+    m_strideJ = (Nx / 2) + 1;
+    m_dK      = TAU<T> / std::sqrt(m_domainX * m_domainY);
+
+    // Execute it! One task per few pairs of rows.
+    tbb::parallel_for(tbb::blocked_range<int>(0, (Ny / 2) + 1), *this);
+  }
+
+  void operator()(const tbb::blocked_range<int>& i_rows) const {
+    PROCESSOR proc(*m_state);
+    const int width = int(m_strideJ);
+    std::vector<radial_type> radials(m_strideJ);
+    std::vector<real_type> kMags(m_strideJ);
+
+    for (int j = i_rows.begin(); j != i_rows.end(); ++j) {
+      // Row j, and row Ny - j, which is -j, if it is another row.
+      const real_type kj = real_type(j) * TAU<T> / m_domainY;
+      const int negJ     = (j > 0 && (Ny - j) != j) ? (Ny - j) : -1;
+
+      for (int i = 0; i < width; ++i) {
+        const real_type ki   = real_type(i) * TAU<T> / m_domainX;
+        const real_type kMag = std::hypot(ki, kj);
+        kMags[i]             = kMag;
+        if (i == 0 && j == 0) {
+          proc(std::size_t(0));
+          continue;
+        }
+        proc.radial(kMag, m_dK, radials[i]);
+        proc(vec_type(ki, kj), radials[i], kMag, m_dK,
+             (std::size_t(j) * m_strideJ) + std::size_t(i));
+      }
+
+      if (negJ < 0) {
+        continue;
+      }
+      const real_type negKj = real_type(-j) * TAU<T> / m_domainY;
+      for (int i = 0; i < width; ++i) {
+        const real_type ki = real_type(i) * TAU<T> / m_domainX;
+        proc(vec_type(ki, negKj), radials[i], kMags[i], m_dK,
+             (std::size_t(negJ) * m_strideJ) + std::size_t(i));
+      }
+    }
+  }
+};
+
 }  // namespace EncinoWaves
 
 #endif
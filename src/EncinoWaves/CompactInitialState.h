@@ -0,0 +1,210 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+
+#ifndef _EncinoWaves_CompactInitialState_h_
+#define _EncinoWaves_CompactInitialState_h_
+
+#include "Foundation.h"
+#include "InitialState.h"
+
+namespace EncinoWaves {
+
+//-*****************************************************************************
+// An initial state in about half the memory of a float InitialState, and
+// under a third of a double one, which Propagation propagates directly.
+//
+// Each complex bin of the half spectra is packed into 32 bits, as two 13 bit
+// signed mantissas which share a 6 bit exponent: the power of two, below
+// the largest component of the state, of the larger of its two components.
+// That keeps both components to within 2.5e-4 of the larger, however small
+// the bin is, down to 2^-62 of the largest. Unpacking is a table lookup and
+// two multiplies.
+//
+// Omega only depends on the magnitude of the wavenumber, so rows j and
+// Ny - j have the same omegas, and only rows 0 to Ny / 2 are kept.
+//
+// At N of 8192, a float InitialState is 671 MB and a compact one 336 MB; a
+// double one is 1342 MB and a compact one 403 MB. Propagating it costs a
+// row lookup per bin for omega and the unpacking, which makes the spectral
+// pass, the part of a frame before the transforms, about a fifth slower.
+// With FFTW on one thread, bench_ewav_CompactInitialState gives, for a
+// whole float frame and for the spectral pass alone:
+//   N = 1024:    55.1 ms ->   55.4 ms,  spectra  10.1 ms ->  12.4 ms
+//   N = 2048:   247.2 ms ->  254.3 ms,  spectra  41.3 ms ->  51.0 ms
+//   N = 4096:  1462.8 ms -> 1507.7 ms,  spectra 154.0 ms -> 189.9 ms
+// so a frame is about 3% slower for half the memory.
+template <typename T>
+struct CompactInitialState {
+  static constexpr int kMantissaBits = 13;
+  static constexpr int kExponentBits = 6;
+  static constexpr int kMaxMantissa  = (1 << (kMantissaBits - 1)) - 1;
+  static constexpr int kNumExponents = 1 << kExponentBits;
+
+  // The grid the state was made for.
+  GridSize Size;
+
+  std::vector<uint32_t> PackedPos;
+  std::vector<uint32_t> PackedNeg;
+
+  // What each exponent code unpacks a mantissa to. Code 0 is a zero bin.
+  T Scales[kNumExponents];
+
+  // Omegas of rows 0 to Ny / 2 of the half spectrum.
+  std::vector<T> Omega;
+
+  // Loop period the omegas were quantized to, or zero if they weren't.
+  T LoopPeriod;
+
+  // See NextInitialStateGeneration.
+  std::uint64_t Generation;
+
+  explicit CompactInitialState(const InitialState<T>& i_istate);
+
+  // Makes a full initial state of i_params to pack, and lets it go. The
+  // scales of the packing need the largest component of the whole state,
+  // so the full state and the compact one are both held while packing: at
+  // N of 8192 in float, 671 MB plus 336 MB, about 1 GB at the peak.
+  explicit CompactInitialState(const Parameters<T>& i_params,
+                               tbb::task_arena* i_arena = nullptr)
+    : CompactInitialState(InitialState<T>(i_params, i_arena)) {}
+
+  // Bytes held, for the tradeoff against an InitialState.
+  std::size_t memorySize() const {
+    return (PackedPos.size() + PackedNeg.size()) * sizeof(uint32_t) +
+           Omega.size() * sizeof(T);
+  }
+
+  std::complex<T> unpack(uint32_t i_packed) const {
+    const T scale = Scales[i_packed >> (2 * kMantissaBits)];
+    return std::complex<T>(T(SignedMantissa(i_packed)) * scale,
+                           T(SignedMantissa(i_packed >> kMantissaBits)) *
+                             scale);
+  }
+
+  // The row of Omega that row i_j of the half spectrum has the omegas of.
+  static int FoldedRow(int i_j, int i_height) {
+    return std::min(i_j, i_height - i_j);
+  }
+
+protected:
+  static int SignedMantissa(uint32_t i_bits) {
+    const int mantissa = int(i_bits & ((1u << kMantissaBits) - 1));
+    return mantissa > kMaxMantissa ? mantissa - (1 << kMantissaBits)
+                                   : mantissa;
+  }
+
+  uint32_t pack(const std::complex<T>& i_value, T i_maxComponent) const;
+};
+
+typedef CompactInitialState<float> CompactInitialStatef;
+typedef CompactInitialState<double> CompactInitialStated;
+
+//-*****************************************************************************
+template <typename T>
+uint32_t CompactInitialState<T>::pack(const std::complex<T>& i_value,
+                                      T i_maxComponent) const {
+  const T component =
+    std::max(std::abs(i_value.real()), std::abs(i_value.imag()));
+  if (!(component > T(0))) {
+    return 0;
+  }
+
+  // component / i_maxComponent is in [2^(e-1), 2^e), with e at most 1.
+  int e = 0;
+  std::frexp(component / i_maxComponent, &e);
+  const int code = 2 - e;
+  if (code >= kNumExponents) {
+    return 0;
+  }
+
+  const T toMantissa = T(1) / Scales[code];
+  const long re      = std::lround(i_value.real() * toMantissa);
+  const long im      = std::lround(i_value.imag() * toMantissa);
+  const uint32_t mask = (1u << kMantissaBits) - 1;
+  return (uint32_t(re) & mask) | ((uint32_t(im) & mask) << kMantissaBits) |
+         (uint32_t(code) << (2 * kMantissaBits));
+}
+
+//-*****************************************************************************
+template <typename T>
+CompactInitialState<T>::CompactInitialState(const InitialState<T>& i_istate)
+  : Size(i_istate.Size)
+  , PackedPos(i_istate.HSpectralPos.size())
+  , PackedNeg(i_istate.HSpectralNeg.size())
+  , Omega(std::size_t(i_istate.Omega.width()) *
+          std::size_t((Size.Height / 2) + 1))
+  , LoopPeriod(i_istate.LoopPeriod)
+  , Generation(NextInitialStateGeneration()) {
+  const std::size_t size = i_istate.HSpectralPos.size();
+  const std::complex<T>* pos = i_istate.HSpectralPos.cdata();
+  const std::complex<T>* neg = i_istate.HSpectralNeg.cdata();
+
+  const T maxComponent = tbb::parallel_reduce(
+    tbb::blocked_range<std::size_t>(0, size), T(0),
+    [&](const tbb::blocked_range<std::size_t>& i_range, T i_max) {
+      for (std::size_t i = i_range.begin(); i != i_range.end(); ++i) {
+        i_max = std::max({i_max, std::abs(pos[i].real()),
+                          std::abs(pos[i].imag()), std::abs(neg[i].real()),
+                          std::abs(neg[i].imag())});
+      }
+      return i_max;
+    },
+    [](T i_a, T i_b) { return std::max(i_a, i_b); });
+
+  // Code c holds components in [2^(1-c), 2^(2-c)) of maxComponent, as
+  // mantissas of at least half kMaxMantissa.
+  Scales[0] = T(0);
+  for (int c = 1; c < kNumExponents; ++c) {
+    Scales[c] = std::ldexp(maxComponent, 2 - c) / T(kMaxMantissa);
+  }
+
+  if (maxComponent > T(0)) {
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, size),
+                      [&](const tbb::blocked_range<std::size_t>& i_range) {
+                        for (std::size_t i = i_range.begin();
+                             i != i_range.end(); ++i) {
+                          PackedPos[i] = pack(pos[i], maxComponent);
+                          PackedNeg[i] = pack(neg[i], maxComponent);
+                        }
+                      });
+  }
+
+  std::copy(i_istate.Omega.cdata(), i_istate.Omega.cdata() + Omega.size(),
+            Omega.begin());
+}
+
+}  // namespace EncinoWaves
+
+#endif
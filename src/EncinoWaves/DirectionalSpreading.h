@@ -66,12 +66,19 @@ T swell(T theta, T omega, T modal_omega, T swell_amount) {
 }
 
 //------------------------------------------------------------------------------
+// The integral of the product of A and B over the directions, which
+// normalizes it. Only depends on the frequency, not the direction.
 template <typename T, typename FUNCA, typename FUNCB>
-T normalizedSwellDirectionalProduct(T theta, FUNCA A, FUNCB B) {
+T swellDirectionalNormalization(FUNCA A, FUNCB B) {
   auto product = [A, B](T x) -> T { return A(x) * B(x); };
+  return numericallyIntegrate(product, -PI<T> / 2, PI<T> / 2, 36);
+}
 
-  T denom = numericallyIntegrate(product, -PI<T> / 2, PI<T> / 2, 36);
-  return product(theta) / denom;
+//------------------------------------------------------------------------------
+template <typename T, typename FUNCA, typename FUNCB>
+T normalizedSwellDirectionalProduct(T theta, FUNCA A, FUNCB B) {
+  T denom = swellDirectionalNormalization<T>(A, B);
+  return (A(theta) * B(theta)) / denom;
 }
 
 //------------------------------------------------------------------------------
@@ -91,7 +98,15 @@ public:
           params.gravity, params.windSpeed, params.fetch))
       , m_swell(params.directionalSpreading.swell) {}
 
-  T operator()(T i_omega, T i_theta, T i_kMag, T i_dTheta) const {
+  // The part of the spreading that only depends on the frequency: the
+  // width of the lobe, and its normalization.
+  struct Radial {
+    T Omega;
+    T BetaS;
+    T Normalization;
+  };
+
+  Radial radial(T i_omega, T i_kMag, T i_dTheta) const {
     T omega_over_modal_omega = i_omega / m_modalAngularFrequency;
     T beta_s;
     if (omega_over_modal_omega < 0.95) {
@@ -105,29 +120,52 @@ public:
       beta_s = std::pow(10, expo);
     }
 
-    // Make a hyperbolic secant function
-    static auto sech = [](T x) { return 1.0 / std::cosh(x); };
+    Radial r;
+    r.Omega = i_omega;
+    r.BetaS = beta_s;
 
     // We need to do a numerical integration to determine the
     // normalization factor for the product of the original function (B)
     // with the swell elongation (A).
-    auto A = [this, i_omega](T x) -> T {
-      return swell(x, i_omega, m_modalAngularFrequency, m_swell);
-    };
-    auto B = [beta_s](T x) -> T { return sqr(sech(beta_s * x)); };
-
     if (m_swell >= 0.0) {
-      return normalizedSwellDirectionalProduct(i_theta, A, B);
+      r.Normalization = swellDirectionalNormalization<T>(swellFunc(i_omega),
+                                                         lobeFunc(beta_s));
     } else {
-      T integral =
+      r.Normalization =
         (std::tanh(beta_s * PI<T>) - std::tanh(-beta_s * PI<T>)) / beta_s;
-      T d = B(i_theta) / integral;
+    }
+    return r;
+  }
+
+  T operator()(const Radial& i_radial, T i_theta) const {
+    auto A = swellFunc(i_radial.Omega);
+    auto B = lobeFunc(i_radial.BetaS);
+    if (m_swell >= 0.0) {
+      return (A(i_theta) * B(i_theta)) / i_radial.Normalization;
+    } else {
+      T d = B(i_theta) / i_radial.Normalization;
       return Imath::lerp(d, static_cast<T>(-1.0 / (2.0 * PI<T>)),
                          Imath::clamp(-m_swell, T(0), T(1)));
     }
   }
 
+  T operator()(T i_omega, T i_theta, T i_kMag, T i_dTheta) const {
+    return (*this)(radial(i_omega, i_kMag, i_dTheta), i_theta);
+  }
+
 protected:
+  // The swell elongation.
+  auto swellFunc(T i_omega) const {
+    return [this, i_omega](T x) -> T {
+      return swell(x, i_omega, m_modalAngularFrequency, m_swell);
+    };
+  }
+
+  // The original function, a squared hyperbolic secant.
+  static auto lobeFunc(T i_betaS) {
+    return [i_betaS](T x) -> T { return sqr(1.0 / std::cosh(i_betaS * x)); };
+  }
+
   T m_modalAngularFrequency;
   T m_swell;
 };
@@ -146,7 +184,14 @@ public:
       , m_windSpeedOverCelerity(params.windSpeed / m_modalCelerity)
       , m_swell(params.directionalSpreading.swell) {}
 
-  T operator()(T i_omega, T i_theta, T i_kMag, T i_dTheta) const {
+  // The part of the spreading that only depends on the frequency: the
+  // shape, and the normalization of the cosine power.
+  struct Radial {
+    T Shape;
+    T Normalization;
+  };
+
+  Radial radial(T i_omega, T i_kMag, T i_dTheta) const {
     T shape_bias = 0.0;
     if (m_swell >= 0.0) {
       shape_bias = swellShape(i_omega, m_modalAngularFrequency, m_swell);
@@ -161,15 +206,28 @@ public:
     T factor_A = std::pow(2.0, (2.0 * shape) - 1.0) / PI<T>;
     T factor_B =
       sqr(std::tgamma(shape + 1.0)) / std::tgamma((2.0 * shape) + 1.0);
-    T factor_C = std::pow(std::abs(std::cos(i_theta / 2.0)), 2.0 * shape);
+
+    Radial r;
+    r.Shape         = shape;
+    r.Normalization = factor_A * factor_B;
+    return r;
+  }
+
+  T operator()(const Radial& i_radial, T i_theta) const {
+    T factor_C =
+      std::pow(std::abs(std::cos(i_theta / 2.0)), 2.0 * i_radial.Shape);
     if (m_swell < 0) {
-      return Imath::lerp(factor_A * factor_B * factor_C, T(1) / T(TAU<T>),
+      return Imath::lerp(i_radial.Normalization * factor_C, T(1) / T(TAU<T>),
                          Imath::clamp(-m_swell, T(0), T(1)));
     } else {
-      return factor_A * factor_B * factor_C;
+      return i_radial.Normalization * factor_C;
     }
   }
 
+  T operator()(T i_omega, T i_theta, T i_kMag, T i_dTheta) const {
+    return (*this)(radial(i_omega, i_kMag, i_dTheta), i_theta);
+  }
+
 protected:
   T m_modalAngularFrequency;
   T m_modalShape;
@@ -192,7 +250,14 @@ public:
       , m_windSpeedOverCelerity(params.windSpeed / m_modalCelerity)
       , m_swell(params.directionalSpreading.swell) {}
 
-  T operator()(T i_omega, T i_theta, T i_kMag, T i_dTheta) const {
+  // The part of the spreading that only depends on the frequency: the
+  // shape, and the normalization of the cosine power.
+  struct Radial {
+    T Shape;
+    T Normalization;
+  };
+
+  Radial radial(T i_omega, T i_kMag, T i_dTheta) const {
     T shape_bias = 0.0;
     if (m_swell >= 0.0) {
       shape_bias = swellShape(i_omega, m_modalAngularFrequency, m_swell);
@@ -211,15 +276,28 @@ public:
     T factor_A = std::pow(2.0, (2.0 * shape) - 1.0) / PI<T>;
     T factor_B =
       sqr(std::tgamma(shape + 1.0)) / std::tgamma((2.0 * shape) + 1.0);
-    T factor_C = std::pow(std::abs(std::cos(i_theta / 2.0)), 2.0 * shape);
+
+    Radial r;
+    r.Shape         = shape;
+    r.Normalization = factor_A * factor_B;
+    return r;
+  }
+
+  T operator()(const Radial& i_radial, T i_theta) const {
+    T factor_C =
+      std::pow(std::abs(std::cos(i_theta / 2.0)), 2.0 * i_radial.Shape);
     if (m_swell < 0) {
-      return Imath::lerp(factor_A * factor_B * factor_C, T(1) / T(TAU<T>),
+      return Imath::lerp(i_radial.Normalization * factor_C, T(1) / T(TAU<T>),
                          Imath::clamp(-m_swell, T(0), T(1)));
     } else {
-      return factor_A * factor_B * factor_C;
+      return i_radial.Normalization * factor_C;
     }
   }
 
+  T operator()(T i_omega, T i_theta, T i_kMag, T i_dTheta) const {
+    return (*this)(radial(i_omega, i_kMag, i_dTheta), i_theta);
+  }
+
 protected:
   T m_modalAngularFrequency;
   T m_modalShape;
@@ -245,22 +323,47 @@ public:
           params.gravity, params.windSpeed, params.fetch))
       , m_swell(params.directionalSpreading.swell) {}
 
+  // The part of the spreading that only depends on the frequency, the
+  // normalization of the swell elongated lobe.
+  struct Radial {
+    T Omega;
+    T Normalization;
+  };
+
+  Radial radial(T i_omega, T i_kMag, T i_dTheta) const {
+    Radial r;
+    r.Omega         = i_omega;
+    r.Normalization = swellDirectionalNormalization<T>(swellFunc(i_omega),
+                                                       &lobe);
+    return r;
+  }
+
+  T operator()(const Radial& i_radial, T i_theta) const {
+    return (swellFunc(i_radial.Omega)(i_theta) * lobe(i_theta)) /
+           i_radial.Normalization;
+  }
+
   T operator()(T i_omega, T i_theta, T i_kMag, T i_dTheta) const {
-    auto A = [this, i_omega](T x) -> T {
+    return (*this)(radial(i_omega, i_kMag, i_dTheta), i_theta);
+  }
+
+protected:
+  // The swell elongation.
+  auto swellFunc(T i_omega) const {
+    return [this, i_omega](T x) -> T {
       return swell(x, i_omega, m_modalAngularFrequency, m_swell);
     };
-    auto B = [](T x) -> T {
-      if (x < -PI_2<T> || x > PI_2<T>) {
-        return T{0};
-      } else {
-        return sqr(std::cos(x));
-      }
-    };
+  }
 
-    return normalizedSwellDirectionalProduct(i_theta, A, B);
+  // The original function, a squared cosine over the forward directions.
+  static T lobe(T x) {
+    if (x < -PI_2<T> || x > PI_2<T>) {
+      return T{0};
+    } else {
+      return sqr(std::cos(x));
+    }
   }
 
-protected:
   T m_modalAngularFrequency;
   T m_swell;
 };
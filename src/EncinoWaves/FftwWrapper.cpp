@@ -45,5 +45,9 @@ std::unique_ptr< __BaseFftwInitThreadsT<float>::Init >
 std::unique_ptr< __BaseFftwInitThreadsT<double>::Init >
     __BaseFftwInitThreadsT<double>::sm_init;
 
+//-*****************************************************************************
+tbb::mutex g_fftwPlannerMutex;
+tbb::mutex g_fftwPlanCacheMutex;
+
 } // namespace EncinoWaves
 
@@ -54,6 +54,9 @@ struct FftwWrapperT<float>
     typedef std::complex<float> complex_type;
     typedef fftwf_plan          plan_type;
     typedef fftwf_iodim         iodim_type;
+    typedef void ( *parallel_loop_type )( void* ( *i_work )( char* ),
+                                          char* i_jobData, size_t i_elemSize,
+                                          int i_numJobs, void* i_data );
 
     // Init threads. Only call once at the very begining.
     static int init_threads( void )
@@ -63,6 +66,14 @@ struct FftwWrapperT<float>
     static void plan_with_nthreads( int i_nthreads )
     { fftwf_plan_with_nthreads( i_nthreads ); }
 
+#ifdef EWAV_FFTW_TBB_THREADS
+    // Run the parallel loops of subsequently made plans through a callback,
+    // instead of FFTW's own threads. Requires FFTW 3.3.9 or later.
+    static void threads_set_callback( parallel_loop_type i_parallelLoop,
+                                      void* i_data )
+    { fftwf_threads_set_callback( i_parallelLoop, i_data ); }
+#endif
+
     // Create a complex-to-real, 2d plan.
     static plan_type plan_dft_c2r_2d( int i_width, int i_height,
                                       complex_type* i_in, real_type* o_out,
@@ -123,6 +134,69 @@ struct FftwWrapperT<float>
             reinterpret_cast<fftwf_complex*>( i_in ), o_out, i_flags );
     }
 
+    // Use the guru interface to transform i_howmany fields at once, each
+    // with a padded output. The fields are i_inDist complex values apart
+    // in the input and i_outDist real values apart in the output.
+    static plan_type plan_guru_dft_c2r_output_padded_many(
+        int i_width, int i_height, int i_widthPad, int i_heightPad,
+        int i_howmany, size_t i_inDist, size_t i_outDist,
+        complex_type* i_in, real_type* o_out, unsigned int i_flags )
+    {
+        int rank = 2;
+        iodim_type dims[2];
+        dims[0].n = i_height;
+        dims[0].is = (i_width/2)+1;
+        dims[0].os = i_width+i_widthPad;
+
+        dims[1].n = i_width;
+        dims[1].is = 1;
+        dims[1].os = 1;
+
+        int howmany = 1;
+        iodim_type howmanydims[1];
+        howmanydims[0].n = i_howmany;
+        howmanydims[0].is = static_cast<int>( i_inDist );
+        howmanydims[0].os = static_cast<int>( i_outDist );
+
+        return fftwf_plan_guru_dft_c2r(
+            rank, dims, howmany, howmanydims,
+            reinterpret_cast<fftwf_complex*>( i_in ), o_out, i_flags );
+    }
+
+    // Use the guru split-array interface to make a backward complex-to-complex
+    // transform of i_howmany fields at once, each with a padded output. Real
+    // and imaginary parts live in separate arrays, so the two halves of each
+    // output can land directly in two different real fields. FFTW's split
+    // plans are always forward; a backward transform is the forward transform
+    // with the real and imaginary parts swapped on input and output, which is
+    // done here and in execute_split_dft_backward so callers needn't know.
+    static plan_type plan_guru_split_dft_backward_output_padded_many(
+        int i_width, int i_height, int i_widthPad, int i_heightPad,
+        int i_howmany, size_t i_inDist, size_t i_outDist,
+        real_type* i_re, real_type* i_im,
+        real_type* o_re, real_type* o_im, unsigned int i_flags )
+    {
+        int rank = 2;
+        iodim_type dims[2];
+        dims[0].n = i_height;
+        dims[0].is = i_width;
+        dims[0].os = i_width+i_widthPad;
+
+        dims[1].n = i_width;
+        dims[1].is = 1;
+        dims[1].os = 1;
+
+        int howmany = 1;
+        iodim_type howmanydims[1];
+        howmanydims[0].n = i_howmany;
+        howmanydims[0].is = static_cast<int>( i_inDist );
+        howmanydims[0].os = static_cast<int>( i_outDist );
+
+        return fftwf_plan_guru_split_dft(
+            rank, dims, howmany, howmanydims,
+            i_im, i_re, o_im, o_re, i_flags );
+    }
+
     // Malloc some data. Capitalized to make very sure it isn't
     // confused with system malloc.
     static void* Malloc( size_t i_size )
@@ -144,6 +218,17 @@ struct FftwWrapperT<float>
                              reinterpret_cast<fftwf_complex*>( i_in ),
                              o_out ); }
 
+    // Execute a backward split plan on other data.
+    static void execute_split_dft_backward( const plan_type i_plan,
+                                            real_type* i_re, real_type* i_im,
+                                            real_type* o_re, real_type* o_im )
+    { fftwf_execute_split_dft( i_plan, i_im, i_re, o_im, o_re ); }
+
+    // The SIMD alignment class of an array. A plan can only be executed
+    // on new arrays with the same alignment as the ones it was made for.
+    static int alignment_of( real_type* i_data )
+    { return fftwf_alignment_of( i_data ); }
+
     // Destroy a plan.
     static void destroy_plan( const plan_type i_plan )
     { fftwf_destroy_plan( i_plan ); }
@@ -155,6 +240,19 @@ struct FftwWrapperT<float>
     // Cleanup.
     static void cleanup( void )
     { fftwf_cleanup(); }
+
+    // Merge wisdom from a file into the global wisdom. Returns non-zero
+    // on success.
+    static int import_wisdom_from_filename( const char* i_filename )
+    { return fftwf_import_wisdom_from_filename( i_filename ); }
+
+    // Write all accumulated wisdom to a file. Returns non-zero on success.
+    static int export_wisdom_to_filename( const char* i_filename )
+    { return fftwf_export_wisdom_to_filename( i_filename ); }
+
+    // Discard all accumulated wisdom.
+    static void forget_wisdom( void )
+    { fftwf_forget_wisdom(); }
 };
 
 //-*****************************************************************************
@@ -167,6 +265,9 @@ struct FftwWrapperT<double>
     typedef std::complex<double>    complex_type;
     typedef fftw_plan               plan_type;
     typedef fftw_iodim              iodim_type;
+    typedef void ( *parallel_loop_type )( void* ( *i_work )( char* ),
+                                          char* i_jobData, size_t i_elemSize,
+                                          int i_numJobs, void* i_data );
 
     // Init threads. Only call once at the very begining.
     static int init_threads( void )
@@ -176,6 +277,14 @@ struct FftwWrapperT<double>
     static void plan_with_nthreads( int i_nthreads )
     { fftw_plan_with_nthreads( i_nthreads ); }
 
+#ifdef EWAV_FFTW_TBB_THREADS
+    // Run the parallel loops of subsequently made plans through a callback,
+    // instead of FFTW's own threads. Requires FFTW 3.3.9 or later.
+    static void threads_set_callback( parallel_loop_type i_parallelLoop,
+                                      void* i_data )
+    { fftw_threads_set_callback( i_parallelLoop, i_data ); }
+#endif
+
     // Create a complex-to-real, 2d plan.
     static plan_type plan_dft_c2r_2d( int i_width, int i_height,
                                       complex_type* i_in, real_type* o_out,
@@ -236,6 +345,69 @@ struct FftwWrapperT<double>
             reinterpret_cast<fftw_complex*>( i_in ), o_out, i_flags );
     }
 
+    // Use the guru interface to transform i_howmany fields at once, each
+    // with a padded output. The fields are i_inDist complex values apart
+    // in the input and i_outDist real values apart in the output.
+    static plan_type plan_guru_dft_c2r_output_padded_many(
+        int i_width, int i_height, int i_widthPad, int i_heightPad,
+        int i_howmany, size_t i_inDist, size_t i_outDist,
+        complex_type* i_in, real_type* o_out, unsigned int i_flags )
+    {
+        int rank = 2;
+        iodim_type dims[2];
+        dims[0].n = i_height;
+        dims[0].is = (i_width/2)+1;
+        dims[0].os = i_width+i_widthPad;
+
+        dims[1].n = i_width;
+        dims[1].is = 1;
+        dims[1].os = 1;
+
+        int howmany = 1;
+        iodim_type howmanydims[1];
+        howmanydims[0].n = i_howmany;
+        howmanydims[0].is = static_cast<int>( i_inDist );
+        howmanydims[0].os = static_cast<int>( i_outDist );
+
+        return fftw_plan_guru_dft_c2r(
+            rank, dims, howmany, howmanydims,
+            reinterpret_cast<fftw_complex*>( i_in ), o_out, i_flags );
+    }
+
+    // Use the guru split-array interface to make a backward complex-to-complex
+    // transform of i_howmany fields at once, each with a padded output. Real
+    // and imaginary parts live in separate arrays, so the two halves of each
+    // output can land directly in two different real fields. FFTW's split
+    // plans are always forward; a backward transform is the forward transform
+    // with the real and imaginary parts swapped on input and output, which is
+    // done here and in execute_split_dft_backward so callers needn't know.
+    static plan_type plan_guru_split_dft_backward_output_padded_many(
+        int i_width, int i_height, int i_widthPad, int i_heightPad,
+        int i_howmany, size_t i_inDist, size_t i_outDist,
+        real_type* i_re, real_type* i_im,
+        real_type* o_re, real_type* o_im, unsigned int i_flags )
+    {
+        int rank = 2;
+        iodim_type dims[2];
+        dims[0].n = i_height;
+        dims[0].is = i_width;
+        dims[0].os = i_width+i_widthPad;
+
+        dims[1].n = i_width;
+        dims[1].is = 1;
+        dims[1].os = 1;
+
+        int howmany = 1;
+        iodim_type howmanydims[1];
+        howmanydims[0].n = i_howmany;
+        howmanydims[0].is = static_cast<int>( i_inDist );
+        howmanydims[0].os = static_cast<int>( i_outDist );
+
+        return fftw_plan_guru_split_dft(
+            rank, dims, howmany, howmanydims,
+            i_im, i_re, o_im, o_re, i_flags );
+    }
+
     // Malloc some data. Capitalized to make very sure it isn't
     // confused with system malloc.
     static void* Malloc( size_t i_size )
@@ -257,6 +429,17 @@ struct FftwWrapperT<double>
                             reinterpret_cast<fftw_complex*>( i_in ),
                             o_out ); }
 
+    // Execute a backward split plan on other data.
+    static void execute_split_dft_backward( const plan_type i_plan,
+                                            real_type* i_re, real_type* i_im,
+                                            real_type* o_re, real_type* o_im )
+    { fftw_execute_split_dft( i_plan, i_im, i_re, o_im, o_re ); }
+
+    // The SIMD alignment class of an array. A plan can only be executed
+    // on new arrays with the same alignment as the ones it was made for.
+    static int alignment_of( real_type* i_data )
+    { return fftw_alignment_of( i_data ); }
+
     // Destroy a plan.
     static void destroy_plan( const plan_type i_plan )
     { fftw_destroy_plan( i_plan ); }
@@ -268,6 +451,19 @@ struct FftwWrapperT<double>
     // Cleanup.
     static void cleanup( void )
     { fftw_cleanup(); }
+
+    // Merge wisdom from a file into the global wisdom. Returns non-zero
+    // on success.
+    static int import_wisdom_from_filename( const char* i_filename )
+    { return fftw_import_wisdom_from_filename( i_filename ); }
+
+    // Write all accumulated wisdom to a file. Returns non-zero on success.
+    static int export_wisdom_to_filename( const char* i_filename )
+    { return fftw_export_wisdom_to_filename( i_filename ); }
+
+    // Discard all accumulated wisdom.
+    static void forget_wisdom( void )
+    { fftw_forget_wisdom(); }
 };
 
 //-*****************************************************************************
@@ -276,6 +472,26 @@ struct FftwWrapperT<double>
 //-*****************************************************************************
 //-*****************************************************************************
 
+#ifdef EWAV_FFTW_TBB_THREADS
+// FFTW's parallel loop, run on the TBB scheduler, so that the transforms
+// share the worker threads (and any task_arena limits) of every other
+// stage instead of starting a pool of their own. Each job is a separate
+// task; FFTW already sizes them from the plan's thread count.
+inline void FftwTbbParallelLoop( void* ( *i_work )( char* ), char* i_jobData,
+                                 size_t i_elemSize, int i_numJobs,
+                                 void* /*i_data*/ )
+{
+    tbb::parallel_for( tbb::blocked_range<int>( 0, i_numJobs, 1 ),
+                       [=]( const tbb::blocked_range<int>& i_range )
+    {
+        for ( int j = i_range.begin(); j != i_range.end(); ++j )
+        {
+            i_work( i_jobData + ( i_elemSize * size_t( j ) ) );
+        }
+    } );
+}
+#endif
+
 template <typename T>
 struct FftwInitThreadsT_InitHelper
 {
@@ -285,6 +501,9 @@ struct FftwInitThreadsT_InitHelper
     {
         int err = FFT::init_threads();
         EWAV_ASSERT( err != 0, "FFTW thread init error." );
+#ifdef EWAV_FFTW_TBB_THREADS
+        FFT::threads_set_callback( &FftwTbbParallelLoop, nullptr );
+#endif
     }
     ~FftwInitThreadsT_InitHelper() { FFT::cleanup_threads(); }
 };
@@ -316,6 +535,382 @@ inline void FftwInitThreadsT()
     { Base::sm_init.reset( new typename Base::Init ); }
 };
 
+//-*****************************************************************************
+//-*****************************************************************************
+// PLANNER RIGOR AND WISDOM
+//-*****************************************************************************
+//-*****************************************************************************
+
+// How hard FFTW searches for a fast plan. Anything above estimate runs
+// candidate transforms, which can take seconds at large resolutions, so it
+// is normally paired with a wisdom directory to pay that cost only once.
+enum FftPlannerRigor
+{
+    kEstimatePlannerRigor,
+    kMeasurePlannerRigor,
+    kPatientPlannerRigor,
+    kExhaustivePlannerRigor
+};
+
+//-*****************************************************************************
+inline unsigned int FftPlannerRigorFlags( FftPlannerRigor i_rigor )
+{
+    switch ( i_rigor )
+    {
+    case kMeasurePlannerRigor: return FFTW_MEASURE;
+    case kPatientPlannerRigor: return FFTW_PATIENT;
+    case kExhaustivePlannerRigor: return FFTW_EXHAUSTIVE;
+    default: return FFTW_ESTIMATE;
+    }
+}
+
+//-*****************************************************************************
+// How the converters make their plans. With the default, estimate rigor,
+// plans are made immediately and no wisdom is read or written.
+//
+// With any other rigor, wisdom is imported from a file in wisdomDirectory
+// keyed by grid size, precision and thread count, and the plan is only
+// made if that wisdom covers it. Otherwise, if planWithoutWisdom is set,
+// the plan is measured at the requested rigor and the file is rewritten,
+// with a warning if it can't be, and if not, the plan falls back to
+// estimate rigor. Measuring overwrites the arrays being planned on, so
+// only enable planWithoutWisdom when the fields are filled after the
+// converter is made.
+struct FftPlanOptions
+{
+    FftPlannerRigor rigor;
+    std::string wisdomDirectory;
+    bool planWithoutWisdom;
+
+    FftPlanOptions()
+      : rigor( kEstimatePlannerRigor )
+      , planWithoutWisdom( false ) {}
+};
+
+//-*****************************************************************************
+// FFTW's planner, its thread settings and its wisdom are all process-wide
+// and not thread safe, so all planning goes through this mutex.
+extern tbb::mutex g_fftwPlannerMutex;
+
+//-*****************************************************************************
+template <typename T>
+struct FftwWisdomT
+{
+    typedef FftwWrapperT<T> FFT;
+
+    // The wisdom file for a given grid size and thread count. Wisdom is
+    // only valid for the precision, and really only the machine, that made
+    // it, so files are kept per precision and are not meant to be shared.
+    static std::string Filename( const std::string& i_directory,
+                                 int i_width, int i_height, int i_numThreads )
+    {
+        std::ostringstream sstr;
+        if ( !i_directory.empty() ) { sstr << i_directory << "/"; }
+        sstr << "ewav_wisdom_"
+             << ( std::is_same<T, float>::value ? "f" : "d" )
+             << "_" << i_width << "x" << i_height << "_" << i_numThreads
+             << ".fftw";
+        return sstr.str();
+    }
+
+    // Imports a wisdom file, once. Returns whether the file has been
+    // imported. Call with g_fftwPlannerMutex held.
+    static bool Import( const std::string& i_filename )
+    {
+        std::set<std::string>& imported = Imported();
+        if ( imported.count( i_filename ) > 0 ) { return true; }
+        if ( FFT::import_wisdom_from_filename( i_filename.c_str() ) == 0 )
+        { return false; }
+        imported.insert( i_filename );
+        return true;
+    }
+
+    // Exports all wisdom to a file. Call with g_fftwPlannerMutex held.
+    static bool Export( const std::string& i_filename )
+    {
+        if ( FFT::export_wisdom_to_filename( i_filename.c_str() ) == 0 )
+        { return false; }
+        Imported().insert( i_filename );
+        return true;
+    }
+
+    // Discards all wisdom, so that files will be imported again.
+    static void Forget()
+    {
+        tbb::mutex::scoped_lock lock( g_fftwPlannerMutex );
+        FFT::forget_wisdom();
+        Imported().clear();
+    }
+
+protected:
+    static std::set<std::string>& Imported()
+    {
+        static std::set<std::string> imported;
+        return imported;
+    }
+};
+
+//-*****************************************************************************
+// Makes a plan for an i_width by i_height transform on i_numThreads threads,
+// following the plan options. i_makePlan is called with the complete planner
+// flags, which will include i_flags, and returns the plan, or null if none
+// could be made.
+template <typename T, typename MAKE_PLAN>
+typename FftwWrapperT<T>::plan_type
+FftwPlanT( int i_width, int i_height, int i_numThreads,
+           const FftPlanOptions& i_options, unsigned int i_flags,
+           MAKE_PLAN i_makePlan )
+{
+    typedef FftwWrapperT<T> FFT;
+    typedef FftwWisdomT<T> Wisdom;
+    typedef typename FFT::plan_type plan_type;
+
+    tbb::mutex::scoped_lock lock( g_fftwPlannerMutex );
+
+    // The thread count is sticky, so always set it.
+    FftwInitThreadsT<T>();
+    FFT::plan_with_nthreads( std::max( i_numThreads, 1 ) );
+
+    plan_type plan = nullptr;
+    if ( i_options.rigor != kEstimatePlannerRigor )
+    {
+        const unsigned int rigorFlags =
+            i_flags | FftPlannerRigorFlags( i_options.rigor );
+        std::string filename;
+        if ( !i_options.wisdomDirectory.empty() )
+        {
+            filename = Wisdom::Filename( i_options.wisdomDirectory, i_width,
+                                         i_height, i_numThreads );
+            Wisdom::Import( filename );
+        }
+
+        plan = i_makePlan( rigorFlags | FFTW_WISDOM_ONLY );
+        if ( !plan && i_options.planWithoutWisdom )
+        {
+            plan = i_makePlan( rigorFlags );
+            // The plan is good whether or not its wisdom can be saved, so
+            // an unwritable wisdom directory only costs the next process
+            // its planning time.
+            if ( plan && !filename.empty() && !Wisdom::Export( filename ) )
+            {
+                std::cerr << "WARNING: Could not write FFTW wisdom to: "
+                          << filename << std::endl;
+            }
+        }
+    }
+
+    if ( !plan )
+    {
+        plan = i_makePlan( i_flags | FFTW_ESTIMATE );
+    }
+    EWAV_ASSERT( plan, "Could not make FFTW plan." );
+    return plan;
+}
+
+//-*****************************************************************************
+//-*****************************************************************************
+// PLAN CACHE
+//-*****************************************************************************
+//-*****************************************************************************
+
+// The kinds of plans the wrappers above make.
+enum FftwPlanKind
+{
+    kC2RPlanKind,
+    kPaddedC2RPlanKind,
+    kPaddedC2RManyPlanKind,
+    kSplitBackwardPaddedManyPlanKind
+};
+
+//-*****************************************************************************
+// Everything that makes two plans interchangeable. Plans are only ever
+// executed with the new-array execute functions, which require the same
+// geometry, the same alignment, and for split arrays, the same distance
+// between the real and imaginary parts. Unused values are left at zero.
+struct FftwPlanKey
+{
+    FftwPlanKind kind;
+    int width;
+    int height;
+    int widthPad;
+    int heightPad;
+    int howmany;
+    size_t inDist;
+    size_t outDist;
+    ptrdiff_t inSplit;
+    ptrdiff_t outSplit;
+    int inAlignment;
+    int outAlignment;
+    int numThreads;
+    unsigned int flags;
+    FftPlannerRigor rigor;
+
+    FftwPlanKey()
+      : kind( kC2RPlanKind )
+      , width( 0 ), height( 0 ), widthPad( 0 ), heightPad( 0 ), howmany( 0 )
+      , inDist( 0 ), outDist( 0 ), inSplit( 0 ), outSplit( 0 )
+      , inAlignment( 0 ), outAlignment( 0 ), numThreads( 0 ), flags( 0 )
+      , rigor( kEstimatePlannerRigor ) {}
+
+    bool operator<( const FftwPlanKey& i_rhs ) const
+    {
+        return std::tie( kind, width, height, widthPad, heightPad, howmany,
+                         inDist, outDist, inSplit, outSplit, inAlignment,
+                         outAlignment, numThreads, flags, rigor ) <
+            std::tie( i_rhs.kind, i_rhs.width, i_rhs.height, i_rhs.widthPad,
+                      i_rhs.heightPad, i_rhs.howmany, i_rhs.inDist,
+                      i_rhs.outDist, i_rhs.inSplit, i_rhs.outSplit,
+                      i_rhs.inAlignment, i_rhs.outAlignment,
+                      i_rhs.numThreads, i_rhs.flags, i_rhs.rigor );
+    }
+};
+
+//-*****************************************************************************
+// Guards the plan caches of both precisions. Taken before, never while
+// holding, g_fftwPlannerMutex, and not held while planning.
+extern tbb::mutex g_fftwPlanCacheMutex;
+
+//-*****************************************************************************
+// A process-wide cache of plans, so that converters of the same geometry,
+// whether alive at the same time or made one after another, share a single
+// plan instead of each planning its own. The new-array execute functions
+// are thread safe, so a shared plan can be executed concurrently.
+//
+// Plans are counted by their users, and kept when the count drops to zero,
+// so rebuilding a converter doesn't replan. Clear destroys the unused ones.
+// A plan is cached under the rigor it was asked for, so a plan that fell
+// back to estimate for lack of wisdom stays that way until it is cleared.
+//
+// Measured plans can take minutes, so the cache isn't locked while one is
+// being made. Its entry is marked pending instead, and only acquirers of
+// the same key wait for it.
+template <typename T>
+class FftwPlanCacheT
+{
+public:
+    typedef FftwWrapperT<T> FFT;
+    typedef typename FFT::plan_type plan_type;
+
+    // Returns the plan for the key, making it with i_makePlan and the
+    // options if it isn't already cached. Must be paired with Release.
+    template <typename MAKE_PLAN>
+    static plan_type Acquire( const FftwPlanKey& i_key,
+                              const FftPlanOptions& i_options,
+                              MAKE_PLAN i_makePlan )
+    {
+        EWAV_ASSERT( i_key.rigor == i_options.rigor,
+                     "Plan key and options disagree on rigor." );
+        std::unique_lock<tbb::mutex> lock( g_fftwPlanCacheMutex );
+        EntryMap& entries = Entries();
+        for ( ;; )
+        {
+            typename EntryMap::iterator iter = entries.find( i_key );
+            if ( iter == entries.end() )
+            {
+                // Plan it ourselves. The pending entry has us as its user,
+                // so Clear won't erase it while the cache is unlocked.
+                iter = entries.insert( std::make_pair( i_key, Entry() ) )
+                    .first;
+                iter->second.pending = true;
+                iter->second.users = 1;
+                lock.unlock();
+
+                plan_type plan = nullptr;
+                try
+                {
+                    plan = FftwPlanT<T>( i_key.width, i_key.height,
+                                         i_key.numThreads, i_options,
+                                         i_key.flags, i_makePlan );
+                }
+                catch ( ... )
+                {
+                    lock.lock();
+                    entries.erase( iter );
+                    Planned().notify_all();
+                    throw;
+                }
+
+                lock.lock();
+                iter->second.plan = plan;
+                iter->second.pending = false;
+                Planned().notify_all();
+                return plan;
+            }
+            if ( !iter->second.pending )
+            {
+                ++iter->second.users;
+                return iter->second.plan;
+            }
+
+            // Another thread is planning this key. Look again once it's
+            // done, since the entry is gone if its planning failed.
+            Planned().wait( lock );
+        }
+    }
+
+    static void Release( const FftwPlanKey& i_key )
+    {
+        tbb::mutex::scoped_lock lock( g_fftwPlanCacheMutex );
+        typename EntryMap::iterator iter = Entries().find( i_key );
+        EWAV_ASSERT( iter != Entries().end() && iter->second.users > 0,
+                     "Releasing a plan that was never acquired." );
+        --iter->second.users;
+    }
+
+    // Number of cached plans, used or not.
+    static std::size_t Size()
+    {
+        tbb::mutex::scoped_lock lock( g_fftwPlanCacheMutex );
+        return Entries().size();
+    }
+
+    // Destroys every plan that currently has no users.
+    static void Clear()
+    {
+        tbb::mutex::scoped_lock lock( g_fftwPlanCacheMutex );
+        tbb::mutex::scoped_lock plannerLock( g_fftwPlannerMutex );
+        EntryMap& entries = Entries();
+        for ( typename EntryMap::iterator iter = entries.begin();
+              iter != entries.end(); )
+        {
+            if ( iter->second.users == 0 )
+            {
+                FFT::destroy_plan( iter->second.plan );
+                iter = entries.erase( iter );
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+protected:
+    struct Entry
+    {
+        plan_type plan;
+        int users;
+        bool pending;
+        Entry() : plan( nullptr ), users( 0 ), pending( false ) {}
+    };
+    typedef std::map<FftwPlanKey, Entry> EntryMap;
+
+    // Never destroyed, since plans can't outlive FFTW's own cleanup.
+    static EntryMap& Entries()
+    {
+        static EntryMap* entries = new EntryMap;
+        return *entries;
+    }
+
+    // Signalled, under g_fftwPlanCacheMutex, when a pending plan is done.
+    static std::condition_variable_any& Planned()
+    {
+        static std::condition_variable_any* planned =
+            new std::condition_variable_any;
+        return *planned;
+    }
+};
+
 } // namespace EncinoWaves
 
 #endif
@@ -34,9 +34,131 @@
 
 #include "Foundation.h"
 
+#ifdef PLATFORM_LINUX
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace EncinoWaves {
 
 //-*****************************************************************************
 tbb::mutex g_printMutex;
 
+//-*****************************************************************************
+static std::atomic<int> g_fieldAllocation(kParallelFieldAllocation);
+
+void SetFieldAllocation(FieldAllocation i_allocation) {
+  g_fieldAllocation.store(int(i_allocation), std::memory_order_relaxed);
+}
+
+FieldAllocation GetFieldAllocation() {
+  return FieldAllocation(g_fieldAllocation.load(std::memory_order_relaxed));
+}
+
+//-*****************************************************************************
+// Straight to the system calls, so as not to need libnuma. The policy only
+// covers whole pages, so the partial pages at either end keep the default.
+bool InterleavePages(void* i_data, std::size_t i_bytes) {
+#ifdef PLATFORM_LINUX
+  static const std::size_t pageSize = std::size_t(sysconf(_SC_PAGESIZE));
+  const std::size_t begin =
+    ((reinterpret_cast<std::size_t>(i_data) + pageSize - 1) / pageSize) *
+    pageSize;
+  const std::size_t end =
+    ((reinterpret_cast<std::size_t>(i_data) + i_bytes) / pageSize) * pageSize;
+  if (end <= begin) {
+    return false;
+  }
+
+  // Interleave over the nodes the process is allowed, if more than one.
+  static const int kMaxNodes = 1024;
+  unsigned long nodes[kMaxNodes / (8 * sizeof(unsigned long))] = {0};
+  int mode = 0;
+  if (syscall(SYS_get_mempolicy, &mode, nodes, kMaxNodes, nullptr,
+              MPOL_F_MEMS_ALLOWED) != 0) {
+    return false;
+  }
+  int numNodes = 0;
+  for (unsigned long n : nodes) {
+    numNodes += __builtin_popcountl(n);
+  }
+  if (numNodes < 2) {
+    return false;
+  }
+  return syscall(SYS_mbind, reinterpret_cast<void*>(begin), end - begin,
+                 MPOL_INTERLEAVE, nodes, kMaxNodes, 0) == 0;
+#else
+  return false;
+#endif
+}
+
+//-*****************************************************************************
+static std::atomic<int> g_fieldPages(kSmallFieldPages);
+
+void SetFieldPages(FieldPages i_pages) {
+  g_fieldPages.store(int(i_pages), std::memory_order_relaxed);
+}
+
+FieldPages GetFieldPages() {
+  return FieldPages(g_fieldPages.load(std::memory_order_relaxed));
+}
+
+//-*****************************************************************************
+// Mappings are whole huge pages, so that the explicit ones can be unmapped,
+// and the transparent ones are trimmed to a huge page boundary, so that
+// the kernel can back all of them with huge pages.
+static std::size_t HugePageBytes(std::size_t i_bytes) {
+  return ((i_bytes + kHugePageSize - 1) / kHugePageSize) * kHugePageSize;
+}
+
+void* MapFieldMemory(std::size_t i_bytes) {
+#ifdef PLATFORM_LINUX
+  const FieldPages pages = GetFieldPages();
+  if (pages == kSmallFieldPages || i_bytes < kMinHugePageFieldBytes) {
+    return nullptr;
+  }
+  const std::size_t bytes = HugePageBytes(i_bytes);
+
+  if (pages == kExplicitHugeFieldPages) {
+    void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      return data;
+    }
+  }
+
+  void* mapped = mmap(nullptr, bytes + kHugePageSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) {
+    return nullptr;
+  }
+  char* const begin = static_cast<char*>(mapped);
+  char* const data  = reinterpret_cast<char*>(
+    ((reinterpret_cast<std::size_t>(begin) + kHugePageSize - 1) /
+     kHugePageSize) *
+    kHugePageSize);
+  if (data > begin) {
+    munmap(begin, std::size_t(data - begin));
+  }
+  char* const end = begin + bytes + kHugePageSize;
+  if (end > data + bytes) {
+    munmap(data + bytes, std::size_t(end - (data + bytes)));
+  }
+  madvise(data, bytes, MADV_HUGEPAGE);
+  return data;
+#else
+  return nullptr;
+#endif
+}
+
+void UnmapFieldMemory(void* i_data, std::size_t i_bytes) {
+#ifdef PLATFORM_LINUX
+  if (i_data) {
+    munmap(i_data, HugePageBytes(i_bytes));
+  }
+#endif
+}
+
 } // namespace EncinoWaves
@@ -46,6 +46,9 @@
 
 #include <iostream>
 #include <vector>
+#include <set>
+#include <map>
+#include <tuple>
 #include <string>
 #include <sstream>
 #include <complex>
@@ -53,16 +56,22 @@
 
 #include <memory>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 #include <type_traits>
 #include <random>
 #include <cstdint>
 #include <functional>
+#include <array>
 
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/blocked_range.h>
 #include <tbb/blocked_range2d.h>
 #include <tbb/mutex.h>
+#include <tbb/task_arena.h>
 
 #include <boost/format.hpp>
 
@@ -86,6 +95,112 @@ extern tbb::mutex g_printMutex;
     std::cout << TEXT;                          \
   } while (0)
 
+//-*****************************************************************************
+// Runs i_func in i_arena, or in the current arena if i_arena is null.
+template <typename FUNC>
+void ExecuteInArena(tbb::task_arena* i_arena, const FUNC& i_func) {
+  if (i_arena) {
+    i_arena->execute(i_func);
+  } else {
+    i_func();
+  }
+}
+
+//-*****************************************************************************
+// Grain size of streaming loops over i_size elements, such as the per-element
+// kernels of propagate. A task gets at least kMinStreamingGrainSize elements,
+// so its work dwarfs the cost of scheduling it, and at most an eighth of an
+// even share, so every thread of the current arena has a few tasks to
+// balance with.
+constexpr std::size_t kMinStreamingGrainSize = 4096;
+
+inline std::size_t StreamingGrainSize(std::size_t i_size) {
+  const std::size_t threads =
+    std::size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+  return std::max(kMinStreamingGrainSize, i_size / (8 * threads));
+}
+
+//-*****************************************************************************
+// How the memory of new fields is first touched. Linux puts a page on the
+// NUMA node of the thread that first writes it, so zeroing a whole field on
+// one thread puts all of it on that thread's node, and every other socket
+// then streams it across the interconnect.
+//
+// Serial zeroes on the calling thread, as fields always used to. Parallel
+// zeroes in evenly split chunks, with the grain of the streaming kernels,
+// over the threads of the current arena, so each socket owns a share of
+// every field. Interleaved also asks for the pages to be spread round-robin
+// over every node the process may use before they are touched, which
+// evens out the bandwidth when the threads that read a field aren't the
+// ones that zeroed it, such as FFTW's.
+enum FieldAllocation {
+  kSerialFieldAllocation,
+  kParallelFieldAllocation,
+  kInterleavedFieldAllocation
+};
+
+// The policy of fields allocated from now on, for the whole process.
+// Defaults to kParallelFieldAllocation.
+void SetFieldAllocation(FieldAllocation i_allocation);
+FieldAllocation GetFieldAllocation();
+
+// Asks for the whole pages of i_bytes at i_data to be interleaved over the
+// NUMA nodes the process may use. Only affects pages not yet touched.
+// Returns false if that isn't supported, as on a single node.
+bool InterleavePages(void* i_data, std::size_t i_bytes);
+
+//-*****************************************************************************
+// What pages large fields are backed by. At N of 4096 and up a propagated
+// state and the scratch of propagate run to gigabytes, and the strided
+// column passes of the transforms touch a new 4 KB page with almost every
+// value, missing the TLB. 2 MB pages cover 512 times as much each.
+//
+// Transparent maps the memory 2 MB aligned and asks the kernel to back it
+// with huge pages when it can, with madvise. Explicit maps it from the
+// reserved huge page pool, with MAP_HUGETLB, and falls back to transparent
+// when the pool is empty. Fields under kMinHugePageFieldBytes, and all
+// fields where mapping isn't supported, stay on FFTW's allocator.
+enum FieldPages {
+  kSmallFieldPages,
+  kTransparentHugeFieldPages,
+  kExplicitHugeFieldPages
+};
+
+constexpr std::size_t kHugePageSize          = std::size_t(2) << 20;
+constexpr std::size_t kMinHugePageFieldBytes = 4 * kHugePageSize;
+
+// The pages of fields allocated from now on, for the whole process.
+// Defaults to kSmallFieldPages.
+void SetFieldPages(FieldPages i_pages);
+FieldPages GetFieldPages();
+
+// Maps i_bytes for a field as the field pages policy says, 2 MB aligned.
+// Returns null where the policy or the size call for FFTW's allocator, or
+// mapping fails. Memory it returns is freed with UnmapFieldMemory, given
+// the same size.
+void* MapFieldMemory(std::size_t i_bytes);
+void UnmapFieldMemory(void* i_data, std::size_t i_bytes);
+
+// Zeroes i_count values of freshly allocated memory at i_data, touching it
+// first as the field allocation policy says.
+template <typename T>
+void FirstTouchZero(T* i_data, std::size_t i_count) {
+  const FieldAllocation allocation = GetFieldAllocation();
+  if (allocation == kSerialFieldAllocation) {
+    std::fill(i_data, i_data + i_count, T(0.0));
+    return;
+  }
+  if (allocation == kInterleavedFieldAllocation) {
+    InterleavePages(i_data, i_count * sizeof(T));
+  }
+  tbb::parallel_for(
+    tbb::blocked_range<std::size_t>(0, i_count, StreamingGrainSize(i_count)),
+    [i_data](const tbb::blocked_range<std::size_t>& i_range) {
+      std::fill(i_data + i_range.begin(), i_data + i_range.end(), T(0.0));
+    },
+    tbb::static_partitioner());
+}
+
 //-*****************************************************************************
 template <typename T>
 struct singular_value_type;
@@ -117,6 +232,36 @@ static int PowerOfTwo(int i_power) {
     return (0x1 << i_power);
   }
 }
+
+//-*****************************************************************************
+// The size of a grid of samples, Width along x by Height along y. Neither
+// has to be a power of two. Fields and transforms made from a power of two
+// are made on the square grid of that size.
+struct GridSize {
+  int Width;
+  int Height;
+
+  GridSize()
+      : Width(0)
+      , Height(0) {}
+
+  GridSize(int i_width, int i_height)
+      : Width(i_width)
+      , Height(i_height) {}
+
+  static GridSize Square(int i_powerOfTwo) {
+    const int n = PowerOfTwo(std::min(std::max(i_powerOfTwo, 0), 30));
+    return GridSize(n, n);
+  }
+
+  std::size_t area() const { return std::size_t(Width) * std::size_t(Height); }
+
+  bool operator==(const GridSize& i_other) const {
+    return Width == i_other.Width && Height == i_other.Height;
+  }
+  bool operator!=(const GridSize& i_other) const { return !(*this == i_other); }
+};
+
 #if 0
 
 //-*****************************************************************************
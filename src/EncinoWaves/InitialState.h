@@ -47,16 +47,76 @@
 
 namespace EncinoWaves {
 
+//-*****************************************************************************
+// The random layer of an initial state: the unit draws of every bin of the
+// half spectra, as made by DrawUnitNoise. They only depend on the grid, the
+// seed and the type of random distribution, so they can be drawn once and
+// shared by initial states that differ in any of the other parameters,
+// which then only evaluate their spectral envelope.
+template <typename T>
+struct InitialStateNoise {
+  GridSize Size;
+  RandomType Type;
+  int Seed;
+
+  ComplexSpectralField2D<T> NoisePos;
+  ComplexSpectralField2D<T> NoiseNeg;
+
+  // Runs in i_arena, if given, to keep to its thread budget.
+  InitialStateNoise(const Parameters<T>& i_params,
+                    tbb::task_arena* i_arena = nullptr);
+
+  // Whether these are the draws an initial state of i_params would make.
+  bool matches(const Parameters<T>& i_params) const {
+    return Size == i_params.gridSize() && Type == i_params.random.type &&
+           Seed == i_params.random.seed;
+  }
+};
+
+typedef InitialStateNoise<float> InitialStateNoisef;
+typedef InitialStateNoise<double> InitialStateNoised;
+
+//-*****************************************************************************
+// A new generation number, never zero, for each initial state made. Whatever
+// keeps something derived from a state, such as the phasors of fixed time
+// step playback, compares generations to tell a new state from an old one,
+// even when the new one reuses the old one's memory.
+inline std::uint64_t NextInitialStateGeneration() {
+  static std::atomic<std::uint64_t> s_generation(0);
+  return ++s_generation;
+}
+
 //-*****************************************************************************
 template <typename T>
 struct InitialState {
+  // The grid the state was made for. The spectra are its half spectra.
+  GridSize Size;
+
   ComplexSpectralField2D<T> HSpectralPos;
   ComplexSpectralField2D<T> HSpectralNeg;
   RealSpectralField2D<T> Omega;
 
-  InitialState(const Parameters<T>& i_params);
+  // Loop period the omegas were quantized to, or zero if they weren't.
+  T LoopPeriod;
+
+  // See NextInitialStateGeneration.
+  std::uint64_t Generation;
+
+  // Runs in i_arena, if given, to keep to its thread budget.
+  InitialState(const Parameters<T>& i_params,
+               tbb::task_arena* i_arena = nullptr);
+
+  // Scales the cached unit draws of i_noise, which must match i_params,
+  // rather than drawing them again.
+  InitialState(const Parameters<T>& i_params,
+               const InitialStateNoise<T>& i_noise,
+               tbb::task_arena* i_arena = nullptr);
 
   int resolution() const { return HSpectralPos.height(); }
+
+protected:
+  void make(const Parameters<T>& i_params,
+            const InitialStateNoise<T>* i_noise);
 };
 
 typedef InitialState<float> InitialStatef;
@@ -89,6 +149,7 @@ struct InitialStateHelper {
   // Info
   real_type RhoG;
   real_type Domain;
+  GridSize Size;
 
   // Little processor object that is run at each point.
   struct Processor {
@@ -104,6 +165,7 @@ struct InitialStateHelper {
 
     real_type RhoG;
     real_type Domain;
+    GridSize Size;
 
     Processor(const this_type& i_func)
       : Dispersion(*(i_func.Dispersion))
@@ -115,7 +177,19 @@ struct InitialStateHelper {
       , HSpectralNeg(i_func.HSpectralNeg)
       , Omega(i_func.Omega)
       , RhoG(i_func.RhoG)
-      , Domain(i_func.Domain) {}
+      , Domain(i_func.Domain)
+      , Size(i_func.Size) {}
+
+    // The terms of a bin which only depend on the magnitude of its
+    // wavenumber, made once per magnitude by RadialSpectralIterationFunctor.
+    struct radial_type {
+      real_type Omega;
+      real_type DOmegaDk;
+      real_type Spectrum;
+      real_type ChangeOfVariables;
+      real_type Filter;
+      typename DIRECTIONAL_SPREADING::Radial Spreading;
+    };
 
     void operator()(std::size_t i_index) {
       HSpectralPos[i_index] = complex_type(0.0, 0.0);
@@ -123,8 +197,17 @@ struct InitialStateHelper {
       Omega[i_index]        = 0.0;
     }
 
+    void radial(real_type kMag, real_type dK, radial_type& o_radial) const;
+
+    void operator()(const vec_type& k, const radial_type& i_radial,
+                    real_type kMag, real_type dK, std::size_t index);
+
     void operator()(const vec_type& k, real_type kMag, real_type dK,
-                    std::size_t index);
+                    std::size_t index) {
+      radial_type r;
+      radial(kMag, dK, r);
+      (*this)(k, r, kMag, dK, index);
+    }
   };
 };
 
@@ -132,18 +215,8 @@ struct InitialStateHelper {
 // CJH HACK - hacked all over
 template <typename _D, typename _S, typename _DS, typename _F, typename _R,
           typename T>
-void InitialStateHelper<_D, _S, _DS, _F, _R, T>::Processor::operator()(
-  const vec_type& k, real_type kMag, real_type dK, std::size_t index) {
-  // Seed the random number generator from the wave numbers.
-  Random.seed(k);
-
-  // get thetaPos and thetaNeg from k.
-  const real_type thetaPos = std::atan2(-k[1], k[0]);
-  const real_type thetaNeg = std::atan2(k[1], -k[0]);
-  EWAV_ASSERT(std::isfinite(thetaPos) && std::isfinite(thetaNeg),
-                   "Broken thetas : " << thetaPos << ", " << thetaNeg
-                                      << " at index: " << index);
-
+void InitialStateHelper<_D, _S, _DS, _F, _R, T>::Processor::radial(
+  real_type kMag, real_type dK, radial_type& o_radial) const {
   // Get omega and dOmegaDk from k. Dispersion functors provide both, by
   // reference.
   real_type omega, dOmegaDk;
@@ -152,7 +225,9 @@ void InitialStateHelper<_D, _S, _DS, _F, _R, T>::Processor::operator()(
   assert(dOmegaDk >= T(0.0));
   EWAV_ASSERT(std::isfinite(omega) && std::isfinite(dOmegaDk),
                    "Broken omegas : " << omega << ", " << dOmegaDk
-                                      << " at index: " << index);
+                                      << " at kMag: " << kMag);
+  o_radial.Omega    = omega;
+  o_radial.DOmegaDk = dOmegaDk;
 
   // The area of each point being integrated is dki * dkj.  However,
   // We're evaluating the function in omega & theta space.  We need to
@@ -171,51 +246,77 @@ void InitialStateHelper<_D, _S, _DS, _F, _R, T>::Processor::operator()(
   // Where dOmegaDkmag is computed by the Dispersion relationship.
 
   // Get spectrum.
-  real_type DeltaSPos = Spectrum(omega);
-  real_type DeltaSNeg = DeltaSPos;
-  EWAV_ASSERT(std::isfinite(DeltaSPos) && std::isfinite(DeltaSNeg),
-                   "Broken deltaSs : " << DeltaSPos << ", " << DeltaSNeg
-                                       << " at index: " << index);
+  o_radial.Spectrum = Spectrum(omega);
+  EWAV_ASSERT(std::isfinite(o_radial.Spectrum),
+                   "Broken deltaS : " << o_radial.Spectrum
+                                      << " at kMag: " << kMag);
 
-  // Attenuate by directional spreading
+  // The directional spreading's own radial terms.
   const real_type dTheta = std::abs(std::atan2(dK, kMag));
-  DeltaSPos *= DirectionalSpreading(omega, thetaPos, kMag, dTheta);
-  DeltaSNeg *= DirectionalSpreading(omega, thetaNeg, kMag, dTheta);
+  o_radial.Spreading     = DirectionalSpreading.radial(omega, kMag, dTheta);
 
-  // Multiply DeltaSPos by dOmegaDk / kMag, which completes the
-  // change of variables, and then multiply by dK^2.
-  DeltaSPos *= (dK * dK) * dOmegaDk / (kMag);
-  DeltaSNeg *= (dK * dK) * dOmegaDk / (kMag);
+  // dOmegaDk / kMag completes the change of variables, then dK^2.
+  o_radial.ChangeOfVariables = (dK * dK) * dOmegaDk / (kMag);
+
+  // Filter amplitudes. Filter has to be outside the sqrt so that it
+  // is properly invertible.
+  o_radial.Filter = Filter(kMag);
+}
+
+//-*****************************************************************************
+template <typename _D, typename _S, typename _DS, typename _F, typename _R,
+          typename T>
+void InitialStateHelper<_D, _S, _DS, _F, _R, T>::Processor::operator()(
+  const vec_type& k, const radial_type& i_radial, real_type kMag,
+  real_type dK, std::size_t index) {
+  // Draw from the integer wavenumber of the bin, which is exact, where
+  // the real one depends on the domain and on rounding.
+  const std::size_t strideJ = std::size_t(Size.Width / 2) + 1;
+  const int i               = int(index % strideJ);
+  const int j               = int(index / strideJ);
+  complex_type unitPos, unitNeg;
+  DrawUnitNoise(Random, i, j <= Size.Height / 2 ? j : j - Size.Height, index,
+                unitPos, unitNeg);
+
+  // get thetaPos and thetaNeg from k.
+  const real_type thetaPos = std::atan2(-k[1], k[0]);
+  const real_type thetaNeg = std::atan2(k[1], -k[0]);
+  EWAV_ASSERT(std::isfinite(thetaPos) && std::isfinite(thetaNeg),
+                   "Broken thetas : " << thetaPos << ", " << thetaNeg
+                                      << " at index: " << index);
+
+  // Attenuate by directional spreading
+  real_type DeltaSPos = i_radial.Spectrum;
+  real_type DeltaSNeg = DeltaSPos;
+  DeltaSPos *= DirectionalSpreading(i_radial.Spreading, thetaPos);
+  DeltaSNeg *= DirectionalSpreading(i_radial.Spreading, thetaNeg);
+
+  // Complete the change of variables.
+  DeltaSPos *= i_radial.ChangeOfVariables;
+  DeltaSNeg *= i_radial.ChangeOfVariables;
 
   // Amp is equal to sqrt( 2 DeltaS );
-  real_type ampPos = Random.nextAmp() * std::sqrt(std::abs(DeltaSPos * T(2.0)));
-  real_type ampNeg = Random.nextAmp() * std::sqrt(std::abs(DeltaSNeg * T(2.0)));
+  real_type ampPos = std::sqrt(std::abs(DeltaSPos * T(2.0)));
+  real_type ampNeg = std::sqrt(std::abs(DeltaSNeg * T(2.0)));
   EWAV_ASSERT(std::isfinite(ampPos) && std::isfinite(ampNeg),
                    "Broken amps : " << ampPos << ", " << ampNeg
                                     << " at index: " << index);
 
-  // Filter amplitudes. Filter has to be outside the sqrt so that it
-  // is properly invertible.
-  const real_type filt = Filter(kMag);
-  ampPos *= filt;
-  ampNeg *= filt;
+  // Filter amplitudes.
+  ampPos *= i_radial.Filter;
+  ampNeg *= i_radial.Filter;
   EWAV_ASSERT(std::isfinite(ampPos) && std::isfinite(ampNeg),
                    "Broken filtered amps : " << ampPos << ", " << ampNeg
                                              << " at index: " << index);
 
-  // Store results!
-  // Get random draws for phase.
-  const real_type phasePos = Random.nextPhase();
-  const real_type phaseNeg = Random.nextPhase();
-  HSpectralPos[index] =
-    ampPos * complex_type(std::cos(phasePos), -std::sin(phasePos));
-  HSpectralNeg[index] =
-    ampNeg * complex_type(std::cos(phaseNeg), -std::sin(phaseNeg));
+  // Store results! The envelope times the unit draws.
+  HSpectralPos[index] = ampPos * unitPos;
+  HSpectralNeg[index] = ampNeg * unitNeg;
 
   // Assuming, for now, that angular velocity is the same for positive
   // and negative waves, which is not always true - some dispersion
   // relationships have faster travel for bigger waves.
-  Omega[index] = omega;
+  Omega[index] = i_radial.Omega;
 }
 
 //-*****************************************************************************
@@ -234,7 +335,8 @@ void ExecuteRange(const DISPERSION& i_dispersion, const SPECTRUM& i_spectrum,
                   const DIRECTIONAL_SPREADING& i_directionalSpreading,
                   const FILTER& i_filter, const RANDOM& i_random,
 
-                  InitialState<T>& o_state, T i_domain, T i_rhoG) {
+                  InitialState<T>& o_state, const Imath::Vec2<T>& i_domain,
+                  T i_rhoG) {
   typedef InitialStateHelper<DISPERSION, SPECTRUM, DIRECTIONAL_SPREADING,
                              FILTER, RANDOM, T> F_type;
   typedef typename F_type::Processor P_type;
@@ -256,13 +358,44 @@ void ExecuteRange(const DISPERSION& i_dispersion, const SPECTRUM& i_spectrum,
 
   // Info.
   F.RhoG   = i_rhoG;
-  F.Domain = i_domain;
+  F.Domain = i_domain[0];
+  F.Size   = o_state.Size;
+
+  // Spectral Iterate, making the radial terms once per pair of rows.
+  {
+    RadialSpectralIterationFunctor<T, F_type, P_type> iter(
+      &F, i_domain[0], i_domain[1], o_state.Size);
+  }
+};
 
-  // Spectral Iterate.
-  int N = o_state.HSpectralPos.height();
-  { SpectralIterationFunctor<T, F_type, P_type> iter(&F, i_domain, N); }
+//-*****************************************************************************
+// Reads the unit draws of an initial state from InitialStateNoise, by the
+// index of the bin, instead of making them.
+template <typename T>
+class CachedNoiseRandom {
+protected:
+  const std::complex<T>* m_noisePos;
+  const std::complex<T>* m_noiseNeg;
+
+public:
+  explicit CachedNoiseRandom(const InitialStateNoise<T>& i_noise)
+    : m_noisePos(i_noise.NoisePos.cdata())
+    , m_noiseNeg(i_noise.NoiseNeg.cdata()) {}
+
+  void draw(std::size_t i_index, std::complex<T>& o_pos,
+            std::complex<T>& o_neg) const {
+    o_pos = m_noisePos[i_index];
+    o_neg = m_noiseNeg[i_index];
+  }
 };
 
+template <typename T>
+void DrawUnitNoise(CachedNoiseRandom<T>& i_random, int /*i_kx*/, int /*i_ky*/,
+                   std::size_t i_index, std::complex<T>& o_pos,
+                   std::complex<T>& o_neg) {
+  i_random.draw(i_index, o_pos, o_neg);
+}
+
 //-*****************************************************************************
 template <typename DISPERSION, typename SPECTRUM,
           typename DIRECTIONAL_SPREADING, typename FILTER, typename T>
@@ -270,12 +403,24 @@ void ConfigRandom_CascadeExec(
   const Parameters<T>& i_params, const DISPERSION& i_dispersion,
   const SPECTRUM& i_spectrum,
   const DIRECTIONAL_SPREADING& i_directionalSpreading, const FILTER& i_filter,
+  const InitialStateNoise<T>* i_noise,
 
   InitialState<T>& o_state) {
   NormalRandom<T> Fnorm(i_params);
   LogNormalRandom<T> FlogNorm(i_params);
   const T rhoG = i_params.gravity;
 
+  if (i_noise) {
+    EWAV_ASSERT(i_noise->matches(i_params),
+                "Cached random draws don't match the parameters.");
+    std::cout << "Cached Random Draws" << std::endl;
+    ExecuteRange<DISPERSION, SPECTRUM, DIRECTIONAL_SPREADING, FILTER,
+                 CachedNoiseRandom<T>, T>(
+      i_dispersion, i_spectrum, i_directionalSpreading, i_filter,
+      CachedNoiseRandom<T>(*i_noise), o_state, i_params.domainSize(), rhoG);
+    return;
+  }
+
   switch (i_params.random.type) {
   default:
   case kNormalRandom:
@@ -283,14 +428,14 @@ void ConfigRandom_CascadeExec(
     ExecuteRange<DISPERSION, SPECTRUM, DIRECTIONAL_SPREADING, FILTER,
                  NormalRandom<T>, T>(i_dispersion, i_spectrum,
                                      i_directionalSpreading, i_filter, Fnorm,
-                                     o_state, i_params.domain, rhoG);
+                                     o_state, i_params.domainSize(), rhoG);
     break;
   case kLogNormalRandom:
     std::cout << "Log-Normal Random Distribution" << std::endl;
     ExecuteRange<DISPERSION, SPECTRUM, DIRECTIONAL_SPREADING, FILTER,
                  LogNormalRandom<T>, T>(
       i_dispersion, i_spectrum, i_directionalSpreading, i_filter, FlogNorm,
-      o_state, i_params.domain, rhoG);
+      o_state, i_params.domainSize(), rhoG);
     break;
   };
 }
@@ -302,6 +447,7 @@ void ConfigFilter_CascadeExec(
   const Parameters<T>& i_params, const DISPERSION& i_dispersion,
   const SPECTRUM& i_spectrum,
   const DIRECTIONAL_SPREADING& i_directionalSpreading,
+  const InitialStateNoise<T>* i_noise,
 
   InitialState<T>& o_state) {
   SmoothInvertibleBandPassFilter<T> Fsibp(i_params);
@@ -313,7 +459,7 @@ void ConfigFilter_CascadeExec(
     ConfigRandom_CascadeExec<DISPERSION, SPECTRUM, DIRECTIONAL_SPREADING,
                              SmoothInvertibleBandPassFilter<T>, T>(
       i_params, i_dispersion, i_spectrum, i_directionalSpreading, Fsibp,
-      o_state);
+      i_noise, o_state);
     break;
 
   default:
@@ -322,7 +468,7 @@ void ConfigFilter_CascadeExec(
     ConfigRandom_CascadeExec<DISPERSION, SPECTRUM, DIRECTIONAL_SPREADING,
                              NullFilter<T>, T>(
       i_params, i_dispersion, i_spectrum, i_directionalSpreading, Fnull,
-      o_state);
+      i_noise, o_state);
     break;
   };
 }
@@ -332,6 +478,7 @@ template <typename DISPERSION, typename SPECTRUM, typename T>
 void ConfigDirectionalSpreading_CascadeExec(const Parameters<T>& i_params,
                                             const DISPERSION& i_dispersion,
                                             const SPECTRUM& i_spectrum,
+                                            const InitialStateNoise<T>* i_noise,
 
                                             InitialState<T>& o_state) {
   PosCosSquaredDirectionalSpreading<T> FCosSqr(i_params);
@@ -345,26 +492,27 @@ void ConfigDirectionalSpreading_CascadeExec(const Parameters<T>& i_params,
     std::cout << "Donelan Banner Directional Spreading." << std::endl;
     ConfigFilter_CascadeExec<DISPERSION, SPECTRUM,
                              DonelanBannerDirectionalSpreading<T>, T>(
-      i_params, i_dispersion, i_spectrum, FDonelanBanner, o_state);
+      i_params, i_dispersion, i_spectrum, FDonelanBanner, i_noise,
+      o_state);
     break;
   case kHasselmannDirectionalSpreading:
     std::cout << "Hasselmann Directional Spreading." << std::endl;
     ConfigFilter_CascadeExec<DISPERSION, SPECTRUM,
                              HasselmannDirectionalSpreading<T>, T>(
-      i_params, i_dispersion, i_spectrum, FHasselmann, o_state);
+      i_params, i_dispersion, i_spectrum, FHasselmann, i_noise, o_state);
     break;
   case kMitsuyasuDirectionalSpreading:
     std::cout << "Mitsuyasu Directional Spreading." << std::endl;
     ConfigFilter_CascadeExec<DISPERSION, SPECTRUM,
                              MitsuyasuDirectionalSpreading<T>, T>(
-      i_params, i_dispersion, i_spectrum, FMitsuyasu, o_state);
+      i_params, i_dispersion, i_spectrum, FMitsuyasu, i_noise, o_state);
     break;
 
   case kPosCosThetaSqrDirectionalSpreading:
     std::cout << "Pos Cos Theta Squared Directional Spreading." << std::endl;
     ConfigFilter_CascadeExec<DISPERSION, SPECTRUM,
                              PosCosSquaredDirectionalSpreading<T>, T>(
-      i_params, i_dispersion, i_spectrum, FCosSqr, o_state);
+      i_params, i_dispersion, i_spectrum, FCosSqr, i_noise, o_state);
     break;
   };
 }
@@ -373,6 +521,7 @@ void ConfigDirectionalSpreading_CascadeExec(const Parameters<T>& i_params,
 template <typename DISPERSION, typename T>
 void ConfigSpectrum_CascadeExec(const Parameters<T>& i_params,
                                 const DISPERSION& i_dispersion,
+                                const InitialStateNoise<T>* i_noise,
 
                                 InitialState<T>& o_state) {
   PiersonMoskowitzSpectrum<T> FPiersonMoskowitz(i_params);
@@ -384,20 +533,20 @@ void ConfigSpectrum_CascadeExec(const Parameters<T>& i_params,
     std::cout << "Pierson Moskowitz Spectrum." << std::endl;
     ConfigDirectionalSpreading_CascadeExec<DISPERSION,
                                            PiersonMoskowitzSpectrum<T>, T>(
-      i_params, i_dispersion, FPiersonMoskowitz, o_state);
+      i_params, i_dispersion, FPiersonMoskowitz, i_noise, o_state);
     break;
 
   case kJONSWAPSpectrum:
     std::cout << "JONSWAP Spectrum." << std::endl;
     ConfigDirectionalSpreading_CascadeExec<DISPERSION, JONSWAPSpectrum<T>, T>(
-      i_params, i_dispersion, FJONSWAP, o_state);
+      i_params, i_dispersion, FJONSWAP, i_noise, o_state);
     break;
 
   default:
   case kTMASpectrum:
     std::cout << "Texel Marsen Arsloe (TMA) Spectrum." << std::endl;
     ConfigDirectionalSpreading_CascadeExec<DISPERSION, TMASpectrum<T>, T>(
-      i_params, i_dispersion, FTMA, o_state);
+      i_params, i_dispersion, FTMA, i_noise, o_state);
     break;
   };
 }
@@ -405,6 +554,7 @@ void ConfigSpectrum_CascadeExec(const Parameters<T>& i_params,
 //-*****************************************************************************
 template <typename T>
 void ConfigDispersion_CascadeExec(const Parameters<T>& i_params,
+                                  const InitialStateNoise<T>* i_noise,
 
                                   InitialState<T>& o_state) {
   DeepDispersion<T> FDeep(i_params);
@@ -414,35 +564,139 @@ void ConfigDispersion_CascadeExec(const Parameters<T>& i_params,
   switch (i_params.dispersion.type) {
   case kDeepDispersion:
     std::cout << "Deep Dispersion." << std::endl;
-    ConfigSpectrum_CascadeExec<DeepDispersion<T>, T>(i_params, FDeep, o_state);
+    ConfigSpectrum_CascadeExec<DeepDispersion<T>, T>(i_params, FDeep, i_noise,
+                                                     o_state);
     break;
 
   case kFiniteDepthDispersion:
     std::cout << "Finite Depth Dispersion." << std::endl;
     ConfigSpectrum_CascadeExec<FiniteDepthDispersion<T>, T>(
-      i_params, FFiniteDepth, o_state);
+      i_params, FFiniteDepth, i_noise, o_state);
     break;
 
   default:
   case kCapillaryDispersion:
     std::cout << "Capillary Dispersion." << std::endl;
-    ConfigSpectrum_CascadeExec<CapillaryDispersion<T>, T>(i_params, FCapillary,
-                                                          o_state);
+    ConfigSpectrum_CascadeExec<CapillaryDispersion<T>, T>(
+      i_params, FCapillary, i_noise, o_state);
     break;
   };
 }
 
+//-*****************************************************************************
+// Rounds each omega to a multiple of the loop frequency, 2 pi / LoopPeriod,
+// so that every wave completes a whole number of cycles per loop. Waves
+// slower than the loop frequency are rounded up to it, rather than down to
+// zero, so that no wave stands still.
+template <typename T>
+struct QuantizeOmega {
+  T* Omega;
+  T LoopPeriod;
+
+  void operator()(const tbb::blocked_range<std::size_t>& i_range) const {
+    const T quantum = T(M_TAU) / LoopPeriod;
+    for (std::size_t i = i_range.begin(); i != i_range.end(); ++i) {
+      if (Omega[i] > T(0)) {
+        Omega[i] = quantum * std::max(std::round(Omega[i] / quantum), T(1));
+      }
+    }
+  }
+};
+
 //-*****************************************************************************
 //-*****************************************************************************
 // DO IT
 //-*****************************************************************************
 //-*****************************************************************************
 template <typename T>
-InitialState<T>::InitialState(const Parameters<T>& i_params)
-  : HSpectralPos(i_params.resolutionPowerOfTwo)
-  , HSpectralNeg(i_params.resolutionPowerOfTwo)
-  , Omega(i_params.resolutionPowerOfTwo) {
-  ConfigDispersion_CascadeExec<T>(i_params, *this);
+InitialState<T>::InitialState(const Parameters<T>& i_params,
+                              tbb::task_arena* i_arena)
+  : Size(i_params.gridSize())
+  , HSpectralPos(Size)
+  , HSpectralNeg(Size)
+  , Omega(Size)
+  , LoopPeriod(std::max(i_params.loopPeriod, T(0)))
+  , Generation(NextInitialStateGeneration()) {
+  ExecuteInArena(i_arena, [&] { make(i_params, nullptr); });
+}
+
+//-*****************************************************************************
+template <typename T>
+InitialState<T>::InitialState(const Parameters<T>& i_params,
+                              const InitialStateNoise<T>& i_noise,
+                              tbb::task_arena* i_arena)
+  : Size(i_params.gridSize())
+  , HSpectralPos(Size)
+  , HSpectralNeg(Size)
+  , Omega(Size)
+  , LoopPeriod(std::max(i_params.loopPeriod, T(0)))
+  , Generation(NextInitialStateGeneration()) {
+  ExecuteInArena(i_arena, [&] { make(i_params, &i_noise); });
+}
+
+//-*****************************************************************************
+template <typename T>
+void InitialState<T>::make(const Parameters<T>& i_params,
+                           const InitialStateNoise<T>* i_noise) {
+  ConfigDispersion_CascadeExec<T>(i_params, i_noise, *this);
+  if (LoopPeriod > 0) {
+    QuantizeOmega<T> F;
+    F.Omega      = Omega.data();
+    F.LoopPeriod = LoopPeriod;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, Omega.size()), F);
+  }
+}
+
+//-*****************************************************************************
+// Draws the unit noise of every bin of a range of rows with Random.
+template <typename RANDOM, typename T>
+struct DrawInitialStateNoise {
+  RANDOM Random;
+  std::complex<T>* NoisePos;
+  std::complex<T>* NoiseNeg;
+  GridSize Size;
+
+  void operator()(const tbb::blocked_range<int>& i_rows) const {
+    RANDOM random(Random);
+    const std::size_t strideJ = std::size_t(Size.Width / 2) + 1;
+    for (int j = i_rows.begin(); j != i_rows.end(); ++j) {
+      const int kj = j <= Size.Height / 2 ? j : j - Size.Height;
+      for (std::size_t i = 0; i < strideJ; ++i) {
+        const std::size_t index = (std::size_t(j) * strideJ) + i;
+        DrawUnitNoise(random, int(i), kj, index, NoisePos[index],
+                      NoiseNeg[index]);
+      }
+    }
+  }
+};
+
+template <typename RANDOM, typename T>
+void ExecuteDrawNoise(const RANDOM& i_random, InitialStateNoise<T>& o_noise) {
+  DrawInitialStateNoise<RANDOM, T> F{i_random, o_noise.NoisePos.data(),
+                                     o_noise.NoiseNeg.data(), o_noise.Size};
+  tbb::parallel_for(tbb::blocked_range<int>(0, o_noise.Size.Height), F);
+}
+
+//-*****************************************************************************
+template <typename T>
+InitialStateNoise<T>::InitialStateNoise(const Parameters<T>& i_params,
+                                        tbb::task_arena* i_arena)
+  : Size(i_params.gridSize())
+  , Type(i_params.random.type)
+  , Seed(i_params.random.seed)
+  , NoisePos(Size)
+  , NoiseNeg(Size) {
+  ExecuteInArena(i_arena, [&] {
+    switch (Type) {
+    default:
+    case kNormalRandom:
+      ExecuteDrawNoise(NormalRandom<T>(i_params), *this);
+      break;
+    case kLogNormalRandom:
+      ExecuteDrawNoise(LogNormalRandom<T>(i_params), *this);
+      break;
+    }
+  });
 }
 
 }  // namespace EncinoWaves
@@ -115,42 +115,44 @@ struct DownsampleFunc {
   typedef DownsampleFunc<T> this_type;
 
   const T* Src;
-  int SrcN;
+  int SrcNx;
+  int SrcNy;
   int SrcStrideJ;
 
   T* Dst;
-  int DstN;
+  int DstNx;
+  int DstNy;
   int DstStrideJ;
 
   T& dstPixel(int i, int j) {
-    return Dst[wrap(i, DstN) + (wrap(j, DstN) * DstStrideJ)];
+    return Dst[wrap(i, DstNx) + (wrap(j, DstNy) * DstStrideJ)];
   }
 
   T srcPixel(int i, int j) const {
-    return Src[wrap(i, SrcN) + (wrap(j, SrcN) * SrcStrideJ)];
+    return Src[wrap(i, SrcNx) + (wrap(j, SrcNy) * SrcStrideJ)];
   }
 
   void processDstLine(int j) const {
     int srcJ = j * 2;
 
-    const T* SrcA = Src + (SrcStrideJ * wrap((srcJ - 1), SrcN));
-    const T* SrcB = Src + (SrcStrideJ * wrap((srcJ + 0), SrcN));
-    const T* SrcC = Src + (SrcStrideJ * wrap((srcJ + 1), SrcN));
-    const T* SrcD = Src + (SrcStrideJ * wrap((srcJ + 2), SrcN));
+    const T* SrcA = Src + (SrcStrideJ * wrap((srcJ - 1), SrcNy));
+    const T* SrcB = Src + (SrcStrideJ * wrap((srcJ + 0), SrcNy));
+    const T* SrcC = Src + (SrcStrideJ * wrap((srcJ + 1), SrcNy));
+    const T* SrcD = Src + (SrcStrideJ * wrap((srcJ + 2), SrcNy));
 
     T* dst = Dst + (DstStrideJ * j);
 
-    DownsampleTransferFunc<T, AssignTransferOp<T>, EdgeKernel<T> >(SrcA, SrcN,
-                                                                   dst, DstN);
+    DownsampleTransferFunc<T, AssignTransferOp<T>, EdgeKernel<T> >(
+      SrcA, SrcNx, dst, DstNx);
 
     DownsampleTransferFunc<T, PlusEqualsTransferOp<T>, CenterKernel<T> >(
-      SrcB, SrcN, dst, DstN);
+      SrcB, SrcNx, dst, DstNx);
 
     DownsampleTransferFunc<T, PlusEqualsTransferOp<T>, CenterKernel<T> >(
-      SrcC, SrcN, dst, DstN);
+      SrcC, SrcNx, dst, DstNx);
 
     DownsampleTransferFunc<T, PlusEqualsTransferOp<T>, EdgeKernel<T> >(
-      SrcD, SrcN, dst, DstN);
+      SrcD, SrcNx, dst, DstNx);
   }
 
   void operator()(const tbb::blocked_range<int>& i_range) const {
@@ -161,24 +163,27 @@ struct DownsampleFunc {
 };
 
 //-*****************************************************************************
-// Apply Mip Map functor to downsample one Spatial Field to another.
+// Apply Mip Map functor to downsample one Spatial Field to another, half its
+// size along each axis. The fields don't have to be square.
 template <typename T>
 void Downsample(const RealSpatialField2D<T>& i_src,
                 RealSpatialField2D<T>& o_dst) {
   EWAV_ASSERT(i_src.unpaddedWidth() == (o_dst.unpaddedWidth() * 2) &&
                 i_src.unpaddedHeight() == (o_dst.unpaddedHeight() * 2) &&
-                i_src.unpaddedWidth() == i_src.unpaddedHeight(),
+                o_dst.unpaddedWidth() >= 2,
               "Mip-map sizes are wrong");
   // Downsample
   {
     DownsampleFunc<T> F;
 
     F.Src        = i_src.cdata();
-    F.SrcN       = i_src.unpaddedWidth();
+    F.SrcNx      = i_src.unpaddedWidth();
+    F.SrcNy      = i_src.unpaddedHeight();
     F.SrcStrideJ = i_src.stride();
 
     F.Dst        = o_dst.data();
-    F.DstN       = o_dst.unpaddedWidth();
+    F.DstNx      = o_dst.unpaddedWidth();
+    F.DstNy      = o_dst.unpaddedHeight();
     F.DstStrideJ = o_dst.stride();
 
     tbb::parallel_for(tbb::blocked_range<int>{0, (int)o_dst.unpaddedHeight()},
@@ -188,21 +193,25 @@ void Downsample(const RealSpatialField2D<T>& i_src,
   // Fill in the repeated border.
   {
     CopyWrappedBorder<T> F;
-    F.Data = o_dst.data();
-    F.N = o_dst.unpaddedWidth();
+    F.Data   = o_dst.data();
+    F.Width  = o_dst.unpaddedWidth();
+    F.Height = o_dst.unpaddedHeight();
     tbb::parallel_for(tbb::blocked_range<int>{0, (int)o_dst.height()}, F);
   }
 }
 
 //-*****************************************************************************
 // Apply a Mip Map functor to downsample one Propagated State to another.
+// Only the fields that both states have are downsampled.
 template <typename T>
 void DownsampleState(const PropagatedState<T>& i_src,
                      PropagatedState<T>& o_dst) {
-  Downsample<T>(i_src.Height, o_dst.Height);
-  Downsample<T>(i_src.Dx, o_dst.Dx);
-  Downsample<T>(i_src.Dy, o_dst.Dy);
-  Downsample<T>(i_src.MinE, o_dst.MinE);
+  for (int f = 0; f < kNumPropagatedFields; ++f) {
+    const PropagatedField field = PropagatedField(f);
+    if (i_src.has(field) && o_dst.has(field)) {
+      Downsample<T>(i_src.field(field), o_dst.field(field));
+    }
+  }
 }
 
 }  // namespace EncinoWaves
@@ -50,31 +50,33 @@ struct ComputeNormalsWithPinching {
   const T* DY  = nullptr;
   V3T* Normals = nullptr;
 
-  int N = 0;
-  T Spacing;
+  int Nx = 0;
+  int Ny = 0;
+  T SpacingX;
+  T SpacingY;
   T AmpGain;
   T Pinch;
 
   std::size_t index(std::size_t x, std::size_t y) const {
-    return (y * std::size_t(N + 1)) + x;
+    return (y * std::size_t(Nx + 1)) + x;
   }
 
   V3T pointAtIndex(T i_xMult, T i_yMult, std::size_t i_index) const {
-    return V3T((i_xMult * Spacing) - (Pinch * DX[i_index]),
-               (i_yMult * Spacing) - (Pinch * DY[i_index]),
+    return V3T((i_xMult * SpacingX) - (Pinch * DX[i_index]),
+               (i_yMult * SpacingY) - (Pinch * DY[i_index]),
                AmpGain * H[i_index]);
   }
 
   void operator()(const tbb::blocked_range2d<int>& range) const {
     for (auto y = range.rows().begin(); y != range.rows().end(); ++y) {
-      auto downY = wrap(y - 1, N);
-      auto cenY  = wrap(y, N);
-      auto upY   = wrap(y + 1, N);
+      auto downY = wrap(y - 1, Ny);
+      auto cenY  = wrap(y, Ny);
+      auto upY   = wrap(y + 1, Ny);
 
       for (auto x = range.cols().begin(); x != range.cols().end(); ++x) {
-        auto leftX  = wrap(x - 1, N);
-        auto cenX   = wrap(x, N);
-        auto rightX = wrap(x + 1, N);
+        auto leftX  = wrap(x - 1, Nx);
+        auto cenX   = wrap(x, Nx);
+        auto rightX = wrap(x + 1, Nx);
 
         auto leftIndex  = index(leftX, cenY);
         auto rightIndex = index(rightX, cenY);
@@ -96,12 +98,17 @@ struct ComputeNormalsWithPinching {
 };
 
 //-*****************************************************************************
+// Runs in i_arena, if given, to keep to its thread budget.
 template <typename T>
 void ComputeNormals(const Parameters<T>& i_params,
                     const PropagatedState<T>& i_waves,
-                    Imath::Vec3<T>* o_normals) {
-  const int N     = i_waves.Height.unpaddedWidth();
-  const T spacing = i_params.domain / T(N);
+                    Imath::Vec3<T>* o_normals,
+                    tbb::task_arena* i_arena = nullptr) {
+  EWAV_ASSERT((i_waves.Channels & kDisplacementChannels) ==
+                kDisplacementChannels,
+              "Normals need the Height, Dx and Dy channels");
+  const GridSize size            = i_waves.Height.gridSize();
+  const Imath::Vec2<T> domainSize = i_params.domainSize();
 
   ComputeNormalsWithPinching<T> F;
   F.H       = i_waves.Height.cdata();
@@ -109,12 +116,17 @@ void ComputeNormals(const Parameters<T>& i_params,
   F.DY      = i_waves.Dy.cdata();
   F.Normals = o_normals;
 
-  F.N       = N;
-  F.Spacing = spacing;
-  F.AmpGain = i_params.amplitudeGain;
-  F.Pinch   = i_params.pinch;
-
-  tbb::parallel_for(tbb::blocked_range2d<int>{0, N + 1, 1, 0, N + 1, 512}, F);
+  F.Nx       = size.Width;
+  F.Ny       = size.Height;
+  F.SpacingX = domainSize[0] / T(size.Width);
+  F.SpacingY = domainSize[1] / T(size.Height);
+  F.AmpGain  = i_params.amplitudeGain;
+  F.Pinch    = i_params.pinch;
+
+  ExecuteInArena(i_arena, [&] {
+    tbb::parallel_for(
+        tbb::blocked_range2d<int>{0, F.Ny + 1, 1, 0, F.Nx + 1, 512}, F);
+  });
 }
 
 }  // namespace EncinoWaves
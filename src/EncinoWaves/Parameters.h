@@ -76,10 +76,19 @@ struct Parameters {
   // Resolution of the waves.
   int resolutionPowerOfTwo;
 
+  // Resolution along x and along y, for a grid that isn't square, or whose
+  // sides aren't powers of two. Zero for the resolution of the power of two.
+  int resolutionX;
+  int resolutionY;
+
   // Domain of the waves. - this is the size of the world space
   // that they occupy.
   T domain;  // in meters
 
+  // Domain along y, for a domain that isn't square. Zero for the same as
+  // along x, which is domain.
+  T domainY;  // in meters
+
   // Some physical parameters.
   T gravity;         // in meters per second squared.
   T surfaceTension;  // in Newtons per meter
@@ -100,6 +109,11 @@ struct Parameters {
   T troughDampingBigWavelength;
   T troughDampingSoftWidth;
 
+  // Period, in seconds, after which the waves repeat exactly, by rounding
+  // each wave's angular frequency to a multiple of 2 pi / loopPeriod. Zero
+  // for waves that never repeat.
+  T loopPeriod;
+
   // Dispersion Stuff - Deep, FiniteDepth, Capillary
   struct Dispersion {
     DispersionType type;
@@ -152,7 +166,10 @@ struct Parameters {
   // Constructor
   Parameters()
     : resolutionPowerOfTwo(9)
+    , resolutionX(0)
+    , resolutionY(0)
     , domain(100.0)
+    , domainY(0.0)
     , gravity(9.81)
     , surfaceTension(0.074)
     , density(1000.0)
@@ -164,9 +181,19 @@ struct Parameters {
     , troughDamping(0.0)
     , troughDampingSmallWavelength(1.0)
     , troughDampingBigWavelength(4.0)
-    , troughDampingSoftWidth(2.0) {}
+    , troughDampingSoftWidth(2.0)
+    , loopPeriod(0.0) {}
 
   int resolution() const { return 1 << resolutionPowerOfTwo; }
+
+  // The grid the waves are simulated on, and the domain it covers.
+  GridSize gridSize() const {
+    return GridSize(resolutionX > 0 ? resolutionX : resolution(),
+                    resolutionY > 0 ? resolutionY : resolution());
+  }
+  Imath::Vec2<T> domainSize() const {
+    return Imath::Vec2<T>(domain, domainY > 0 ? domainY : domain);
+  }
 };
 
 //-*****************************************************************************
@@ -41,57 +41,554 @@
 #include "Basics.h"
 #include "Parameters.h"
 #include "InitialState.h"
+#include "CompactInitialState.h"
 #include "Stats.h"
 
 namespace EncinoWaves {
 
 //-*****************************************************************************
+// The fields a propagation makes, in the order their spectra are made and
+// transformed. The fields of a PropagatedState are stored in one slab, in
+// this order, so that they can all be produced by a single batched inverse
+// FFT. The spectral slab in Propagation uses the same order, with the Dxy
+// spectrum in the MinE slot, since MinE is computed in place from Dxx, Dyy
+// and Dxy. Dxx and Dyy come last: they are not outputs, and Propagation
+// transforms them into its own scratch with a second batched plan.
+enum PropagatedField {
+  kHeightField,
+  kDxField,
+  kDyField,
+  kMinEField,
+  kDxxField,
+  kDyyField,
+
+  kNumPropagatedFields
+};
+
+//-*****************************************************************************
+// How Propagation turns spectra into spatial fields. The real transform
+// does one c2r transform per field from half spectra. The packed complex
+// transform packs pairs of fields into full complex spectra and does one
+// c2c transform per pair, see PackedSpectralToPaddedSpatial2D. Both produce
+// the same PropagatedState, to within floating point error.
+enum PropagationTransform {
+  kRealPropagationTransform,
+  kPackedComplexPropagationTransform
+};
+
+//-*****************************************************************************
+// Bitmask of the fields a PropagatedState can hold, one bit per
+// PropagatedField, so that callers only pay for the fields they consume.
+enum PropagatedChannel {
+  kHeightChannel = 1 << kHeightField,
+  kDxChannel = 1 << kDxField,
+  kDyChannel = 1 << kDyField,
+  kMinEChannel = 1 << kMinEField,
+
+  kDisplacementChannels = kHeightChannel | kDxChannel | kDyChannel,
+  kAllChannels = kDisplacementChannels | kMinEChannel
+};
+
+//-*****************************************************************************
+// The fields MinE is computed from, which only live in Propagation's
+// scratch.
+enum { kMinEScratchFields = (1 << kDxxField) | (1 << kDyyField) };
+
+//-*****************************************************************************
+// Keeps only the channels a PropagatedState can hold.
+inline unsigned int ResolvePropagatedChannels(unsigned int i_channels) {
+  return i_channels & kAllChannels;
+}
+
+//-*****************************************************************************
+// The fields propagated to make the given channels.
+inline unsigned int PropagatedFieldsOf(unsigned int i_channels) {
+  unsigned int fields = ResolvePropagatedChannels(i_channels);
+  if (fields & kMinEChannel) {
+    fields |= kMinEScratchFields;
+  }
+  return fields;
+}
+
+//-*****************************************************************************
+inline int CountPropagatedChannels(unsigned int i_channels) {
+  int count = 0;
+  for (int f = 0; f < kNumPropagatedFields; ++f) {
+    if (i_channels & (1 << f)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+//-*****************************************************************************
+// Whether times i_a and i_b are the same frame of playback with frames
+// i_step apart: to within a thousandth of a step, or to within a few ulps
+// of the times themselves, since at large times (minutes, in float) the
+// rounding of a time alone exceeds a thousandth of a step.
+template <typename T> bool SameFrameTime(T i_a, T i_b, T i_step) {
+  const T scale = std::max(std::max(std::abs(i_a), std::abs(i_b)), i_step);
+  return std::abs(i_a - i_b) <=
+         std::max(T(1.0e-3) * i_step,
+                  T(8) * std::numeric_limits<T>::epsilon() * scale);
+}
+
+//-*****************************************************************************
+// Only the fields for the state's channels are allocated, in one slab, in
+// PropagatedField order. The references for the other fields all refer to
+// a single empty field.
 template <typename T> struct PropagatedState {
-  RealSpatialField2D<T> Height;
-  RealSpatialField2D<T> Dx;
-  RealSpatialField2D<T> Dy;
-  RealSpatialField2D<T> MinE;
-
-  explicit PropagatedState(const Parameters<T> &i_params)
-      : Height(i_params.resolutionPowerOfTwo, 1),
-        Dx(i_params.resolutionPowerOfTwo, 1),
-        Dy(i_params.resolutionPowerOfTwo, 1),
-        MinE(i_params.resolutionPowerOfTwo, 1) {}
-
-  explicit PropagatedState(int i_resolutionPowerOfTwo)
-      : Height(i_resolutionPowerOfTwo, 1), Dx(i_resolutionPowerOfTwo, 1),
-        Dy(i_resolutionPowerOfTwo, 1), MinE(i_resolutionPowerOfTwo, 1) {}
+  unsigned int Channels;
+  FieldSlab2D<RealSpatialField2D<T>> Fields;
+  RealSpatialField2D<T> Empty;
+
+  RealSpatialField2D<T> &Height;
+  RealSpatialField2D<T> &Dx;
+  RealSpatialField2D<T> &Dy;
+  RealSpatialField2D<T> &MinE;
+
+  explicit PropagatedState(const Parameters<T> &i_params,
+                           unsigned int i_channels = kAllChannels)
+      : PropagatedState(i_params.gridSize(), i_channels) {}
+
+  explicit PropagatedState(int i_resolutionPowerOfTwo,
+                           unsigned int i_channels = kAllChannels)
+      : PropagatedState(GridSize::Square(i_resolutionPowerOfTwo), i_channels) {
+  }
+
+  explicit PropagatedState(const GridSize &i_size,
+                           unsigned int i_channels = kAllChannels)
+      : Channels(ResolvePropagatedChannels(i_channels)),
+        Fields(CountPropagatedChannels(Channels), i_size, 1),
+        Height(field(kHeightField)), Dx(field(kDxField)), Dy(field(kDyField)),
+        MinE(field(kMinEField)) {
+    EWAV_ASSERT(Channels != 0, "Propagated state with no channels");
+  }
+
+  bool has(PropagatedField i_field) const {
+    return (Channels & (1 << i_field)) != 0;
+  }
+
+  // Index of a field in Fields, or -1 if the state doesn't have it.
+  int slot(PropagatedField i_field) const {
+    return has(i_field) ? CountPropagatedChannels(Channels &
+                                                  ((1 << i_field) - 1))
+                        : -1;
+  }
+
+  RealSpatialField2D<T> &field(PropagatedField i_field) {
+    return has(i_field) ? Fields[slot(i_field)] : Empty;
+  }
+
+  const RealSpatialField2D<T> &field(PropagatedField i_field) const {
+    return has(i_field) ? Fields[slot(i_field)] : Empty;
+  }
 };
 
 //-*****************************************************************************
-template <typename T> struct Propagation {
-  ComplexSpectralField2D<T> HSpec;
-  ComplexSpectralField2D<T> TempSpec;
-  RealSpatialField2D<T> TempSpat;
+// Some fields, in PropagatedField order, split into runs of fields that are
+// adjacent in a state's slab, or in the scratch Dxx and Dyy are made in.
+// Each run is transformed with one batched plan.
+struct PropagatedRuns {
+  int Fields[kNumPropagatedFields];
+  int NumFields;
+  int Begin[kNumPropagatedFields + 1];
+  int Slot[kNumPropagatedFields];
+  bool Scratch[kNumPropagatedFields];
+  int NumRuns;
+
+  template <typename T>
+  PropagatedRuns(unsigned int i_fields, const PropagatedState<T> &i_state)
+      : NumFields(0), NumRuns(0) {
+    int prevSlot = -2;
+    bool prevScratch = false;
+    for (int f = 0; f < kNumPropagatedFields; ++f) {
+      if (i_fields & (1 << f)) {
+        const bool scratch = ((1 << f) & kMinEScratchFields) != 0;
+        const int slot =
+            scratch ? f - kDxxField : i_state.slot(PropagatedField(f));
+        EWAV_ASSERT(slot >= 0, "Propagated state is missing a channel");
+        if (slot != prevSlot + 1 || scratch != prevScratch) {
+          Begin[NumRuns] = NumFields;
+          Slot[NumRuns] = slot;
+          Scratch[NumRuns] = scratch;
+          ++NumRuns;
+        }
+        Fields[NumFields++] = f;
+        prevSlot = slot;
+        prevScratch = scratch;
+      }
+    }
+    Begin[NumRuns] = NumFields;
+  }
 
-  ComplexSpectralField2D<T> HFiltSpec;
-  RealSpatialField2D<T> FiltHeight;
-  RealSpatialField2D<T> FiltDx;
-  RealSpatialField2D<T> FiltDy;
-  RealSpatialField2D<T> FiltMinE;
+  int count(int i_run) const { return Begin[i_run + 1] - Begin[i_run]; }
+};
 
-  SpectralToPaddedSpatial2D<T> Converter;
+//-*****************************************************************************
+template <typename T> struct PropagationPhasor;
+template <typename T> struct InitialSpectra;
 
+//-*****************************************************************************
+template <typename T> struct Propagation {
+  typedef BatchSpectralToPaddedSpatial2D<T> converter_type;
+  typedef PackedSpectralToPaddedSpatial2D<T> packed_converter_type;
+
+  // Spectra of the fields being computed, compacted in PropagatedField
+  // order, with the Dxy spectrum in place of MinE. Only as many as the
+  // channels propagated so far have needed, see spectra.
+  std::unique_ptr<FieldSlab2D<ComplexSpectralField2D<T>>> Spectra;
+
+  // The filtered height spectrum, and the filtered fields trough damping
+  // reads, only allocated once damping is on, see allocateDamping.
+  std::unique_ptr<ComplexSpectralField2D<T>> HFiltSpec;
+  std::unique_ptr<PropagatedState<T>> FiltState;
+
+  // Dxx and Dyy, in that order, which MinE is computed from. Made once, the
+  // first time MinE is propagated, and reused by every propagate after it,
+  // so that states don't hold them. With trough damping they are left
+  // holding the filtered Dxx and Dyy.
+  std::unique_ptr<FieldSlab2D<RealSpatialField2D<T>>> MinEScratch;
+
+  // One transform per number of fields, made on first use.
+  std::unique_ptr<converter_type> Converters[kNumPropagatedFields + 1];
+
+  // Full packed spectra and their transforms, only allocated once the
+  // packed complex transform has been selected. The scratch fields take
+  // the last transform of an odd run of fields.
+  std::unique_ptr<FieldSlab2D<RealSpatialField2D<T>>> PackedSpectra;
+  std::unique_ptr<FieldSlab2D<RealSpatialField2D<T>>> PackedScratch;
+  std::unique_ptr<packed_converter_type>
+      PackedConverters[kNumPropagatedFields + 1];
+
+  // Table of phasors of looping playback, see setLoopFrames.
+  std::vector<std::complex<T>> LoopPhasors;
+
+  // Spectra of every frame of a pass of propagateBatch, frame by frame,
+  // each laid out like Spectra. Only allocated once a batch is propagated.
+  std::unique_ptr<FieldSlab2D<ComplexSpectralField2D<T>>> BatchSpectra;
+
+  // Dxx and Dyy of every frame of a pass of propagateBatch, laid out like
+  // MinEScratch frame by frame. Only allocated once a batch makes MinE.
+  std::unique_ptr<FieldSlab2D<RealSpatialField2D<T>>> BatchMinEScratch;
+
+  // Fixed time step playback state, see setFixedTimeStep. Holds the current
+  // and next phasors, and the per-bin step, only allocated once enabled.
+  std::unique_ptr<FieldSlab2D<ComplexSpectralField2D<T>>> Phasors;
+  T TimeStep;
+  int ResyncInterval;
+  int StepsSinceResync;
+  int CurrentPhasor;
+  T LastTime;
+  std::uint64_t LastGeneration;
+
+  // The grid, and the domain it covers along x and y.
+  GridSize Size;
   T Domain;
+  T DomainY;
+  int NumThreads;
+  FftPlanOptions PlanOptions;
+  PropagationTransform Transform;
+
+  // The arena propagate runs in, or null to run in the caller's.
+  std::unique_ptr<tbb::task_arena> OwnedArena;
+  tbb::task_arena *Arena;
+
+  // Reduced-resolution trough damping, see setReducedTroughDamping. The
+  // smaller propagation, and the band of the damped fields on its grid,
+  // are made on first use.
+  bool ReduceTroughDamping;
+  std::unique_ptr<Propagation<T>> ReducedDamping;
+  std::unique_ptr<PropagatedState<T>> ReducedBand;
+
+  // A positive i_nthreads is a thread budget: this makes its own arena of
+  // that many threads, and plans its transforms for that many, so several
+  // instances can run side by side without each taking every core. By
+  // default propagate runs in the caller's arena, and the transforms are
+  // planned for all cores.
+  //
+  // The plan options apply to every transform this makes. Wisdom, if any,
+  // is loaded as each transform is first needed.
+  explicit Propagation(
+      const Parameters<T> &i_params, int i_nthreads = -1,
+      PropagationTransform i_transform = kRealPropagationTransform,
+      const FftPlanOptions &i_planOptions = FftPlanOptions())
+      : TimeStep(0), ResyncInterval(0), StepsSinceResync(0), CurrentPhasor(0),
+        LastTime(0), LastGeneration(0), Size(i_params.gridSize()),
+        Domain(i_params.domainSize()[0]), DomainY(i_params.domainSize()[1]),
+        NumThreads(i_nthreads), PlanOptions(i_planOptions),
+        Transform(kRealPropagationTransform), Arena(nullptr),
+        ReduceTroughDamping(false) {
+    if (i_nthreads > 0) {
+      OwnedArena.reset(new tbb::task_arena(i_nthreads));
+      Arena = OwnedArena.get();
+    }
+    setTransform(i_transform);
+  }
+
+  // Switch between the real and packed complex transforms. Can be called
+  // between any two calls to propagate.
+  void setTransform(PropagationTransform i_transform) {
+    if (i_transform == kPackedComplexPropagationTransform && !PackedSpectra) {
+      PackedSpectra.reset(new FieldSlab2D<RealSpatialField2D<T>>(
+          kNumPropagatedFields, Size, 0));
+    }
+    Transform = i_transform;
+  }
+
+  // Spectra, grown to at least i_count fields.
+  FieldSlab2D<ComplexSpectralField2D<T>> &spectra(int i_count) {
+    if (!Spectra || Spectra->count() < i_count) {
+      Spectra.reset(new FieldSlab2D<ComplexSpectralField2D<T>>(i_count, Size));
+    }
+    return *Spectra;
+  }
 
-  explicit Propagation(const Parameters<T> &i_params, int i_nthreads = -1)
-      : HSpec(i_params.resolutionPowerOfTwo),
-        TempSpec(i_params.resolutionPowerOfTwo),
-        TempSpat(i_params.resolutionPowerOfTwo, 1),
-        HFiltSpec(i_params.resolutionPowerOfTwo),
-        FiltHeight(i_params.resolutionPowerOfTwo, 1),
-        FiltDx(i_params.resolutionPowerOfTwo, 1),
-        FiltDy(i_params.resolutionPowerOfTwo, 1),
-        FiltMinE(i_params.resolutionPowerOfTwo, 1),
-        Converter(HSpec, TempSpat, i_nthreads), Domain(i_params.domain) {}
+  // Allocates HFiltSpec, and FiltState with at least i_filtChannels, if any.
+  void allocateDamping(unsigned int i_filtChannels) {
+    if (!HFiltSpec) {
+      HFiltSpec.reset(new ComplexSpectralField2D<T>(Size));
+    }
+    const unsigned int channels = ResolvePropagatedChannels(i_filtChannels);
+    const unsigned int have = FiltState ? FiltState->Channels : 0u;
+    if ((channels & have) != channels) {
+      FiltState.reset(new PropagatedState<T>(Size, channels | have));
+    }
+  }
+
+  // MinEScratch, made if it hasn't been.
+  FieldSlab2D<RealSpatialField2D<T>> &minEScratch() {
+    if (!MinEScratch) {
+      MinEScratch.reset(new FieldSlab2D<RealSpatialField2D<T>>(2, Size, 1));
+    }
+    return *MinEScratch;
+  }
+
+  // The transforms are planned on scratch fields, since measuring plans
+  // overwrites the arrays being planned on.
+  converter_type &converter(int i_count) {
+    if (!Converters[i_count]) {
+      FieldSlab2D<RealSpatialField2D<T>> scratch(i_count, Size, 1);
+      Converters[i_count].reset(new converter_type(
+          spectra(i_count), scratch, NumThreads, i_count, PlanOptions));
+    }
+    return *Converters[i_count];
+  }
+
+  packed_converter_type &packedConverter(int i_count) {
+    if (!PackedConverters[i_count]) {
+      if ((i_count % 2) && !PackedScratch) {
+        PackedScratch.reset(
+            new FieldSlab2D<RealSpatialField2D<T>>(2, Size, 1));
+      }
+      FieldSlab2D<RealSpatialField2D<T>> scratch(i_count, Size, 1);
+      PackedConverters[i_count].reset(new packed_converter_type(
+          *PackedSpectra, scratch, NumThreads, i_count, PackedScratch.get(),
+          PlanOptions));
+    }
+    return *PackedConverters[i_count];
+  }
+
+  // Fixed time step playback. While enabled, a call to propagate exactly one
+  // time step after the previous call advances a per-bin phasor by a
+  // precomputed exp(-i*omega*dt), instead of evaluating cos and sin of
+  // omega*t for every bin. The phase is re-evaluated exactly every
+  // i_resyncInterval steps, to bound the drift, and whenever the time jumps
+  // or the initial state changes. Calling this again also forces a resync.
+  // A time step of zero turns it off.
+  void setFixedTimeStep(T i_timeStep, int i_resyncInterval = 32) {
+    EWAV_ASSERT(i_timeStep >= 0 && i_resyncInterval > 0,
+                "Bad fixed time step: " << i_timeStep
+                                        << ", resync interval: "
+                                        << i_resyncInterval);
+    if (i_timeStep > 0 && !Phasors) {
+      Phasors.reset(new FieldSlab2D<ComplexSpectralField2D<T>>(3, Size));
+    }
+    TimeStep = i_timeStep;
+    ResyncInterval = i_resyncInterval;
+    resetTimeStep();
+  }
+
+  // Forces the next fixed time step to resync. Propagate already does when
+  // given a different initial state, so this is only needed after changing
+  // the omegas of a state in place.
+  void resetTimeStep() {
+    StepsSinceResync = 0;
+    LastGeneration = 0;
+  }
+
+  // The arena propagate runs in, to share with InitialState and
+  // ComputeNormals so that a whole ocean keeps to one thread budget.
+  tbb::task_arena *arena() const { return Arena; }
+
+  // Runs propagate in another arena, such as one shared by several
+  // instances, or in the caller's if null. The arena must outlive this.
+  void setArena(tbb::task_arena *i_arena) { Arena = i_arena; }
+
+  // Looping playback, for initial states made with a loop period. While
+  // enabled, a time that falls on one of i_loopFrames evenly spaced frames
+  // of the loop has its phases looked up in a table, instead of evaluating
+  // cos and sin of omega*t for every bin. Frame f and frame f plus
+  // i_loopFrames are then bit for bit the same, so a loop can be cached
+  // once computed. Looping takes precedence over fixed time step playback.
+  // Zero frames turns it off.
+  void setLoopFrames(int i_loopFrames) {
+    EWAV_ASSERT(i_loopFrames >= 0, "Bad loop frames: " << i_loopFrames);
+    LoopPhasors.resize(i_loopFrames);
+    for (int j = 0; j < i_loopFrames; ++j) {
+      const double angle = M_TAU * double(j) / double(i_loopFrames);
+      LoopPhasors[j] = std::complex<T>(T(std::cos(angle)), T(-std::sin(angle)));
+    }
+  }
+
+  // Reduced-resolution trough damping. Trough damping takes away a band of
+  // wavelengths, no shorter than troughDampingSmallWavelength, wherever the
+  // waves outside it are in a trough. While enabled, the band and the
+  // interpolant are propagated on the coarsest grid, halving the full one a
+  // number of times, whose shortest wavelength is still within the band,
+  // and upsampled bilinearly onto the full grid, instead of propagating
+  // another six fields at full resolution. The interpolant then only sees
+  // the waves that resolution has, and the band loses whatever of its soft
+  // edge is shorter still. So this is a visibly different damping, not an
+  // equivalent one. On a 512 grid, the RMS difference of the displacements
+  // from full damping is 18% to 35% of the RMS of the damping itself, more
+  // the smaller the reduced grid (test_ewav_Propagation). In exchange, a
+  // frame costs about what an undamped one does. bench_ewav_TroughDamping,
+  // with FFTW, gives 67 ms reduced, 68 ms undamped and 130 ms damped in
+  // full at N of 1024, and 279 ms, 353 ms and 588 ms at 2048. Where no
+  // smaller grid has the band, damping is done in full.
+  void setReducedTroughDamping(bool i_reduced) {
+    ReduceTroughDamping = i_reduced;
+    if (!i_reduced) {
+      ReducedDamping.reset();
+      ReducedBand.reset();
+    }
+  }
+
+  // The grid reduced-resolution trough damping propagates on for these
+  // parameters. Can be the full grid.
+  GridSize reducedTroughDampingSize(const Parameters<T> &i_params) const {
+    const T smallWavelength = i_params.troughDampingSmallWavelength;
+    GridSize size = Size;
+    while ((size.Width % 2) == 0 && (size.Height % 2) == 0 &&
+           size.Width >= 16 && size.Height >= 16 &&
+           T(4) * Domain <= smallWavelength * T(size.Width) &&
+           T(4) * DomainY <= smallWavelength * T(size.Height)) {
+      size = GridSize(size.Width / 2, size.Height / 2);
+    }
+    return size;
+  }
 
+  // Propagates the channels in i_channels that o_pstate has. Other fields
+  // of o_pstate are left alone.
   void propagate(const Parameters<T> &i_params, const InitialState<T> &i_istate,
-                 PropagatedState<T> &o_pstate, T i_time);
+                 PropagatedState<T> &o_pstate, T i_time,
+                 unsigned int i_channels = kAllChannels) {
+    ExecuteInArena(Arena, [&] {
+      propagateInArena(i_params, i_istate, o_pstate, i_time, i_channels);
+    });
+  }
+
+  // The body of propagate, run in the current arena.
+  void propagateInArena(const Parameters<T> &i_params,
+                        const InitialState<T> &i_istate,
+                        PropagatedState<T> &o_pstate, T i_time,
+                        unsigned int i_channels) {
+    propagateInArena(i_params, InitialSpectra<T>(i_istate), o_pstate, i_time,
+                     i_channels);
+  }
+
+  // Propagates a CompactInitialState, unpacking it as it goes.
+  void propagate(const Parameters<T> &i_params,
+                 const CompactInitialState<T> &i_istate,
+                 PropagatedState<T> &o_pstate, T i_time,
+                 unsigned int i_channels = kAllChannels) {
+    ExecuteInArena(Arena, [&] {
+      propagateInArena(i_params, InitialSpectra<T>(i_istate), o_pstate,
+                       i_time, i_channels);
+    });
+  }
+
+  // Propagates a blend of two initial states, i_blend of the way from
+  // i_istateA to i_istateB, for weather that changes over a shot, at about
+  // the cost of propagate. The states must share their random draws, as
+  // when made from the same InitialStateNoise, so each bin only differs in
+  // its envelope. The blend is of energy: each bin's squared amplitude is
+  // (1 - i_blend) |A|^2 + i_blend |B|^2, so the wave height variance moves
+  // linearly between the two. The waves travel with the omegas of
+  // i_istateA, so the states should share their dispersion, as when only
+  // the wind, fetch, spectrum, spreading or filter differ.
+  void propagateBlend(const Parameters<T> &i_params,
+                      const InitialState<T> &i_istateA,
+                      const InitialState<T> &i_istateB, T i_blend,
+                      PropagatedState<T> &o_pstate, T i_time,
+                      unsigned int i_channels = kAllChannels) {
+    EWAV_ASSERT(i_istateB.Size == i_istateA.Size &&
+                    i_istateB.LoopPeriod == i_istateA.LoopPeriod,
+                "Mismatched initial states in blended wave propagation.");
+    ExecuteInArena(Arena, [&] {
+      propagateInArena(i_params,
+                       InitialSpectra<T>(i_istateA, &i_istateB, i_blend),
+                       o_pstate, i_time, i_channels);
+    });
+  }
+
+  // Propagates whichever initial spectra i_initial reads, in the current
+  // arena.
+  void propagateInArena(const Parameters<T> &i_params,
+                        const InitialSpectra<T> &i_initial,
+                        PropagatedState<T> &o_pstate, T i_time,
+                        unsigned int i_channels);
+
+  // Propagates i_numFrames frames, frame f to time i_times[f] into
+  // *o_states[f], which must all have the same channels. Frames are done
+  // i_framesPerPass at a time: a single pass over the initial state makes
+  // the spectra of all of them, then their transforms run concurrently.
+  // That takes i_framesPerPass times the spectra memory of propagate.
+  //
+  // Batches always use the real transform, and leave fixed time step
+  // playback alone. Trough damping needs statistics of each frame, so with
+  // damping this just propagates each frame in turn, evaluating the phases
+  // directly, and puts the fixed time step state back afterwards.
+  void propagateBatch(const Parameters<T> &i_params,
+                      const InitialState<T> &i_istate, const T *i_times,
+                      PropagatedState<T> *const *o_states, int i_numFrames,
+                      unsigned int i_channels = kAllChannels,
+                      int i_framesPerPass = 4) {
+    ExecuteInArena(Arena, [&] {
+      propagateBatchInArena(i_params, i_istate, i_times, o_states,
+                            i_numFrames, i_channels, i_framesPerPass);
+    });
+  }
+
+  // The body of propagateBatch, run in the current arena.
+  void propagateBatchInArena(const Parameters<T> &i_params,
+                             const InitialState<T> &i_istate,
+                             const T *i_times,
+                             PropagatedState<T> *const *o_states,
+                             int i_numFrames, unsigned int i_channels,
+                             int i_framesPerPass);
+
+  // Trough damping of i_dampedChannels of o_pstate, propagated on the
+  // smaller grid i_size, from the unfiltered height spectrum in HFiltSpec.
+  void dampTroughsReduced(const Parameters<T> &i_params,
+                          const SmoothInvertibleBandPassFilter<T> &i_filter,
+                          const PropagationPhasor<T> &i_phasor,
+                          const GridSize &i_size,
+                          unsigned int i_dampedChannels,
+                          PropagatedState<T> &o_pstate);
+
+  // Makes the spectra of i_fields, from the initial spectra if i_initial is
+  // given, otherwise from HFiltSpec, and transforms them into o_state, and
+  // Dxx and Dyy into MinEScratch. With the initial spectra, i_keepHeight
+  // also keeps the height spectrum in HFiltSpec, filtered by i_filter, or
+  // unfiltered if that is null.
+  void computeChannels(unsigned int i_fields,
+                       const InitialSpectra<T> *i_initial,
+                       const PropagationPhasor<T> &i_phasor,
+                       bool i_keepHeight,
+                       const SmoothInvertibleBandPassFilter<T> *i_filter,
+                       PropagatedState<T> &o_state);
 };
 
 //-*****************************************************************************
@@ -250,6 +747,525 @@ template <typename T> struct DXYSPEC {
   }
 };
 
+//-*****************************************************************************
+// Evaluates the height spectrum and its five derivative spectra at one bin,
+// in slab order (Dxy goes in the MinE slot). Dx and Dy are not true
+// derivatives, see DXSPEC and DYSPEC above.
+template <typename T>
+inline void EvaluatePropagatedSpectra(const Imath::Vec2<T> &i_k, T i_kMag,
+                                      const std::complex<T> &i_h,
+                                      std::complex<T> *o_specs) {
+  const T invKMag = T(1) / i_kMag;
+  const T kx = i_k[0] * invKMag;
+  const T ky = i_k[1] * invKMag;
+
+  o_specs[kHeightField] = i_h;
+
+  // -i * kx * h, and -i * ky * h
+  o_specs[kDxField] = std::complex<T>(kx * i_h.imag(), -kx * i_h.real());
+  o_specs[kDyField] = std::complex<T>(ky * i_h.imag(), -ky * i_h.real());
+
+  o_specs[kDxxField] = (kx * i_k[0]) * i_h;
+  o_specs[kDyyField] = (ky * i_k[1]) * i_h;
+  o_specs[kMinEField] = (kx * i_k[1]) * i_h;
+}
+
+//-*****************************************************************************
+// The height spectrum and its five derivative spectra, written together so
+// that the wavenumber and its inverse magnitude are only computed once per
+// bin. Indexed by PropagatedField, with Dxy in the MinE slot. Spectra that
+// aren't wanted are null, and are skipped.
+template <typename T> struct PropagatedSpectra {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  complex_type *SpecProp[kNumPropagatedFields];
+
+  void zero(std::size_t i_index) const {
+    for (int f = 0; f < kNumPropagatedFields; ++f) {
+      if (SpecProp[f]) {
+        SpecProp[f][i_index] = complex_type(0.0, 0.0);
+      }
+    }
+  }
+
+  void set(const vec_type &i_k, real_type i_kMag, const complex_type &i_h,
+           std::size_t i_index) const {
+    complex_type specs[kNumPropagatedFields];
+    EvaluatePropagatedSpectra(i_k, i_kMag, i_h, specs);
+    for (int f = 0; f < kNumPropagatedFields; ++f) {
+      if (SpecProp[f]) {
+        SpecProp[f][i_index] = specs[f];
+      }
+    }
+  }
+};
+
+//-*****************************************************************************
+// Writes the spectra of one half-spectrum bin into the packed full spectra
+// used by PackedSpectralToPaddedSpatial2D. Each entry of Pairs is a pair of
+// PropagatedFields (the second may be -1, for none), which is packed as
+// Z = A + iB, split into real and imaginary arrays of Nx by Ny.
+//
+// Bins with 0 < kx < Nx/2 also write the conjugate bin at -k, which the
+// half spectrum leaves implicit. The kx = 0 column, and the kx = Nx/2
+// column of an even Nx, store both k and -k, and nothing makes them
+// Hermitian, so each of those bins is averaged with the conjugate of its
+// partner at -k. That is the same projection the c2r transform makes
+// implicitly, so the two transforms agree.
+template <typename T> struct PackedPropagatedSpectra {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  real_type *Data;
+  std::size_t FieldStride;
+  int Nx;
+  int Ny;
+  int NumPairs;
+  int Pairs[kNumPropagatedFields][2];
+
+  std::size_t halfWidth() const { return std::size_t(Nx / 2) + 1; }
+
+  // True if the bin at i_index has its -k partner inside the half spectrum.
+  bool selfConjugateColumn(std::size_t i_index) const {
+    const int x = int(i_index % halfWidth());
+    return x == 0 || (x * 2 == Nx);
+  }
+
+  // Index of the -k partner of a bin in a self conjugate column.
+  std::size_t partnerIndex(std::size_t i_index) const {
+    const std::size_t width = halfWidth();
+    const std::size_t y = i_index / width;
+    return (((Ny - y) % Ny) * width) + (i_index % width);
+  }
+
+  void zero(std::size_t i_index) const {
+    const complex_type specs[kNumPropagatedFields] = {};
+    store(int(i_index % halfWidth()), int(i_index / halfWidth()), specs);
+  }
+
+  // i_hPartner is only used in the self conjugate columns, where it must be
+  // the height spectrum at partnerIndex(i_index).
+  void set(const vec_type &i_k, real_type i_kMag, const complex_type &i_h,
+           const complex_type &i_hPartner, std::size_t i_index) const {
+    const int x = int(i_index % halfWidth());
+    const int y = int(i_index / halfWidth());
+
+    complex_type specs[kNumPropagatedFields];
+    EvaluatePropagatedSpectra(i_k, i_kMag, i_h, specs);
+
+    if (selfConjugateColumn(i_index)) {
+      // The partner's ky is negated, except in row 0 and the Ny/2 row of
+      // an even Ny.
+      const vec_type kPartner(
+          i_k[0], (y == 0 || (y * 2 == Ny)) ? i_k[1] : -i_k[1]);
+      complex_type partner[kNumPropagatedFields];
+      EvaluatePropagatedSpectra(kPartner, i_kMag, i_hPartner, partner);
+      for (int f = 0; f < kNumPropagatedFields; ++f) {
+        specs[f] = real_type(0.5) * (specs[f] + std::conj(partner[f]));
+      }
+      store(x, y, specs);
+    } else {
+      store(x, y, specs);
+      for (int f = 0; f < kNumPropagatedFields; ++f) {
+        specs[f] = std::conj(specs[f]);
+      }
+      store(Nx - x, (Ny - y) % Ny, specs);
+    }
+  }
+
+  void store(int i_x, int i_y, const complex_type *i_specs) const {
+    const std::size_t offset = (std::size_t(i_y) * Nx) + i_x;
+    for (int p = 0; p < NumPairs; ++p) {
+      const complex_type &a = i_specs[Pairs[p][0]];
+      const complex_type b =
+          Pairs[p][1] < 0 ? complex_type(0.0, 0.0) : i_specs[Pairs[p][1]];
+      real_type *re = Data + (std::size_t(2 * p) * FieldStride);
+      real_type *im = re + FieldStride;
+      re[offset] = a.real() - b.imag();
+      im[offset] = a.imag() + b.real();
+    }
+  }
+};
+
+//-*****************************************************************************
+// The per-bin phase factor exp(-i*omega*t) that propagates the initial state.
+// With no phasors it is evaluated directly. With only NextPhasor, it is
+// evaluated directly and stored, along with the step exp(-i*omega*dt). With
+// PrevPhasor too, it is the previous phasor advanced by one step, with no
+// trig at all. Evaluation never depends on what has been stored, so a bin
+// may be evaluated by any number of threads.
+template <typename T> struct PropagationPhasor {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+
+  const real_type *Omega;
+  real_type Time;
+  real_type TimeStep;
+
+  // Nonzero when Omega only has rows 0 to OmegaFoldRows / 2, of
+  // OmegaStride bins, as in CompactInitialState. Row j then has the omegas
+  // of row OmegaFoldRows - j.
+  int OmegaFoldRows;
+  std::size_t OmegaStride;
+
+  const complex_type *PrevPhasor;
+  complex_type *NextPhasor;
+  complex_type *PhasorStep;
+
+  // Looping playback. With omegas quantized to multiples of 2 pi / period,
+  // the phase of frame f of a loop of LoopFrames frames is a lookup of
+  // entry (m * f) mod LoopFrames of a table of exp(-2 pi i j / LoopFrames),
+  // where m is the bin's multiple, omega * LoopOmegaScale.
+  const complex_type *LoopTable;
+  int LoopFrames;
+  int LoopFrame;
+  real_type LoopOmegaScale;
+
+  PropagationPhasor()
+      : Omega(nullptr), Time(0), TimeStep(0), OmegaFoldRows(0),
+        OmegaStride(0), PrevPhasor(nullptr),
+        NextPhasor(nullptr), PhasorStep(nullptr), LoopTable(nullptr),
+        LoopFrames(0), LoopFrame(0), LoopOmegaScale(0) {}
+
+  real_type omega(std::size_t i_index) const {
+    if (!OmegaFoldRows) {
+      return Omega[i_index];
+    }
+    const std::size_t j = i_index / OmegaStride;
+    const std::size_t folded =
+        std::min(j, std::size_t(OmegaFoldRows) - j);
+    return Omega[(folded * OmegaStride) + (i_index - (j * OmegaStride))];
+  }
+
+  complex_type operator()(std::size_t i_index) const {
+    if (LoopTable) {
+      const long long m = std::llround(omega(i_index) * LoopOmegaScale);
+      return LoopTable[(m * LoopFrame) % LoopFrames];
+    }
+    if (PrevPhasor) {
+      return PrevPhasor[i_index] * PhasorStep[i_index];
+    }
+    const real_type omegaT = omega(i_index) * Time;
+    return complex_type(std::cos(omegaT), -std::sin(omegaT));
+  }
+
+  void store(std::size_t i_index, const complex_type &i_phasor) const {
+    if (NextPhasor) {
+      NextPhasor[i_index] = i_phasor;
+      if (!PrevPhasor) {
+        const real_type omegaDt = omega(i_index) * TimeStep;
+        PhasorStep[i_index] =
+            complex_type(std::cos(omegaDt), -std::sin(omegaDt));
+      }
+    }
+  }
+};
+
+//-*****************************************************************************
+// The initial spectra a propagation reads: an initial state's, a compact
+// initial state's, unpacked per bin, or an energy blend of two initial
+// states which share their random draws. Those only differ in their real,
+// non-negative envelopes, so a blended bin is either bin scaled to the
+// blended amplitude, sqrt((1 - t) |A|^2 + t |B|^2). The sum A + B has their
+// common phase, and is only zero where both are.
+template <typename T> struct InitialSpectra {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+
+  GridSize Size;
+  real_type LoopPeriod;
+  std::uint64_t Generation;
+
+  // Omegas, folded as in PropagationPhasor if OmegaFoldRows is nonzero.
+  const real_type *Omega;
+  int OmegaFoldRows;
+
+  const complex_type *HSpecPos;
+  const complex_type *HSpecNeg;
+
+  // Null unless blending.
+  const complex_type *HSpecPosB;
+  const complex_type *HSpecNegB;
+  real_type WeightA;
+  real_type WeightB;
+
+  // Null unless compact.
+  const CompactInitialState<T> *Compact;
+
+  InitialSpectra(const InitialState<T> &i_istate,
+                 const InitialState<T> *i_istateB = nullptr,
+                 real_type i_blend = real_type(0))
+      : Size(i_istate.Size), LoopPeriod(i_istate.LoopPeriod),
+        Generation(i_istate.Generation), Omega(i_istate.Omega.cdata()),
+        OmegaFoldRows(0),
+        HSpecPos(i_istate.HSpectralPos.cdata()),
+        HSpecNeg(i_istate.HSpectralNeg.cdata()),
+        HSpecPosB(i_istateB ? i_istateB->HSpectralPos.cdata() : nullptr),
+        HSpecNegB(i_istateB ? i_istateB->HSpectralNeg.cdata() : nullptr),
+        WeightA(real_type(1) - i_blend), WeightB(i_blend), Compact(nullptr) {}
+
+  explicit InitialSpectra(const CompactInitialState<T> &i_istate)
+      : Size(i_istate.Size), LoopPeriod(i_istate.LoopPeriod),
+        Generation(i_istate.Generation), Omega(i_istate.Omega.data()),
+        OmegaFoldRows(i_istate.Size.Height),
+        HSpecPos(nullptr), HSpecNeg(nullptr), HSpecPosB(nullptr),
+        HSpecNegB(nullptr), WeightA(1), WeightB(0), Compact(&i_istate) {}
+
+  static complex_type blend(const complex_type &i_a, const complex_type &i_b,
+                            real_type i_weightA, real_type i_weightB) {
+    const complex_type sum = i_a + i_b;
+    const real_type sumNorm = std::norm(sum);
+    if (!(sumNorm > real_type(0))) {
+      return complex_type(0.0, 0.0);
+    }
+    const real_type norm =
+        (i_weightA * std::norm(i_a)) + (i_weightB * std::norm(i_b));
+    return std::sqrt(norm / sumNorm) * sum;
+  }
+
+  complex_type pos(std::size_t i_index) const {
+    if (Compact) {
+      return Compact->unpack(Compact->PackedPos[i_index]);
+    }
+    return HSpecPosB
+               ? blend(HSpecPos[i_index], HSpecPosB[i_index], WeightA, WeightB)
+               : HSpecPos[i_index];
+  }
+
+  complex_type neg(std::size_t i_index) const {
+    if (Compact) {
+      return Compact->unpack(Compact->PackedNeg[i_index]);
+    }
+    return HSpecNegB
+               ? blend(HSpecNeg[i_index], HSpecNegB[i_index], WeightA, WeightB)
+               : HSpecNeg[i_index];
+  }
+
+  // The height spectrum of the bin at i_index, propagated by the phasor
+  // i_fwd.
+  complex_type propagated(std::size_t i_index,
+                          const complex_type &i_fwd) const {
+    return (pos(i_index) * i_fwd) + (neg(i_index) * std::conj(i_fwd));
+  }
+};
+
+//-*****************************************************************************
+// Fused single pass over the half-spectrum which reads the initial state once
+// per bin and writes the propagated height spectrum along with any of its
+// derivative spectra. If HFiltSpecProp is given, the height spectrum is also
+// kept there for trough damping, filtered by Filter, or unfiltered if there
+// is no filter.
+template <typename T> struct PROPSPECS {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  InitialSpectra<T> Initial;
+  PropagationPhasor<T> Phasor;
+  const SmoothInvertibleBandPassFilter<T> *Filter;
+
+  complex_type *HFiltSpecProp;
+  PropagatedSpectra<T> Specs;
+
+  void operator()(std::size_t i_index) {
+    Specs.zero(i_index);
+    if (HFiltSpecProp) {
+      HFiltSpecProp[i_index] = complex_type(0.0, 0.0);
+    }
+  }
+
+  void operator()(const vec_type &i_k, real_type i_kMag, real_type i_dK,
+                  std::size_t i_index) {
+    const complex_type fwd = Phasor(i_index);
+    Phasor.store(i_index, fwd);
+
+    const complex_type hs = Initial.propagated(i_index, fwd);
+    EWAV_ASSERT(std::isfinite(hs.real()) && std::isfinite(hs.imag()),
+                "Bad hspec: " << hs << " at index: " << i_index);
+
+    Specs.set(i_k, i_kMag, hs, i_index);
+    if (HFiltSpecProp) {
+      HFiltSpecProp[i_index] = Filter ? (*Filter)(i_kMag) * hs : hs;
+    }
+  }
+};
+
+//-*****************************************************************************
+// Fused single pass which reads an already propagated height spectrum once
+// per bin, and writes it along with any of its derivative spectra.
+template <typename T> struct DERIVSPECS {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  const complex_type *HSpecIn;
+  PropagatedSpectra<T> Specs;
+
+  void operator()(std::size_t i_index) { Specs.zero(i_index); }
+
+  void operator()(const vec_type &i_k, real_type i_kMag, real_type i_dK,
+                  std::size_t i_index) {
+    Specs.set(i_k, i_kMag, HSpecIn[i_index], i_index);
+  }
+};
+
+//-*****************************************************************************
+// Makes the spectrum of reduced-resolution trough damping on an Mx by My
+// grid, from the unfiltered propagated height spectrum on the full Nx by Ny
+// grid, which has every wavenumber of the smaller grid. Keeps the waves the
+// filter passes, or, for the complement, the band of waves that trough
+// damping removes. The Nyquist row and column of the smaller grid, which the
+// full grid splits into two wavenumbers, are left out.
+template <typename T> struct DAMPINGSPEC {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  const complex_type *HSpecIn;
+  complex_type *HSpecOut;
+  const SmoothInvertibleBandPassFilter<T> *Filter;
+  bool Complement;
+  int Nx;
+  int Ny;
+  int Mx;
+  int My;
+
+  void operator()(std::size_t i_index) { HSpecOut[i_index] = complex_type(0); }
+
+  void operator()(const vec_type &i_k, real_type i_kMag, real_type i_dK,
+                  std::size_t i_index) {
+    const std::size_t mWidth = std::size_t(Mx / 2) + 1;
+    const int i = int(i_index % mWidth);
+    const int j = int(i_index / mWidth);
+    if (i * 2 == Mx || j * 2 == My) {
+      HSpecOut[i_index] = complex_type(0);
+      return;
+    }
+    const int fullJ = j <= My / 2 ? j : j - My + Ny;
+    const std::size_t fullIndex =
+        (std::size_t(fullJ) * (std::size_t(Nx / 2) + 1)) + std::size_t(i);
+    const real_type f = (*Filter)(i_kMag);
+    HSpecOut[i_index] =
+        (Complement ? real_type(1) - f : f) * HSpecIn[fullIndex];
+  }
+};
+
+//-*****************************************************************************
+// PROPSPECS for several frames at once. Reads the initial state once per bin
+// and writes the propagated spectra of every frame. When the times are
+// evenly spaced, each frame's phasor is the previous one rotated by a per
+// bin step, so only two phases are evaluated per bin, however many frames.
+template <typename T> struct BATCHPROPSPECS {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  const complex_type *HSpecPos;
+  const complex_type *HSpecNeg;
+  const real_type *Omega;
+  const real_type *Times;
+  int NumFrames;
+  bool EvenlySpaced;
+  const PropagatedSpectra<T> *Specs;
+
+  static complex_type phasor(real_type i_omegaT) {
+    return complex_type(std::cos(i_omegaT), -std::sin(i_omegaT));
+  }
+
+  void operator()(std::size_t i_index) {
+    for (int f = 0; f < NumFrames; ++f) {
+      Specs[f].zero(i_index);
+    }
+  }
+
+  void operator()(const vec_type &i_k, real_type i_kMag, real_type i_dK,
+                  std::size_t i_index) {
+    const complex_type hPos = HSpecPos[i_index];
+    const complex_type hNeg = HSpecNeg[i_index];
+    const real_type omega = Omega[i_index];
+
+    complex_type fwd = phasor(omega * Times[0]);
+    const complex_type step = (EvenlySpaced && NumFrames > 1)
+                                  ? phasor(omega * (Times[1] - Times[0]))
+                                  : complex_type(1, 0);
+    for (int f = 0; f < NumFrames; ++f) {
+      if (f > 0) {
+        fwd = EvenlySpaced ? fwd * step : phasor(omega * Times[f]);
+      }
+      const complex_type hs = (hPos * fwd) + (hNeg * std::conj(fwd));
+      Specs[f].set(i_k, i_kMag, hs, i_index);
+    }
+  }
+};
+
+//-*****************************************************************************
+// PROPSPECS for the packed complex transform. Writes packed spectra instead
+// of half spectra, and keeps the height spectrum (if asked to) as before.
+template <typename T> struct PACKEDPROPSPECS {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  InitialSpectra<T> Initial;
+  PropagationPhasor<T> Phasor;
+  const SmoothInvertibleBandPassFilter<T> *Filter;
+
+  complex_type *HFiltSpecProp;
+  PackedPropagatedSpectra<T> Packed;
+
+  void operator()(std::size_t i_index) {
+    Packed.zero(i_index);
+    if (HFiltSpecProp) {
+      HFiltSpecProp[i_index] = complex_type(0.0, 0.0);
+    }
+  }
+
+  void operator()(const vec_type &i_k, real_type i_kMag, real_type i_dK,
+                  std::size_t i_index) {
+    const complex_type fwd = Phasor(i_index);
+    Phasor.store(i_index, fwd);
+
+    const complex_type hs = Initial.propagated(i_index, fwd);
+    EWAV_ASSERT(std::isfinite(hs.real()) && std::isfinite(hs.imag()),
+                "Bad hspec: " << hs << " at index: " << i_index);
+
+    complex_type hsPartner = hs;
+    if (Packed.selfConjugateColumn(i_index)) {
+      const std::size_t partner = Packed.partnerIndex(i_index);
+      hsPartner = Initial.propagated(partner, Phasor(partner));
+    }
+    Packed.set(i_k, i_kMag, hs, hsPartner, i_index);
+    if (HFiltSpecProp) {
+      HFiltSpecProp[i_index] = Filter ? (*Filter)(i_kMag) * hs : hs;
+    }
+  }
+};
+
+//-*****************************************************************************
+// DERIVSPECS for the packed complex transform.
+template <typename T> struct PACKEDDERIVSPECS {
+  typedef T real_type;
+  typedef std::complex<T> complex_type;
+  typedef Imath::Vec2<real_type> vec_type;
+
+  const complex_type *HSpecIn;
+  PackedPropagatedSpectra<T> Packed;
+
+  void operator()(std::size_t i_index) { Packed.zero(i_index); }
+
+  void operator()(const vec_type &i_k, real_type i_kMag, real_type i_dK,
+                  std::size_t i_index) {
+    const complex_type hs = HSpecIn[i_index];
+    const complex_type hsPartner = Packed.selfConjugateColumn(i_index)
+                                       ? HSpecIn[Packed.partnerIndex(i_index)]
+                                       : hs;
+    Packed.set(i_k, i_kMag, hs, hsPartner, i_index);
+  }
+};
+
 //-*****************************************************************************
 template <typename T> struct ComputeMinE {
   const T *Dxx;
@@ -325,6 +1341,128 @@ template <typename T> struct InterpolateIntoB {
   }
 };
 
+//-*****************************************************************************
+// The tail of trough damping in one sweep: converts the filtered MinE into
+// an interpolant, as ConvertMinEToInterpolant does, and blends each damped
+// field towards its filtered counterpart with it, as InterpolateIntoB does.
+// Fields that aren't damped have null pointers. Each range makes its
+// interpolants a chunk at a time into a buffer on the stack, so that the
+// conversion and every blend are simple loops the compiler can vectorize,
+// and the interpolant is never written back to memory.
+template <typename T> struct DampTroughs {
+  enum { kChunkSize = 512, kNumDampedFields = 3 };
+
+  T GainMinE;
+  T BiasMinE;
+  T MinClipE;
+  T MaxClipE;
+  T MinInterpolant;
+  const T *FiltMinE;
+
+  // Height, Dx and Dy, filtered and output.
+  const T *Filt[kNumDampedFields];
+  T *Out[kNumDampedFields];
+
+  void operator()(const tbb::blocked_range<std::size_t> &i_range) const {
+    T interpolant[kChunkSize];
+    for (std::size_t begin = i_range.begin(); begin < i_range.end();
+         begin += kChunkSize) {
+      const std::size_t n =
+          std::min(std::size_t(kChunkSize), i_range.end() - begin);
+      const T *minE = FiltMinE + begin;
+      for (std::size_t i = 0; i < n; ++i) {
+        T t = (minE[i] * GainMinE) + BiasMinE;
+        t = smoothstep(MinClipE, MaxClipE, t);
+        interpolant[i] = mix(MinInterpolant, T(1), t);
+      }
+      for (int f = 0; f < kNumDampedFields; ++f) {
+        if (Out[f]) {
+          const T *a = Filt[f] + begin;
+          T *b = Out[f] + begin;
+          for (std::size_t i = 0; i < n; ++i) {
+            b[i] = mix(a[i], b[i], interpolant[i]);
+          }
+        }
+      }
+    }
+  }
+};
+
+//-*****************************************************************************
+// The tail of reduced-resolution trough damping. Blending towards the
+// filtered field with interpolant t is the same as taking (1 - t) of the
+// band the filter removes away, and both the interpolant and the band are
+// on the smaller Mx by My grid, Ratio times coarser along both axes, so this
+// upsamples them bilinearly as it goes. Works a row of the full grid at a
+// time: first blends the two rows of the smaller grid around it, then
+// interpolates along the blended rows. Both grids are padded with a wrapped
+// border.
+template <typename T> struct DampTroughsFromReduced {
+  enum { kNumDampedFields = DampTroughs<T>::kNumDampedFields };
+
+  int Nx;
+  int Mx;
+  int My;
+  int Ratio;
+  const T *Interpolant;
+
+  // Height, Dx and Dy, the reduced bands and the outputs.
+  const T *Band[kNumDampedFields];
+  T *Out[kNumDampedFields];
+
+  void operator()(const tbb::blocked_range<int> &i_rows) const {
+    const int ratio = Ratio;
+    const std::size_t mStride = std::size_t(Mx) + 1;
+    const std::size_t nStride = std::size_t(Nx) + 1;
+    std::vector<T> reducedRow(mStride);
+    std::vector<T> damping(nStride);
+    for (int y = i_rows.begin(); y != i_rows.end(); ++y) {
+      const int v0 = y / ratio;
+      const int v1 = std::min(v0 + 1, My);
+      const T fy = T(y % ratio) / T(ratio);
+
+      // How much of the band to take away along the row.
+      const T *a = Interpolant + (std::size_t(v0) * mStride);
+      const T *b = Interpolant + (std::size_t(v1) * mStride);
+      for (int u = 0; u <= Mx; ++u) {
+        reducedRow[u] = T(1) - mix(a[u], b[u], fy);
+      }
+      for (int u = 0; u < Mx; ++u) {
+        const T d0 = reducedRow[u];
+        const T dd = (reducedRow[u + 1] - d0) / T(ratio);
+        T *d = damping.data() + (std::size_t(u) * ratio);
+        for (int k = 0; k < ratio; ++k) {
+          d[k] = d0 + (T(k) * dd);
+        }
+      }
+      damping[Nx] = reducedRow[Mx];
+
+      // Take it away from each field, interpolating the band as well.
+      for (int f = 0; f < kNumDampedFields; ++f) {
+        if (!Out[f]) {
+          continue;
+        }
+        a = Band[f] + (std::size_t(v0) * mStride);
+        b = Band[f] + (std::size_t(v1) * mStride);
+        for (int u = 0; u <= Mx; ++u) {
+          reducedRow[u] = mix(a[u], b[u], fy);
+        }
+        T *out = Out[f] + (std::size_t(y) * nStride);
+        for (int u = 0; u < Mx; ++u) {
+          const T b0 = reducedRow[u];
+          const T db = (reducedRow[u + 1] - b0) / T(ratio);
+          T *o = out + (std::size_t(u) * ratio);
+          const T *d = damping.data() + (std::size_t(u) * ratio);
+          for (int k = 0; k < ratio; ++k) {
+            o[k] -= d[k] * (b0 + (T(k) * db));
+          }
+        }
+        out[Nx] -= damping[Nx] * reducedRow[Mx];
+      }
+    }
+  }
+};
+
 //-*****************************************************************************
 template <typename T> struct MultB {
   const T *A;
@@ -339,201 +1477,326 @@ template <typename T> struct MultB {
 
 //-*****************************************************************************
 template <typename T>
-void Propagation<T>::propagate(const Parameters<T> &i_params,
-                               const InitialState<T> &i_istate,
-                               PropagatedState<T> &o_pstate, T i_time) {
-  // Check sizes.
-  int N = o_pstate.Height.unpaddedWidth();
-  std::size_t dataSize = o_pstate.Height.size();
-  std::size_t grainSize = 1024;
-  EWAV_ASSERT(
-      i_istate.HSpectralPos.height() == N &&
-          i_istate.HSpectralNeg.height() == N && i_istate.Omega.height() == N &&
-          o_pstate.Dx.width() == (N + 1) && o_pstate.Dy.width() == (N + 1) &&
-          o_pstate.MinE.width() == (N + 1),
-      "Mismatched sizes in wave propagation.");
-
-  // Make Hspec.
-  {
-    HSPEC<T> F;
-    F.HSpecPos = i_istate.HSpectralPos.cdata();
-    F.HSpecNeg = i_istate.HSpectralNeg.cdata();
-    F.Omega = i_istate.Omega.cdata();
-    F.HSpecProp = HSpec.data();
-    F.Time = i_time;
-    SpectralIterationFunctor<T, HSPEC<T>, HSPEC<T>> SIF(&F, Domain, N);
-  }
-
-  // Make DxxSpec from Hspec
-  {
-    DXXSPEC<T> F;
-    F.HSpecProp = HSpec.cdata();
-    F.DxxSpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DXXSPEC<T>, DXXSPEC<T>> SIF(&F, Domain, N);
-  }
-
-  // Compute Dxx, temporarily put into Dx.
-  { Converter.execute(TempSpec, o_pstate.Dx); }
-
-  // Make DyySpec from Hspec
-  {
-    DYYSPEC<T> F;
-    F.HSpecProp = HSpec.cdata();
-    F.DyySpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DYYSPEC<T>, DYYSPEC<T>> SIF(&F, Domain, N);
+void Propagation<T>::computeChannels(
+    unsigned int i_fields, const InitialSpectra<T> *i_initial,
+    const PropagationPhasor<T> &i_phasor, bool i_keepHeight,
+    const SmoothInvertibleBandPassFilter<T> *i_filter,
+    PropagatedState<T> &o_state) {
+  const GridSize size = o_state.Fields[0].gridSize();
+
+  // The fields' spectra are compacted in PropagatedField order. Dxx and
+  // Dyy, if any, are a run of their own, into MinEScratch.
+  const PropagatedRuns runs(i_fields, o_state);
+  FieldSlab2D<RealSpatialField2D<T>> *targets[kNumPropagatedFields];
+  for (int r = 0; r < runs.NumRuns; ++r) {
+    targets[r] = runs.Scratch[r] ? &minEScratch() : &o_state.Fields;
   }
 
-  // Compute Dyy, temporarily put into Dy.
-  { Converter.execute(TempSpec, o_pstate.Dy); }
+  if (Transform == kPackedComplexPropagationTransform) {
+    PackedPropagatedSpectra<T> packed;
+    packed.Data = PackedSpectra->data();
+    packed.FieldStride = PackedSpectra->fieldStride();
+    packed.Nx = size.Width;
+    packed.Ny = size.Height;
+    packed.NumPairs = 0;
+    for (int r = 0; r < runs.NumRuns; ++r) {
+      for (int i = runs.Begin[r]; i < runs.Begin[r + 1]; i += 2) {
+        packed.Pairs[packed.NumPairs][0] = runs.Fields[i];
+        packed.Pairs[packed.NumPairs][1] =
+            (i + 1 < runs.Begin[r + 1]) ? runs.Fields[i + 1] : -1;
+        ++packed.NumPairs;
+      }
+    }
 
-  // Make DxySpec from Hspec
-  {
-    DXYSPEC<T> F;
-    F.HSpecProp = HSpec.cdata();
-    F.DxySpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DXYSPEC<T>, DXYSPEC<T>> SIF(&F, Domain, N);
-  }
+    // Make any missing transforms before the spectra are filled, since
+    // measuring plans overwrites the arrays being planned on.
+    packed_converter_type *convs[kNumPropagatedFields];
+    for (int r = 0; r < runs.NumRuns; ++r) {
+      convs[r] = &packedConverter(runs.count(r));
+    }
 
-  // Compute Dxy, temporarily put into MinE.
-  { Converter.execute(TempSpec, o_pstate.MinE); }
+    if (i_initial) {
+      PACKEDPROPSPECS<T> F{*i_initial};
+      F.Phasor = i_phasor;
+      F.Filter = i_filter;
+      F.HFiltSpecProp = i_keepHeight ? HFiltSpec->data() : nullptr;
+      F.Packed = packed;
+      SpectralIterationFunctor<T, PACKEDPROPSPECS<T>, PACKEDPROPSPECS<T>> SIF(
+          &F, Domain, DomainY, size);
+    } else {
+      PACKEDDERIVSPECS<T> F;
+      F.HSpecIn = HFiltSpec->cdata();
+      F.Packed = packed;
+      SpectralIterationFunctor<T, PACKEDDERIVSPECS<T>, PACKEDDERIVSPECS<T>>
+          SIF(&F, Domain, DomainY, size);
+    }
 
-  // Compute MinE from Dxx, Dyy, Dxy.
-  {
-    ComputeMinE<T> F;
-    F.Dxx = o_pstate.Dx.cdata();
-    F.Dyy = o_pstate.Dy.cdata();
-    F.Dxy_and_MinE = o_pstate.MinE.data();
-    F.Pinch = T(1.25);
-    // CJH HACK
-    tbb::parallel_for(
-        tbb::blocked_range<std::size_t>(0, dataSize /*, grainSize*/), F);
-  }
+    int pair = 0;
+    for (int r = 0; r < runs.NumRuns; ++r) {
+      convs[r]->execute(*PackedSpectra, 2 * pair, *targets[r],
+                        runs.Slot[r]);
+      pair += convs[r]->numPairs();
+    }
+  } else {
+    FieldSlab2D<ComplexSpectralField2D<T>> &slab = spectra(runs.NumFields);
+    PropagatedSpectra<T> specs;
+    for (int f = 0; f < kNumPropagatedFields; ++f) {
+      specs.SpecProp[f] = nullptr;
+    }
+    for (int i = 0; i < runs.NumFields; ++i) {
+      specs.SpecProp[runs.Fields[i]] = slab[i].data();
+    }
 
-  // Make DxSpec from Hspec
-  {
-    DXSPEC<T> F;
-    F.HSpecProp = HSpec.cdata();
-    F.DxSpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DXSPEC<T>, DXSPEC<T>> SIF(&F, Domain, N);
-  }
+    converter_type *convs[kNumPropagatedFields];
+    for (int r = 0; r < runs.NumRuns; ++r) {
+      convs[r] = &converter(runs.count(r));
+    }
 
-  // Compute Dx
-  { Converter.execute(TempSpec, o_pstate.Dx); }
+    if (i_initial) {
+      PROPSPECS<T> F{*i_initial};
+      F.Phasor = i_phasor;
+      F.Filter = i_filter;
+      F.HFiltSpecProp = i_keepHeight ? HFiltSpec->data() : nullptr;
+      F.Specs = specs;
+      SpectralIterationFunctor<T, PROPSPECS<T>, PROPSPECS<T>> SIF(
+          &F, Domain, DomainY, size);
+    } else {
+      DERIVSPECS<T> F;
+      F.HSpecIn = HFiltSpec->cdata();
+      F.Specs = specs;
+      SpectralIterationFunctor<T, DERIVSPECS<T>, DERIVSPECS<T>> SIF(
+          &F, Domain, DomainY, size);
+    }
 
-  // Make DySpec from Hspec
-  {
-    DYSPEC<T> F;
-    F.HSpecProp = HSpec.cdata();
-    F.DySpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DYSPEC<T>, DYSPEC<T>> SIF(&F, Domain, N);
+    for (int r = 0; r < runs.NumRuns; ++r) {
+      convs[r]->execute(slab, runs.Begin[r], *targets[r], runs.Slot[r]);
+    }
   }
+}
 
-  // Compute Dy
-  { Converter.execute(TempSpec, o_pstate.Dy); }
-
-  // build filter.
-  if (i_params.troughDamping == 0) {
-    // Compute H.
-    { Converter.execute(HSpec, o_pstate.Height); }
+//-*****************************************************************************
+template <typename T>
+void Propagation<T>::propagateInArena(const Parameters<T> &i_params,
+                                       const InitialSpectra<T> &i_initial,
+                                       PropagatedState<T> &o_pstate, T i_time,
+                                       unsigned int i_channels) {
+  const unsigned int channels =
+      ResolvePropagatedChannels(i_channels) & o_pstate.Channels;
+  if (!channels) {
     return;
   }
 
+  // Check sizes.
+  std::size_t dataSize = o_pstate.Fields[0].size();
+  const std::size_t grainSize = StreamingGrainSize(dataSize);
+  EWAV_ASSERT(i_initial.Size == Size && o_pstate.Fields[0].gridSize() == Size,
+              "Mismatched sizes in wave propagation.");
+
+  // build filter. Trough damping only changes Height, Dx and Dy.
   SmoothInvertibleBandPassFilter<T> filter(
       0.0, i_params.troughDampingSmallWavelength,
       i_params.troughDampingBigWavelength,
       i_params.troughDampingBigWavelength + i_params.troughDampingSoftWidth, 0,
       true);
-
-  // Create filtered H spectrally
-  {
-    HFILTSPEC<T> F;
-    F.Filter = &filter;
-    F.HSpecProp = HSpec.cdata();
-    F.HFiltSpecProp = HFiltSpec.data();
-    SpectralIterationFunctor<T, HFILTSPEC<T>, HFILTSPEC<T>> SIF(&F, Domain, N);
+  const unsigned int dampedChannels = channels & kDisplacementChannels;
+  const bool damping = (i_params.troughDamping != 0) && dampedChannels;
+  const GridSize dampingSize = (damping && ReduceTroughDamping)
+                                   ? reducedTroughDampingSize(i_params)
+                                   : Size;
+  const bool reduced = dampingSize != Size;
+  if (damping) {
+    allocateDamping(reduced ? 0u
+                            : (kHeightChannel | dampedChannels |
+                               kMinEChannel));
   }
 
-  // Compute H.
-  { Converter.execute(HSpec, o_pstate.Height); }
-
-  // Make DxxFiltSpec from HFiltspec
-  {
-    DXXSPEC<T> F;
-    F.HSpecProp = HFiltSpec.cdata();
-    F.DxxSpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DXXSPEC<T>, DXXSPEC<T>> SIF(&F, Domain, N);
+  // Phase. In fixed time step playback, step the phasors if this is the
+  // next step, otherwise resync them.
+  PropagationPhasor<T> phasor;
+  phasor.Omega = i_initial.Omega;
+  phasor.OmegaFoldRows = i_initial.OmegaFoldRows;
+  phasor.OmegaStride = std::size_t(Size.Width / 2) + 1;
+  phasor.Time = i_time;
+  phasor.TimeStep = TimeStep;
+  phasor.PrevPhasor = nullptr;
+  phasor.NextPhasor = nullptr;
+  phasor.PhasorStep = nullptr;
+  const int loopFrames = int(LoopPhasors.size());
+  if (loopFrames > 0 && i_initial.LoopPeriod > 0) {
+    const T frameTime = i_initial.LoopPeriod / T(loopFrames);
+    const T frame = std::round(i_time / frameTime);
+    if (SameFrameTime(i_time, frame * frameTime, frameTime)) {
+      const long long f = (long long)frame % loopFrames;
+      phasor.LoopTable = LoopPhasors.data();
+      phasor.LoopFrames = loopFrames;
+      phasor.LoopFrame = int(f < 0 ? f + loopFrames : f);
+      phasor.LoopOmegaScale = i_initial.LoopPeriod / T(M_TAU);
+    }
+  }
+  if (phasor.LoopTable) {
+    // Resync fixed time step playback after looping.
+    LastGeneration = 0;
+  } else if (TimeStep > 0) {
+    const bool step =
+        (LastGeneration == i_initial.Generation) &&
+        (StepsSinceResync < ResyncInterval) &&
+        SameFrameTime(i_time, LastTime + TimeStep, TimeStep);
+    if (step) {
+      phasor.PrevPhasor = (*Phasors)[CurrentPhasor].cdata();
+      ++StepsSinceResync;
+    } else {
+      StepsSinceResync = 0;
+    }
+    CurrentPhasor = 1 - CurrentPhasor;
+    phasor.NextPhasor = (*Phasors)[CurrentPhasor].data();
+    phasor.PhasorStep = (*Phasors)[2].data();
+    LastTime = i_time;
+    LastGeneration = i_initial.Generation;
   }
 
-  // Compute FiltDxx, temporarily put into FiltDx.
-  { Converter.execute(TempSpec, FiltDx); }
+  // Make Hspec, the requested derivative spectra, and (if damping) the
+  // filtered Hspec, in a single pass over the initial state, then transform
+  // them. Dxy is temporarily put into MinE. Reduced damping filters on the
+  // smaller grid, so it keeps the height spectrum unfiltered.
+  computeChannels(PropagatedFieldsOf(channels), &i_initial, phasor, damping,
+                  reduced ? nullptr : &filter, o_pstate);
 
-  // Make DyyFiltSpec from HFiltspec
-  {
-    DYYSPEC<T> F;
-    F.HSpecProp = HFiltSpec.cdata();
-    F.DyySpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DYYSPEC<T>, DYYSPEC<T>> SIF(&F, Domain, N);
+  // Compute MinE from Dxx, Dyy, Dxy.
+  if (channels & kMinEChannel) {
+    ComputeMinE<T> F;
+    F.Dxx = (*MinEScratch)[0].cdata();
+    F.Dyy = (*MinEScratch)[1].cdata();
+    F.Dxy_and_MinE = o_pstate.MinE.data();
+    F.Pinch = T(1.25);
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, dataSize, grainSize), F);
   }
 
-  // Compute FiltDyy, temporarily put into FiltDy.
-  { Converter.execute(TempSpec, FiltDy); }
-
-  // Make DxyFiltSpec from HFiltspec
-  {
-    DXYSPEC<T> F;
-    F.HSpecProp = HFiltSpec.cdata();
-    F.DxySpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DXYSPEC<T>, DXYSPEC<T>> SIF(&F, Domain, N);
+  if (!damping) {
+    return;
+  }
+  if (reduced) {
+    dampTroughsReduced(i_params, filter, phasor, dampingSize, dampedChannels,
+                       o_pstate);
+    return;
   }
 
-  // Compute FiltDxy, temporarily put into FiltMinE.
-  { Converter.execute(TempSpec, FiltMinE); }
+  // Make the filtered Hspec and the derivative spectra needed for damping in
+  // one pass, then transform them. The interpolant comes from the filtered
+  // MinE, and Stats wants the filtered height.
+  computeChannels(
+      PropagatedFieldsOf(kHeightChannel | dampedChannels | kMinEChannel),
+      nullptr, phasor, false, nullptr, *FiltState);
 
   // Compute FiltMinE from FiltDxx, FiltDyy, FiltDxy.
   {
     ComputeMinE<T> F;
-    F.Dxx = FiltDx.cdata();
-    F.Dyy = FiltDy.cdata();
-    F.Dxy_and_MinE = FiltMinE.data();
+    F.Dxx = (*MinEScratch)[0].cdata();
+    F.Dyy = (*MinEScratch)[1].cdata();
+    F.Dxy_and_MinE = FiltState->MinE.data();
     F.Pinch = T(1.25);
-    // CJH HACK
     tbb::parallel_for(
-        tbb::blocked_range<std::size_t>(0, dataSize /*, grainSize*/), F);
+        tbb::blocked_range<std::size_t>(0, dataSize, grainSize), F);
   }
 
-  // Make DxFiltSpec from HFiltspec
+  // Get Stats about FiltH and FiltMinE
+  Stats<T> stats(FiltState->Height, FiltState->MinE);
+
+  // Convert FiltMinE to the interpolant and blend the damped fields
+  // towards their filtered versions with it, in one sweep.
   {
-    DXSPEC<T> F;
-    F.HSpecProp = HFiltSpec.cdata();
-    F.DxSpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DXSPEC<T>, DXSPEC<T>> SIF(&F, Domain, N);
+    DampTroughs<T> F;
+    F.GainMinE = T(1) / (T(2) * stats.StdDevMinE);
+    F.BiasMinE = -stats.MeanMinE / (T(2) * stats.StdDevMinE);
+    F.MinClipE = 0.0;
+    F.MaxClipE = 1.1;
+    F.MinInterpolant = T(1) - i_params.troughDamping;
+    F.FiltMinE = FiltState->MinE.cdata();
+    const PropagatedField damped[] = {kHeightField, kDxField, kDyField};
+    for (int f = 0; f < DampTroughs<T>::kNumDampedFields; ++f) {
+      const bool on = (channels & (1 << damped[f])) != 0;
+      F.Filt[f] = on ? FiltState->field(damped[f]).cdata() : nullptr;
+      F.Out[f] = on ? o_pstate.field(damped[f]).data() : nullptr;
+    }
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, dataSize, grainSize), F);
   }
 
-  // Compute FiltDx
-  { Converter.execute(TempSpec, FiltDx); }
+#if 0
+    // Mult output MinE
+    {
+        MultB<T> F;
+        F.A = FiltState->MinE.cdata();
+        F.B = o_pstate.MinE.data();
+        // CJH HACK
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>( 0, dataSize/*, grainSize*/ ),
+            F );
+    }
+#endif
+}
 
-  // Make DyFiltSpec from HFiltspec
+//-*****************************************************************************
+template <typename T>
+void Propagation<T>::dampTroughsReduced(
+    const Parameters<T> &i_params,
+    const SmoothInvertibleBandPassFilter<T> &i_filter,
+    const PropagationPhasor<T> &i_phasor, const GridSize &i_size,
+    unsigned int i_dampedChannels, PropagatedState<T> &o_pstate) {
+  if (!ReducedDamping || ReducedDamping->Size != i_size) {
+    Parameters<T> params = i_params;
+    params.resolutionX = i_size.Width;
+    params.resolutionY = i_size.Height;
+    params.domain = Domain;
+    params.domainY = DomainY;
+
+    // Runs in this one's arena rather than making its own, and plans its
+    // transforms for the same number of threads.
+    ReducedDamping.reset(
+        new Propagation<T>(params, -1, Transform, PlanOptions));
+    ReducedDamping->setArena(Arena);
+    ReducedDamping->NumThreads = NumThreads;
+    ReducedBand.reset();
+  }
+  if (!ReducedBand ||
+      (ReducedBand->Channels & i_dampedChannels) != i_dampedChannels) {
+    ReducedBand.reset(new PropagatedState<T>(
+        i_size,
+        i_dampedChannels | (ReducedBand ? ReducedBand->Channels : 0u)));
+  }
+  Propagation<T> &reduced = *ReducedDamping;
+  reduced.setTransform(Transform);
+  reduced.allocateDamping(kHeightChannel | kMinEChannel);
+  PropagatedState<T> &filtState = *reduced.FiltState;
+  const std::size_t dataSize = filtState.Height.size();
+  const std::size_t grainSize = StreamingGrainSize(dataSize);
+
+  // Propagate the filtered waves on the smaller grid, for the interpolant.
   {
-    DYSPEC<T> F;
-    F.HSpecProp = HFiltSpec.cdata();
-    F.DySpecProp = TempSpec.data();
-    SpectralIterationFunctor<T, DYSPEC<T>, DYSPEC<T>> SIF(&F, Domain, N);
+    DAMPINGSPEC<T> F;
+    F.HSpecIn = HFiltSpec->cdata();
+    F.HSpecOut = reduced.HFiltSpec->data();
+    F.Filter = &i_filter;
+    F.Complement = false;
+    F.Nx = Size.Width;
+    F.Ny = Size.Height;
+    F.Mx = i_size.Width;
+    F.My = i_size.Height;
+    SpectralIterationFunctor<T, DAMPINGSPEC<T>, DAMPINGSPEC<T>> SIF(
+        &F, Domain, DomainY, i_size);
   }
-
-  // Compute FiltDy
-  { Converter.execute(TempSpec, FiltDy); }
-
-  // Compute FiltH.
+  reduced.computeChannels(PropagatedFieldsOf(kHeightChannel | kMinEChannel),
+                          nullptr, i_phasor, false, nullptr, filtState);
   {
-    // CJH HACK
-    // Converter.execute( HSpec, FiltHeight );
-    Converter.execute(HFiltSpec, FiltHeight);
+    ComputeMinE<T> F;
+    F.Dxx = (*reduced.MinEScratch)[0].cdata();
+    F.Dyy = (*reduced.MinEScratch)[1].cdata();
+    F.Dxy_and_MinE = filtState.MinE.data();
+    F.Pinch = T(1.25);
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, dataSize, grainSize), F);
   }
-
-  // Get Stats about FiltH and FiltMinE
-  Stats<T> stats(FiltHeight, FiltMinE);
-
-  // Compute interpolant from stats.
+  Stats<T> stats(filtState.Height, filtState.MinE);
   {
     ConvertMinEToInterpolant<T> F;
     F.GainMinE = T(1) / (T(2) * stats.StdDevMinE);
@@ -541,57 +1804,188 @@ void Propagation<T>::propagate(const Parameters<T> &i_params,
     F.MinClipE = 0.0;
     F.MaxClipE = 1.1;
     F.MinInterpolant = T(1) - i_params.troughDamping;
-    F.MinE_And_Interpolant = FiltMinE.data();
-    // CJH HACK
+    F.MinE_And_Interpolant = filtState.MinE.data();
     tbb::parallel_for(
-        tbb::blocked_range<std::size_t>(0, dataSize /*, grainSize*/), F);
+        tbb::blocked_range<std::size_t>(0, dataSize, grainSize), F);
   }
 
-  // Interpolate into output state.
+  // Propagate the band the filter removes on the smaller grid.
   {
-    InterpolateIntoB<T> F;
-    F.A = FiltHeight.cdata();
-    F.B = o_pstate.Height.data();
-    F.Interpolant = FiltMinE.cdata();
-    // CJH HACK
-    tbb::parallel_for(
-        tbb::blocked_range<std::size_t>(0, dataSize /*, grainSize*/), F);
+    DAMPINGSPEC<T> F;
+    F.HSpecIn = HFiltSpec->cdata();
+    F.HSpecOut = reduced.HFiltSpec->data();
+    F.Filter = &i_filter;
+    F.Complement = true;
+    F.Nx = Size.Width;
+    F.Ny = Size.Height;
+    F.Mx = i_size.Width;
+    F.My = i_size.Height;
+    SpectralIterationFunctor<T, DAMPINGSPEC<T>, DAMPINGSPEC<T>> SIF(
+        &F, Domain, DomainY, i_size);
   }
+  reduced.computeChannels(i_dampedChannels, nullptr, i_phasor, false,
+                          nullptr, *ReducedBand);
 
-  // Interpolate into output state.
+  // Take the band away, upsampled.
   {
-    InterpolateIntoB<T> F;
-    F.A = FiltDx.cdata();
-    F.B = o_pstate.Dx.data();
-    F.Interpolant = FiltMinE.cdata();
-    // CJH HACK
-    tbb::parallel_for(
-        tbb::blocked_range<std::size_t>(0, dataSize /*, grainSize*/), F);
+    DampTroughsFromReduced<T> F;
+    F.Nx = Size.Width;
+    F.Mx = i_size.Width;
+    F.My = i_size.Height;
+    F.Ratio = Size.Width / i_size.Width;
+    F.Interpolant = filtState.MinE.cdata();
+    const PropagatedField damped[] = {kHeightField, kDxField, kDyField};
+    for (int f = 0; f < DampTroughs<T>::kNumDampedFields; ++f) {
+      const bool on = (i_dampedChannels & (1 << damped[f])) != 0;
+      F.Band[f] = on ? ReducedBand->field(damped[f]).cdata() : nullptr;
+      F.Out[f] = on ? o_pstate.field(damped[f]).data() : nullptr;
+    }
+    tbb::parallel_for(tbb::blocked_range<int>(0, Size.Height + 1), F);
   }
+}
 
-  // Interpolate into output state.
-  {
-    InterpolateIntoB<T> F;
-    F.A = FiltDy.cdata();
-    F.B = o_pstate.Dy.data();
-    F.Interpolant = FiltMinE.cdata();
-    // CJH HACK
-    tbb::parallel_for(
-        tbb::blocked_range<std::size_t>(0, dataSize /*, grainSize*/), F);
+//-*****************************************************************************
+template <typename T>
+void Propagation<T>::propagateBatchInArena(const Parameters<T> &i_params,
+                                           const InitialState<T> &i_istate,
+                                           const T *i_times,
+                                           PropagatedState<T> *const *o_states,
+                                           int i_numFrames,
+                                           unsigned int i_channels,
+                                           int i_framesPerPass) {
+  if (i_numFrames <= 0) {
+    return;
   }
+  EWAV_ASSERT(i_framesPerPass > 0,
+              "Bad frames per pass: " << i_framesPerPass);
+
+  const unsigned int channels =
+      ResolvePropagatedChannels(i_channels) & o_states[0]->Channels;
+  if (!channels) {
+    return;
+  }
+
+  if ((i_params.troughDamping != 0) && (channels & kDisplacementChannels)) {
+    // Fixed time step playback is off for these frames, so the phasors
+    // aren't touched, and its state is put back afterwards.
+    const T timeStep = TimeStep;
+    const int stepsSinceResync = StepsSinceResync;
+    const int currentPhasor = CurrentPhasor;
+    const T lastTime = LastTime;
+    const std::uint64_t lastGeneration = LastGeneration;
+    auto restore = [&] {
+      TimeStep = timeStep;
+      StepsSinceResync = stepsSinceResync;
+      CurrentPhasor = currentPhasor;
+      LastTime = lastTime;
+      LastGeneration = lastGeneration;
+    };
+
+    TimeStep = 0;
+    try {
+      for (int f = 0; f < i_numFrames; ++f) {
+        propagateInArena(i_params, i_istate, *o_states[f], i_times[f],
+                         i_channels);
+      }
+    } catch (...) {
+      restore();
+      throw;
+    }
+    restore();
+    return;
+  }
+
+  const std::size_t dataSize = o_states[0]->Fields[0].size();
+  for (int f = 0; f < i_numFrames; ++f) {
+    EWAV_ASSERT(o_states[f]->Channels == o_states[0]->Channels &&
+                    o_states[f]->Fields[0].gridSize() == Size,
+                "Mismatched states in batched wave propagation.");
+  }
+  EWAV_ASSERT(i_istate.Size == Size,
+              "Mismatched sizes in batched wave propagation.");
+
+  const PropagatedRuns runs(PropagatedFieldsOf(channels), *o_states[0]);
+  const int framesPerPass = std::min(i_framesPerPass, i_numFrames);
+  const int spectraPerPass = framesPerPass * runs.NumFields;
+  if (!BatchSpectra || BatchSpectra->count() < spectraPerPass) {
+    BatchSpectra.reset(
+        new FieldSlab2D<ComplexSpectralField2D<T>>(spectraPerPass, Size));
+  }
+  if ((channels & kMinEChannel) &&
+      (!BatchMinEScratch || BatchMinEScratch->count() < 2 * framesPerPass)) {
+    BatchMinEScratch.reset(
+        new FieldSlab2D<RealSpatialField2D<T>>(2 * framesPerPass, Size, 1));
+  }
+
+  // Make any missing transforms first, as in computeChannels. They're
+  // planned on Spectra, which has the same field stride as BatchSpectra.
+  converter_type *convs[kNumPropagatedFields];
+  for (int r = 0; r < runs.NumRuns; ++r) {
+    convs[r] = &converter(runs.count(r));
+  }
+
+  std::vector<PropagatedSpectra<T>> specs(framesPerPass);
+  for (int pass = 0; pass < i_numFrames; pass += framesPerPass) {
+    const int numFrames = std::min(framesPerPass, i_numFrames - pass);
+    const T *times = i_times + pass;
+
+    // Evenly spaced to within the tolerance of fixed time step playback.
+    const T dt = (numFrames > 1) ? times[1] - times[0] : T(0);
+    bool evenlySpaced = true;
+    for (int f = 2; f < numFrames; ++f) {
+      evenlySpaced = evenlySpaced &&
+                     SameFrameTime(times[f], times[f - 1] + dt, std::abs(dt));
+    }
+
+    for (int f = 0; f < numFrames; ++f) {
+      for (int g = 0; g < kNumPropagatedFields; ++g) {
+        specs[f].SpecProp[g] = nullptr;
+      }
+      for (int i = 0; i < runs.NumFields; ++i) {
+        specs[f].SpecProp[runs.Fields[i]] =
+            (*BatchSpectra)[(f * runs.NumFields) + i].data();
+      }
+    }
 
-#if 0
-    // Mult output MinE
     {
-        MultB<T> F;
-        F.A = FiltMinE.cdata();
-        F.B = o_pstate.MinE.data();
-        // CJH HACK
-        tbb::parallel_for(
-            tbb::blocked_range<std::size_t>( 0, dataSize/*, grainSize*/ ),
-            F );
+      BATCHPROPSPECS<T> F;
+      F.HSpecPos = i_istate.HSpectralPos.cdata();
+      F.HSpecNeg = i_istate.HSpectralNeg.cdata();
+      F.Omega = i_istate.Omega.cdata();
+      F.Times = times;
+      F.NumFrames = numFrames;
+      F.EvenlySpaced = evenlySpaced;
+      F.Specs = specs.data();
+      SpectralIterationFunctor<T, BATCHPROPSPECS<T>, BATCHPROPSPECS<T>> SIF(
+          &F, Domain, DomainY, Size);
     }
-#endif
+
+    // Transform the frames concurrently, sharing the plans.
+    tbb::parallel_for(0, numFrames, [&](int f) {
+      PropagatedState<T> &state = *o_states[pass + f];
+      for (int r = 0; r < runs.NumRuns; ++r) {
+        const int spectrum = (f * runs.NumFields) + runs.Begin[r];
+        if (runs.Scratch[r]) {
+          convs[r]->execute(*BatchSpectra, spectrum, *BatchMinEScratch,
+                            (2 * f) + runs.Slot[r]);
+        } else {
+          convs[r]->execute(*BatchSpectra, spectrum, state.Fields,
+                            runs.Slot[r]);
+        }
+      }
+
+      if (channels & kMinEChannel) {
+        ComputeMinE<T> F;
+        F.Dxx = (*BatchMinEScratch)[2 * f].cdata();
+        F.Dyy = (*BatchMinEScratch)[(2 * f) + 1].cdata();
+        F.Dxy_and_MinE = state.MinE.data();
+        F.Pinch = T(1.25);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(
+                              0, dataSize, StreamingGrainSize(dataSize)),
+                          F);
+      }
+    });
+  }
 }
 
 } // namespace EncinoWaves
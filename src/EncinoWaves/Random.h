@@ -64,35 +64,108 @@ uint32_t SeedFromWavenumber(const Imath::Vec2<T> &i_wavenumber,
 }
 
 //-*****************************************************************************
+// PHILOX
+//-*****************************************************************************
+
+//-*****************************************************************************
+// Philox4x32-10, the counter-based generator of Salmon et al., "Parallel
+// Random Numbers: As Easy as 1, 2, 3", SC 2011. Ten rounds of a keyed
+// bijection of a 128-bit counter, so each draw is a pure function of the
+// key and the counter, with nothing carried from one draw to the next. It is
+// only 32-bit integer multiplies and xors, which give the same bits on every
+// compiler and platform.
+struct Philox4x32 {
+  typedef std::array<uint32_t, 4> counter_type;
+  typedef std::array<uint32_t, 2> key_type;
+
+  static constexpr uint32_t kMultiplier0 = 0xD2511F53;
+  static constexpr uint32_t kMultiplier1 = 0xCD9E8D57;
+  static constexpr uint32_t kWeyl0       = 0x9E3779B9;
+  static constexpr uint32_t kWeyl1       = 0xBB67AE85;
+  static constexpr int kNumRounds        = 10;
+
+  static counter_type generate(counter_type i_counter, key_type i_key) {
+    for (int round = 0; round < kNumRounds; ++round) {
+      if (round > 0) {
+        i_key[0] += kWeyl0;
+        i_key[1] += kWeyl1;
+      }
+      const uint64_t p0 = uint64_t(kMultiplier0) * uint64_t(i_counter[0]);
+      const uint64_t p1 = uint64_t(kMultiplier1) * uint64_t(i_counter[2]);
+      i_counter = {{uint32_t(p1 >> 32) ^ i_counter[1] ^ i_key[0],
+                    uint32_t(p1),
+                    uint32_t(p0 >> 32) ^ i_counter[3] ^ i_key[1],
+                    uint32_t(p0)}};
+    }
+    return i_counter;
+  }
+
+  // A uniform draw in the open interval (0, 1). Exact in double.
+  static double uniform(uint32_t i_bits) {
+    return (double(i_bits) + 0.5) * (1.0 / 4294967296.0);
+  }
+};
+
+//-*****************************************************************************
+// The random draws of a bin of the initial state: two amplitudes and two
+// phases, for the positive and negative waves, from one Philox block
+// keyed on the seed and counting the bin's integer wavenumber. The draws
+// don't depend on which thread makes which bin, or in what order.
+//
+// The normal amplitudes come from the first two words by Box-Muller, in
+// double precision, rather than from std::normal_distribution, whose
+// algorithm differs between standard libraries and keeps state between
+// calls. The integer draws are the same everywhere, but the normals and
+// phases go through the math library's log, sqrt, sin and cos, as does the
+// spectrum itself, so initial states are not bit-identical across platforms
+// or compilers. They are bit-identical across thread counts and bin order
+// on one build.
 template <typename T>
 class BaseRandom {
 protected:
-  seed_type m_seed;
-  Rand48_Engine m_engine;
-  std::uniform_real_distribution<T> m_phaseDist;
+  Philox4x32::key_type m_key;
+  T m_normals[2];
+  T m_phases[2];
+  int m_nextAmp;
+  int m_nextPhase;
 
 public:
   BaseRandom()
-    : m_seed(0)
-    , m_engine(seed_type(0))
-    , m_phaseDist(T(0.0), TAU<T>) {
-    this->seed(m_seed);
-  }
+    : BaseRandom(0) {}
 
   BaseRandom(const Parameters<T> &i_params)
-    : m_seed(i_params.random.seed)
-    , m_engine(m_seed)
-    , m_phaseDist(T(0.0), TAU<T>) {
-    this->seed(m_seed);
+    : BaseRandom(i_params.random.seed) {}
+
+  // The seed is half of the key. The other half is a fixed constant, the
+  // first bits of the fraction of the square root of two.
+  explicit BaseRandom(int i_seed)
+    : m_key{{uint32_t(i_seed), 0x6A09E667}}
+    , m_normals{T(0), T(0)}
+    , m_phases{T(0), T(0)}
+    , m_nextAmp(0)
+    , m_nextPhase(0) {}
+
+  // Makes the draws of the bin of integer wavenumber (i_kx, i_ky).
+  void seed(int i_kx, int i_ky) {
+    const Philox4x32::counter_type bits = Philox4x32::generate(
+      {{uint32_t(i_kx), uint32_t(i_ky), 0, 0}}, m_key);
+
+    const double u0     = Philox4x32::uniform(bits[0]);
+    const double u1     = Philox4x32::uniform(bits[1]);
+    const double radius = std::sqrt(-2.0 * std::log(u0));
+    const double angle  = TAU<double> * u1;
+    m_normals[0]        = T(radius * std::cos(angle));
+    m_normals[1]        = T(radius * std::sin(angle));
+    m_phases[0]         = T(TAU<double> * Philox4x32::uniform(bits[2]));
+    m_phases[1]         = T(TAU<double> * Philox4x32::uniform(bits[3]));
+    m_nextAmp           = 0;
+    m_nextPhase         = 0;
   }
 
-  void seed(seed_type i_seed) { m_engine.seed(i_seed + m_seed); }
+  T nextPhase() { return m_phases[(m_nextPhase++) & 1]; }
 
-  void seed(const Imath::Vec2<T> &i_wavenumber) {
-    m_engine.seed(SeedFromWavenumber<T>(i_wavenumber, m_seed));
-  }
-
-  T nextPhase() { return m_phaseDist(m_engine); }
+protected:
+  T nextNormal() { return m_normals[(m_nextAmp++) & 1]; }
 };
 
 //-*****************************************************************************
@@ -101,19 +174,14 @@ public:
 // from 0 to infinity has a standard deviation of 1.48448
 template <typename T>
 class NormalRandom : public BaseRandom<T> {
-protected:
-  std::normal_distribution<T> m_ampDist;
-
 public:
   NormalRandom()
-    : BaseRandom<T>()
-    , m_ampDist(T(0.0), T(1.0)) {}
+    : BaseRandom<T>() {}
 
   NormalRandom(const Parameters<T> &i_params)
-    : BaseRandom<T>(i_params)
-    , m_ampDist(T(0.0), T(1.0)) {}
+    : BaseRandom<T>(i_params) {}
 
-  T nextAmp() { return m_ampDist(this->m_engine); }
+  T nextAmp() { return this->nextNormal(); }
 };
 
 //------------------------------------------------------------------------------
@@ -130,23 +198,38 @@ public:
 };
 
 //-*****************************************************************************
+// Log-normal with a mean log of one and a standard deviation of log of one.
 template <typename T>
 class LogNormalRandom : public BaseRandom<T> {
-protected:
-  std::lognormal_distribution<T> m_ampDist;
-
 public:
   LogNormalRandom()
-    : BaseRandom<T>()
-    , m_ampDist(T(1.0), T(1.0)) {}
+    : BaseRandom<T>() {}
 
   LogNormalRandom(const Parameters<T> &i_params)
-    : BaseRandom<T>(i_params)
-    , m_ampDist(T(1.0), T(1.0)) {}
+    : BaseRandom<T>(i_params) {}
 
-  T nextAmp() { return m_ampDist(this->m_engine); }
+  T nextAmp() { return T(std::exp(1.0 + double(this->nextNormal()))); }
 };
 
+//-*****************************************************************************
+// The unit draws of the bin of integer wavenumber (i_kx, i_ky), for its
+// positive and negative waves: a random amplitude times a random phase,
+// as amp * e^(-i phase). The initial state is these scaled by the spectral
+// envelope of the bin. i_index is the bin's index in the half spectrum,
+// for sources of draws that look them up rather than make them.
+template <typename RANDOM, typename T>
+void DrawUnitNoise(RANDOM &io_random, int i_kx, int i_ky,
+                   std::size_t /*i_index*/, std::complex<T> &o_pos,
+                   std::complex<T> &o_neg) {
+  io_random.seed(i_kx, i_ky);
+  const T ampPos   = io_random.nextAmp();
+  const T ampNeg   = io_random.nextAmp();
+  const T phasePos = io_random.nextPhase();
+  const T phaseNeg = io_random.nextPhase();
+  o_pos = ampPos * std::complex<T>(std::cos(phasePos), -std::sin(phasePos));
+  o_neg = ampNeg * std::complex<T>(std::cos(phaseNeg), -std::sin(phaseNeg));
+}
+
 }  // namespace EncinoWaves
 
 #endif
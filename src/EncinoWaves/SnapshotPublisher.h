@@ -0,0 +1,210 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#ifndef _EncinoWaves_SnapshotPublisher_h_
+#define _EncinoWaves_SnapshotPublisher_h_
+
+#include "Foundation.h"
+#include "Parameters.h"
+#include "Propagation.h"
+
+namespace EncinoWaves {
+
+//-*****************************************************************************
+// A published propagated state. It is immutable while any reader holds it.
+template <typename T> struct PropagatedSnapshot {
+  PropagatedState<T> State;
+  T Time;
+  std::uint64_t Sequence;
+
+  // Readers holding this, padded onto a cache line of its own, since every
+  // reader of the newest snapshot bumps it.
+  char RefCountPadBefore[64];
+  mutable std::atomic<int> RefCount;
+  char RefCountPadAfter[64];
+
+  PropagatedSnapshot(const Parameters<T> &i_params, unsigned int i_channels)
+      : State(i_params, i_channels), Time(0), Sequence(0), RefCount(0) {}
+};
+
+//-*****************************************************************************
+// A reader's reference to a snapshot, which keeps it from being reused
+// until the reference is reset or destroyed.
+template <typename T> class PropagatedSnapshotRef {
+public:
+  PropagatedSnapshotRef() : m_snapshot(nullptr) {}
+
+  explicit PropagatedSnapshotRef(const PropagatedSnapshot<T> *i_held)
+      : m_snapshot(i_held) {}
+
+  PropagatedSnapshotRef(const PropagatedSnapshotRef<T> &i_copy)
+      : m_snapshot(i_copy.m_snapshot) {
+    if (m_snapshot) {
+      m_snapshot->RefCount.fetch_add(1);
+    }
+  }
+
+  PropagatedSnapshotRef(PropagatedSnapshotRef<T> &&i_move)
+      : m_snapshot(i_move.m_snapshot) {
+    i_move.m_snapshot = nullptr;
+  }
+
+  PropagatedSnapshotRef<T> &operator=(PropagatedSnapshotRef<T> i_other) {
+    std::swap(m_snapshot, i_other.m_snapshot);
+    return *this;
+  }
+
+  ~PropagatedSnapshotRef() { reset(); }
+
+  void reset() {
+    if (m_snapshot) {
+      m_snapshot->RefCount.fetch_sub(1, std::memory_order_release);
+      m_snapshot = nullptr;
+    }
+  }
+
+  explicit operator bool() const { return m_snapshot != nullptr; }
+
+  const PropagatedState<T> &state() const { return m_snapshot->State; }
+  T time() const { return m_snapshot->Time; }
+  std::uint64_t sequence() const { return m_snapshot->Sequence; }
+
+private:
+  const PropagatedSnapshot<T> *m_snapshot;
+};
+
+//-*****************************************************************************
+// Publishes propagated states from one writer thread to any number of
+// reader threads, none of which take a lock. A reader gets the newest
+// snapshot and holds it, unchanged, for as long as it likes, while the
+// writer goes on publishing newer ones.
+//
+// Snapshots are pooled rather than freed. A stale snapshot is only reused
+// for writing once it is no longer the newest and its last reader has let
+// go of it; if every snapshot is held, the writer makes another. The pool
+// therefore grows to the number of snapshots readers hold at once, plus
+// two, and all of it lives until the publisher is destroyed, which must
+// outlive every reference.
+//
+// A reader takes a reference by bumping the reference count of the newest
+// snapshot, then checking that it is still the newest; if not, it backs
+// off and tries again. The writer only reuses a snapshot that is not the
+// newest and has no references, having published a newer one first. Each
+// side stores then loads, so those operations are sequentially consistent;
+// the publishing store also releases the snapshot's contents to readers
+// that load it.
+template <typename T> class SnapshotPublisher {
+public:
+  typedef PropagatedSnapshot<T> snapshot_type;
+  typedef PropagatedSnapshotRef<T> ref_type;
+
+  explicit SnapshotPublisher(const Parameters<T> &i_params,
+                             unsigned int i_channels = kAllChannels)
+      : m_params(i_params), m_channels(i_channels), m_writing(nullptr),
+        m_sequence(0), m_newest(nullptr) {}
+
+  // Reader, on any thread: a reference to the newest snapshot, or an empty
+  // one if nothing has been published yet.
+  ref_type acquire() const {
+    const snapshot_type *snapshot = m_newest.load();
+    while (snapshot) {
+      snapshot->RefCount.fetch_add(1);
+      const snapshot_type *newest = m_newest.load();
+      if (newest == snapshot) {
+        return ref_type(snapshot);
+      }
+      snapshot->RefCount.fetch_sub(1);
+      snapshot = newest;
+    }
+    return ref_type();
+  }
+
+  // Writer: a state no reader can see, to write the next snapshot into.
+  // Calling this again before publish returns the same state.
+  PropagatedState<T> &beginWrite() {
+    if (!m_writing) {
+      const snapshot_type *newest = m_newest.load();
+      for (auto &snapshot : m_pool) {
+        if (snapshot.get() != newest && snapshot->RefCount.load() == 0) {
+          m_writing = snapshot.get();
+          break;
+        }
+      }
+      if (!m_writing) {
+        m_pool.emplace_back(new snapshot_type(m_params, m_channels));
+        m_writing = m_pool.back().get();
+      }
+    }
+    return m_writing->State;
+  }
+
+  // Writer: publishes the state written since beginWrite, as the snapshot
+  // of time i_time.
+  void publish(T i_time) {
+    EWAV_ASSERT(m_writing, "Publishing without writing a snapshot");
+    m_writing->Time = i_time;
+    m_writing->Sequence = ++m_sequence;
+    m_newest.store(m_writing);
+    m_writing = nullptr;
+  }
+
+  // Writer: the number of snapshots made so far.
+  std::size_t poolSize() const { return m_pool.size(); }
+
+protected:
+  Parameters<T> m_params;
+  unsigned int m_channels;
+
+  // Only touched by the writer.
+  std::vector<std::unique_ptr<snapshot_type>> m_pool;
+  snapshot_type *m_writing;
+  std::uint64_t m_sequence;
+
+  // The newest published snapshot, which every reader loads, padded away
+  // from the writer's bookkeeping.
+  char m_newestPadBefore[64];
+  std::atomic<const snapshot_type *> m_newest;
+  char m_newestPadAfter[64];
+};
+
+//-*****************************************************************************
+typedef SnapshotPublisher<float> SnapshotPublisherf;
+typedef SnapshotPublisher<double> SnapshotPublisherd;
+
+typedef PropagatedSnapshotRef<float> PropagatedSnapshotReff;
+typedef PropagatedSnapshotRef<double> PropagatedSnapshotRefd;
+
+} // namespace EncinoWaves
+
+#endif
@@ -40,6 +40,32 @@
 
 namespace EncinoWaves {
 
+//-*****************************************************************************
+// Memory of i_count values for a field, mapped as the field pages policy
+// says if it's large enough, or else from FFTW's allocator, and zeroed as
+// the field allocation policy says. o_mapped says which, for FreeFieldData.
+template <typename T, typename FFT>
+T* AllocateFieldData(std::size_t i_count, bool& o_mapped) {
+  const std::size_t bytes = std::max(i_count, std::size_t(1)) * sizeof(T);
+  void* data              = MapFieldMemory(bytes);
+  o_mapped                = (data != nullptr);
+  if (!o_mapped) {
+    data = FFT::Malloc(bytes);
+  }
+  T* values = reinterpret_cast<T*>(data);
+  FirstTouchZero(values, i_count);
+  return values;
+}
+
+template <typename T, typename FFT>
+void FreeFieldData(T* i_data, std::size_t i_count, bool i_mapped) {
+  if (i_mapped) {
+    UnmapFieldMemory(i_data, std::max(i_count, std::size_t(1)) * sizeof(T));
+  } else {
+    FFT::Free(i_data);
+  }
+}
+
 //-*****************************************************************************
 template <typename T>
 class BaseField2D {
@@ -59,7 +85,9 @@ protected:
       , m_height(i_height)
       , m_dataSize(static_cast<std::size_t>(i_width) *
                    static_cast<std::size_t>(i_height))
-      , m_data(nullptr) {
+      , m_data(nullptr)
+      , m_ownsData(false)
+      , m_mappedData(false) {
     // Nothing
   }
 
@@ -83,6 +111,9 @@ public:
   int height() const { return m_height; }
   std::size_t stride() const { return std::size_t(m_width); }
 
+  // Fields which don't own their data are views into a FieldSlab2D.
+  bool ownsData() const { return m_ownsData; }
+
   // Return a row, with wrapping.
   pointer row(int i_y) { return m_data + (wrap(i_y, m_height) * m_width); }
 
@@ -121,6 +152,8 @@ protected:
   int m_height;
   std::size_t m_dataSize;
   pointer m_data;
+  bool m_ownsData;
+  bool m_mappedData;
 };
 
 //-*****************************************************************************
@@ -141,24 +174,49 @@ public:
     this->m_data = nullptr;
   }
 
-  explicit SpatialField2D(int i_powerOfTwo, int i_pad = 0)
-      : super_type(i_pad + PowerOfTwo(Imath::clamp(i_powerOfTwo, 0, 30)),
-                   i_pad + PowerOfTwo(Imath::clamp(i_powerOfTwo, 0, 30)))
+  explicit SpatialField2D(const GridSize& i_size, int i_pad = 0)
+      : super_type(i_pad + i_size.Width, i_pad + i_size.Height)
       , m_pad(i_pad) {
     this->m_data =
-      reinterpret_cast<T*>(FFT::Malloc(this->m_dataSize * sizeof(T)));
-    std::fill(this->m_data, this->m_data + this->m_dataSize, T(0.0));
+      AllocateFieldData<T, FFT>(this->m_dataSize, this->m_mappedData);
+    this->m_ownsData = true;
   }
 
+  explicit SpatialField2D(int i_powerOfTwo, int i_pad = 0)
+      : SpatialField2D(GridSize::Square(i_powerOfTwo), i_pad) {}
+
+  // View of externally owned data, which is not freed by this field.
+  SpatialField2D(T* i_data, const GridSize& i_size, int i_pad)
+      : super_type(i_pad + i_size.Width, i_pad + i_size.Height)
+      , m_pad(i_pad) {
+    this->m_data = i_data;
+  }
+
+  SpatialField2D(T* i_data, int i_powerOfTwo, int i_pad)
+      : SpatialField2D(i_data, GridSize::Square(i_powerOfTwo), i_pad) {}
+
   ~SpatialField2D() {
-    if (this->m_data) {
-      FFT::Free(this->m_data);
-      this->m_data = nullptr;
+    if (this->m_data && this->m_ownsData) {
+      FreeFieldData<T, FFT>(this->m_data, this->m_dataSize, this->m_mappedData);
     }
+    this->m_data = nullptr;
+  }
+
+  // Number of values in a field of the given size.
+  static std::size_t DataSize(const GridSize& i_size, int i_pad = 0) {
+    return std::size_t(i_pad + i_size.Width) *
+           std::size_t(i_pad + i_size.Height);
+  }
+
+  static std::size_t DataSize(int i_powerOfTwo, int i_pad = 0) {
+    return DataSize(GridSize::Square(i_powerOfTwo), i_pad);
   }
 
   int unpaddedWidth() const { return this->width() - m_pad; }
   int unpaddedHeight() const { return this->height() - m_pad; }
+  GridSize gridSize() const {
+    return GridSize(unpaddedWidth(), unpaddedHeight());
+  }
   int padding() const { return m_pad; }
 };
 
@@ -169,8 +227,14 @@ public:
   typedef SpatialField2D<T> super_type;
   RealSpatialField2D()
       : super_type() {}
+  explicit RealSpatialField2D(const GridSize& i_size, int i_pad = 0)
+      : super_type(i_size, i_pad) {}
   explicit RealSpatialField2D(int i_powerOfTwo, int i_pad = 0)
       : super_type(i_powerOfTwo, i_pad) {}
+  RealSpatialField2D(T* i_data, const GridSize& i_size, int i_pad)
+      : super_type(i_data, i_size, i_pad) {}
+  RealSpatialField2D(T* i_data, int i_powerOfTwo, int i_pad)
+      : super_type(i_data, i_powerOfTwo, i_pad) {}
 };
 
 //-*****************************************************************************
@@ -180,8 +244,15 @@ public:
   typedef SpatialField2D<std::complex<T> > super_type;
   ComplexSpatialField2D()
       : super_type() {}
+  explicit ComplexSpatialField2D(const GridSize& i_size, int i_pad = 0)
+      : super_type(i_size, i_pad) {}
   explicit ComplexSpatialField2D(int i_powerOfTwo, int i_pad = 0)
       : super_type(i_powerOfTwo, i_pad) {}
+  ComplexSpatialField2D(std::complex<T>* i_data, const GridSize& i_size,
+                        int i_pad)
+      : super_type(i_data, i_size, i_pad) {}
+  ComplexSpatialField2D(std::complex<T>* i_data, int i_powerOfTwo, int i_pad)
+      : super_type(i_data, i_powerOfTwo, i_pad) {}
 };
 
 //-*****************************************************************************
@@ -204,20 +275,41 @@ public:
     this->m_data = nullptr;
   }
 
-  explicit SpectralField2D(int i_powerOfTwo)
-      : super_type((PowerOfTwo(Imath::clamp(i_powerOfTwo, 0, 30)) / 2) + 1,
-                   PowerOfTwo(Imath::clamp(i_powerOfTwo, 0, 30))) {
+  // The half spectrum of a real field on a grid of the given size, which
+  // is (Width / 2) + 1 wide.
+  explicit SpectralField2D(const GridSize& i_size)
+      : super_type((i_size.Width / 2) + 1, i_size.Height) {
     this->m_data =
-      reinterpret_cast<T*>(FFT::Malloc(this->m_dataSize * sizeof(T)));
+      AllocateFieldData<T, FFT>(this->m_dataSize, this->m_mappedData);
+    this->m_ownsData = true;
+  }
+
+  explicit SpectralField2D(int i_powerOfTwo)
+      : SpectralField2D(GridSize::Square(i_powerOfTwo)) {}
 
-    std::fill(this->m_data, this->m_data + this->m_dataSize, T(0.0));
+  // View of externally owned data, which is not freed by this field.
+  SpectralField2D(T* i_data, const GridSize& i_size)
+      : super_type((i_size.Width / 2) + 1, i_size.Height) {
+    this->m_data = i_data;
   }
 
+  SpectralField2D(T* i_data, int i_powerOfTwo)
+      : SpectralField2D(i_data, GridSize::Square(i_powerOfTwo)) {}
+
   ~SpectralField2D() {
-    if (this->m_data) {
-      FFT::Free(this->m_data);
-      this->m_data = nullptr;
+    if (this->m_data && this->m_ownsData) {
+      FreeFieldData<T, FFT>(this->m_data, this->m_dataSize, this->m_mappedData);
     }
+    this->m_data = nullptr;
+  }
+
+  // Number of values in a field of the given size.
+  static std::size_t DataSize(const GridSize& i_size) {
+    return (std::size_t(i_size.Width / 2) + 1) * std::size_t(i_size.Height);
+  }
+
+  static std::size_t DataSize(int i_powerOfTwo) {
+    return DataSize(GridSize::Square(i_powerOfTwo));
   }
 };
 
@@ -228,8 +320,14 @@ public:
   typedef SpectralField2D<T> super_type;
   RealSpectralField2D()
       : super_type() {}
+  explicit RealSpectralField2D(const GridSize& i_size)
+      : super_type(i_size) {}
   explicit RealSpectralField2D(int i_powerOfTwo)
       : super_type(i_powerOfTwo) {}
+  RealSpectralField2D(T* i_data, const GridSize& i_size)
+      : super_type(i_data, i_size) {}
+  RealSpectralField2D(T* i_data, int i_powerOfTwo)
+      : super_type(i_data, i_powerOfTwo) {}
 };
 
 //-*****************************************************************************
@@ -239,8 +337,83 @@ public:
   typedef SpectralField2D<std::complex<T> > super_type;
   ComplexSpectralField2D()
       : super_type() {}
+  explicit ComplexSpectralField2D(const GridSize& i_size)
+      : super_type(i_size) {}
   explicit ComplexSpectralField2D(int i_powerOfTwo)
       : super_type(i_powerOfTwo) {}
+  ComplexSpectralField2D(std::complex<T>* i_data, const GridSize& i_size)
+      : super_type(i_data, i_size) {}
+  ComplexSpectralField2D(std::complex<T>* i_data, int i_powerOfTwo)
+      : super_type(i_data, i_powerOfTwo) {}
+};
+
+//-*****************************************************************************
+//-*****************************************************************************
+// FIELD SLABS
+//-*****************************************************************************
+//-*****************************************************************************
+
+//-*****************************************************************************
+// A stack of equally sized fields in a single contiguous allocation. The
+// fields themselves are views into the slab. Because the distance between
+// successive fields is constant, FFTW can transform all of them with a single
+// "howmany" plan. Each field starts on a 64 byte boundary, so that a plan
+// made for one field can be executed on any other.
+template <typename FIELD>
+class FieldSlab2D {
+public:
+  typedef FIELD field_type;
+  typedef typename FIELD::value_type value_type;
+  typedef typename FIELD::FFT FFT;
+
+  template <typename... ARGS>
+  explicit FieldSlab2D(int i_count, ARGS... i_args)
+      : m_fieldStride(0)
+      , m_totalSize(0)
+      , m_data(nullptr)
+      , m_mapped(false) {
+    static constexpr std::size_t align = 64 / sizeof(value_type);
+    const std::size_t fieldSize        = FIELD::DataSize(i_args...);
+    m_fieldStride = align * ((fieldSize + align - 1) / align);
+
+    m_totalSize = m_fieldStride * std::size_t(i_count);
+    m_data = AllocateFieldData<value_type, FFT>(m_totalSize, m_mapped);
+
+    for (int i = 0; i < i_count; ++i) {
+      m_fields.emplace_back(
+        new FIELD(m_data + (std::size_t(i) * m_fieldStride), i_args...));
+    }
+  }
+
+  ~FieldSlab2D() {
+    m_fields.clear();
+    if (m_data) {
+      FreeFieldData<value_type, FFT>(m_data, m_totalSize, m_mapped);
+      m_data = nullptr;
+    }
+  }
+
+  FieldSlab2D(const FieldSlab2D&) = delete;
+  FieldSlab2D& operator=(const FieldSlab2D&) = delete;
+
+  int count() const { return static_cast<int>(m_fields.size()); }
+
+  // Distance, in values, from the start of one field to the next.
+  std::size_t fieldStride() const { return m_fieldStride; }
+
+  value_type* data() { return m_data; }
+  const value_type* data() const { return m_data; }
+  const value_type* cdata() const { return m_data; }
+
+  FIELD& operator[](int i_index) { return *(m_fields[i_index]); }
+  const FIELD& operator[](int i_index) const { return *(m_fields[i_index]); }
+
+protected:
+  std::size_t m_fieldStride;
+  std::size_t m_totalSize;
+  value_type* m_data;
+  bool m_mapped;
+  std::vector<std::unique_ptr<FIELD> > m_fields;
 };
 
 //-*****************************************************************************
@@ -257,78 +430,89 @@ public:
   typedef typename FFT::plan_type plan_type;
 
   SpectralToSpatial2D(ComplexSpectralField2D<T>& i_spectral,
-                      RealSpatialField2D<T>& o_spatial, int i_numThreads = -1)
-      : m_widthHeight(o_spatial.width()) {
-    EWAV_ASSERT((o_spatial.height() == m_widthHeight) &&
-                       (i_spectral.width() == ((m_widthHeight / 2) + 1)) &&
-                       (i_spectral.height() == m_widthHeight),
+                      RealSpatialField2D<T>& o_spatial, int i_numThreads = -1,
+                      const FftPlanOptions& i_options = FftPlanOptions())
+      : m_width(o_spatial.width())
+      , m_height(o_spatial.height()) {
+    EWAV_ASSERT((i_spectral.width() == ((m_width / 2) + 1)) &&
+                       (i_spectral.height() == m_height),
                      "Mismatched spectral and spatial sizes");
 
     if (i_numThreads <= 0) {
       i_numThreads = std::thread::hardware_concurrency();
     }
 
-    if (i_numThreads > 1) {
-      FftwInitThreadsT<T>();
-      // std::cout << "initialized threads" << std::endl;
-      FFT::plan_with_nthreads(i_numThreads);
-      // std::cout << "Using: " << i_numThreads << " threads" << std::endl;
-    }
-
 // We're creating an out-of-place transform that destroys input.
 #if 0
-        m_plan = FFT::plan_dft_c2r_2d( m_widthHeight, m_widthHeight,
+        m_plan = FFT::plan_dft_c2r_2d( m_width, m_height,
                                        i_spectral.data(),
                                        o_spatial.data(),
                                        FFTW_ESTIMATE | FFTW_DESTROY_INPUT );
 #else
-    m_plan = FFT::plan_guru_dft_c2r(m_widthHeight, m_widthHeight,
-                                    i_spectral.data(), o_spatial.data(),
-                                    FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+    m_planKey.kind   = kC2RPlanKind;
+    m_planKey.width  = m_width;
+    m_planKey.height = m_height;
+    m_planKey.inAlignment =
+      FFT::alignment_of(reinterpret_cast<T*>(i_spectral.data()));
+    m_planKey.outAlignment = FFT::alignment_of(o_spatial.data());
+    m_planKey.numThreads   = i_numThreads;
+    m_planKey.flags        = FFTW_DESTROY_INPUT;
+    m_planKey.rigor        = i_options.rigor;
+    m_plan                 = FftwPlanCacheT<T>::Acquire(
+      m_planKey, i_options, [&](unsigned int i_flags) {
+        return FFT::plan_guru_dft_c2r(m_width, m_height,
+                                      i_spectral.data(), o_spatial.data(),
+                                      i_flags);
+      });
 
 #endif
   }
 
   ~SpectralToSpatial2D() {
     if (m_plan) {
-      FFT::destroy_plan(m_plan);
+      FftwPlanCacheT<T>::Release(m_planKey);
       m_plan = nullptr;
     }
   }
 
   void execute(ComplexSpectralField2D<T>& i_spectral,
                RealSpatialField2D<T>& o_spatial) {
-    EWAV_ASSERT((i_spectral.width() == ((m_widthHeight / 2) + 1)) &&
-                       (i_spectral.height() == m_widthHeight) &&
-                       (o_spatial.width() == m_widthHeight) &&
-                       (o_spatial.height() == m_widthHeight),
+    EWAV_ASSERT((i_spectral.width() == ((m_width / 2) + 1)) &&
+                       (i_spectral.height() == m_height) &&
+                       (o_spatial.width() == m_width) &&
+                       (o_spatial.height() == m_height),
                      "Mismatched spectral and spatial sizes");
 
     FFT::execute_dft_c2r(m_plan, i_spectral.data(), o_spatial.data());
   }
 
 protected:
-  int m_widthHeight;
+  int m_width;
+  int m_height;
+  FftwPlanKey m_planKey;
   plan_type m_plan;
 };
 
 //-*****************************************************************************
+// Fills in the repeated border of a padded Width by Height field, from
+// rows [0, Height] of it.
 template <typename T>
 struct CopyWrappedBorder {
   T* Data;
-  int N;
+  int Width;
+  int Height;
 
   void operator()(const tbb::blocked_range<int>& i_rows) const {
-    std::size_t stride = N + 1;
+    std::size_t stride = Width + 1;
     for (int y = i_rows.begin(); y != i_rows.end(); ++y) {
-      if (y == N) {
-        std::copy(Data,                             // input begin
-                  Data + stride,                    // input end
-                  Data + (stride * std::size_t(N))  // output begin
+      if (y == Height) {
+        std::copy(Data,                                  // input begin
+                  Data + stride,                         // input end
+                  Data + (stride * std::size_t(Height))  // output begin
                   );
       } else {
-        std::size_t rowBeginIndex = y * stride;
-        Data[rowBeginIndex + N]   = Data[rowBeginIndex];
+        std::size_t rowBeginIndex   = y * stride;
+        Data[rowBeginIndex + Width] = Data[rowBeginIndex];
       }
     }
   }
@@ -343,43 +527,52 @@ public:
 
   SpectralToPaddedSpatial2D(ComplexSpectralField2D<T>& i_spectral,
                             RealSpatialField2D<T>& o_spatial,
-                            int i_numThreads = -1)
-      : m_widthHeight(i_spectral.height()) {
-    EWAV_ASSERT((o_spatial.width() == (m_widthHeight + 1)) &&
-                       (o_spatial.height() == (m_widthHeight + 1)) &&
-                       (i_spectral.width() == ((m_widthHeight / 2) + 1)),
+                            int i_numThreads = -1,
+                            const FftPlanOptions& i_options = FftPlanOptions())
+      : m_width(o_spatial.unpaddedWidth())
+      , m_height(o_spatial.unpaddedHeight()) {
+    EWAV_ASSERT((o_spatial.padding() == 1) &&
+                       (i_spectral.width() == ((m_width / 2) + 1)) &&
+                       (i_spectral.height() == m_height),
                      "Mismatched spectral and spatial sizes");
 
     if (i_numThreads <= 0) {
       i_numThreads = std::thread::hardware_concurrency();
     }
 
-    if (i_numThreads > 1) {
-      FftwInitThreadsT<T>();
-      // std::cout << "initialized threads" << std::endl;
-      FFT::plan_with_nthreads(i_numThreads);
-      // std::cout << "Using: " << i_numThreads << " threads" << std::endl;
-    }
-
     // We're creating an out-of-place transform that destroys input.
-    m_plan = FFT::plan_guru_dft_c2r_output_padded(
-      m_widthHeight, m_widthHeight, 1, 1, i_spectral.data(), o_spatial.data(),
-      FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+    m_planKey.kind      = kPaddedC2RPlanKind;
+    m_planKey.width     = m_width;
+    m_planKey.height    = m_height;
+    m_planKey.widthPad  = 1;
+    m_planKey.heightPad = 1;
+    m_planKey.inAlignment =
+      FFT::alignment_of(reinterpret_cast<T*>(i_spectral.data()));
+    m_planKey.outAlignment = FFT::alignment_of(o_spatial.data());
+    m_planKey.numThreads   = i_numThreads;
+    m_planKey.flags        = FFTW_DESTROY_INPUT;
+    m_planKey.rigor        = i_options.rigor;
+    m_plan                 = FftwPlanCacheT<T>::Acquire(
+      m_planKey, i_options, [&](unsigned int i_flags) {
+        return FFT::plan_guru_dft_c2r_output_padded(
+          m_width, m_height, 1, 1, i_spectral.data(),
+          o_spatial.data(), i_flags);
+      });
   }
 
   ~SpectralToPaddedSpatial2D() {
     if (m_plan) {
-      FFT::destroy_plan(m_plan);
+      FftwPlanCacheT<T>::Release(m_planKey);
       m_plan = nullptr;
     }
   }
 
   void execute(ComplexSpectralField2D<T>& i_spectral,
                RealSpatialField2D<T>& o_spatial) {
-    EWAV_ASSERT((i_spectral.width() == ((m_widthHeight / 2) + 1)) &&
-                       (i_spectral.height() == m_widthHeight) &&
-                       (o_spatial.width() == m_widthHeight + 1) &&
-                       (o_spatial.height() == m_widthHeight + 1),
+    EWAV_ASSERT((i_spectral.width() == ((m_width / 2) + 1)) &&
+                       (i_spectral.height() == m_height) &&
+                       (o_spatial.width() == m_width + 1) &&
+                       (o_spatial.height() == m_height + 1),
                      "Mismatched spectral and spatial sizes");
 
     FFT::execute_dft_c2r(m_plan, i_spectral.data(), o_spatial.data());
@@ -387,15 +580,361 @@ public:
     // Fill in the repeated border.
     {
       CopyWrappedBorder<T> F;
-      F.Data = o_spatial.data();
-      F.N = m_widthHeight;
-      tbb::parallel_for(tbb::blocked_range<int>(0, m_widthHeight + 1), F);
+      F.Data   = o_spatial.data();
+      F.Width  = m_width;
+      F.Height = m_height;
+      tbb::parallel_for(tbb::blocked_range<int>(0, m_height + 1), F);
     }
   }
 
 protected:
-  int m_widthHeight;
+  int m_width;
+  int m_height;
+  FftwPlanKey m_planKey;
+  plan_type m_plan;
+};
+
+//-*****************************************************************************
+// Fills in the repeated border of every field in a slab of padded fields.
+// The corner value is taken from the origin directly, rather than from the
+// first row's border, so that rows can be processed in any order.
+template <typename T>
+struct CopyWrappedBorders {
+  T* Data;
+  int Width;
+  int Height;
+  std::size_t FieldStride;
+
+  void operator()(const tbb::blocked_range<int>& i_rows) const {
+    const std::size_t stride = Width + 1;
+    for (int r = i_rows.begin(); r != i_rows.end(); ++r) {
+      T* field    = Data + (FieldStride * std::size_t(r / (Height + 1)));
+      const int y = r % (Height + 1);
+      if (y == Height) {
+        T* lastRow = field + (stride * std::size_t(Height));
+        std::copy(field, field + Width, lastRow);
+        lastRow[Width] = field[0];
+      } else {
+        std::size_t rowBeginIndex    = y * stride;
+        field[rowBeginIndex + Width] = field[rowBeginIndex];
+      }
+    }
+  }
+};
+
+//-*****************************************************************************
+// Copies the first rows of one padded field to another, without borders.
+template <typename T>
+struct CopyFieldRows {
+  const T* From;
+  T* To;
+  std::size_t RowSize;
+
+  void operator()(const tbb::blocked_range<int>& i_rows) const {
+    for (int y = i_rows.begin(); y != i_rows.end(); ++y) {
+      const std::size_t begin = RowSize * std::size_t(y);
+      std::copy(From + begin, From + begin + RowSize - 1, To + begin);
+    }
+  }
+};
+
+//-*****************************************************************************
+// Converts consecutive fields of a spectral slab into consecutive fields of
+// a padded spatial slab with one FFTW "howmany" plan, which amortizes the
+// planning, the twiddle factors and the thread startup across all of them.
+// By default every field is converted. Given a smaller count, the plan can
+// be executed on any run of that many fields of slabs with the same field
+// strides.
+template <typename T>
+class BatchSpectralToPaddedSpatial2D {
+public:
+  typedef FftwWrapperT<T> FFT;
+  typedef typename FFT::plan_type plan_type;
+  typedef FieldSlab2D<ComplexSpectralField2D<T> > spectral_slab_type;
+  typedef FieldSlab2D<RealSpatialField2D<T> > spatial_slab_type;
+
+  BatchSpectralToPaddedSpatial2D(spectral_slab_type& i_spectral,
+                                 spatial_slab_type& o_spatial,
+                                 int i_numThreads = -1, int i_count = -1,
+                                 const FftPlanOptions& i_options =
+                                   FftPlanOptions())
+      : m_width(o_spatial[0].unpaddedWidth())
+      , m_height(o_spatial[0].unpaddedHeight())
+      , m_count(i_count < 0 ? i_spectral.count() : i_count)
+      , m_spectralStride(i_spectral.fieldStride())
+      , m_spatialStride(o_spatial.fieldStride()) {
+    EWAV_ASSERT((m_count > 0) && (m_count <= i_spectral.count()) &&
+                  (m_count <= o_spatial.count()),
+                "Mismatched spectral and spatial slab counts");
+    EWAV_ASSERT((o_spatial[0].padding() == 1) &&
+                  (i_spectral[0].width() == ((m_width / 2) + 1)) &&
+                  (i_spectral[0].height() == m_height),
+                "Mismatched spectral and spatial sizes");
+
+    if (i_numThreads <= 0) {
+      i_numThreads = std::thread::hardware_concurrency();
+    }
+
+    // We're creating an out-of-place transform that destroys input.
+    m_planKey.kind      = kPaddedC2RManyPlanKind;
+    m_planKey.width     = m_width;
+    m_planKey.height    = m_height;
+    m_planKey.widthPad  = 1;
+    m_planKey.heightPad = 1;
+    m_planKey.howmany   = m_count;
+    m_planKey.inDist    = m_spectralStride;
+    m_planKey.outDist   = m_spatialStride;
+    m_planKey.inAlignment =
+      FFT::alignment_of(reinterpret_cast<T*>(i_spectral.data()));
+    m_planKey.outAlignment = FFT::alignment_of(o_spatial.data());
+    m_planKey.numThreads   = i_numThreads;
+    m_planKey.flags        = FFTW_DESTROY_INPUT;
+    m_planKey.rigor        = i_options.rigor;
+    m_plan                 = FftwPlanCacheT<T>::Acquire(
+      m_planKey, i_options, [&](unsigned int i_flags) {
+        return FFT::plan_guru_dft_c2r_output_padded_many(
+          m_width, m_height, 1, 1, m_count, m_spectralStride,
+          m_spatialStride, i_spectral.data(), o_spatial.data(), i_flags);
+      });
+  }
+
+  ~BatchSpectralToPaddedSpatial2D() {
+    if (m_plan) {
+      FftwPlanCacheT<T>::Release(m_planKey);
+      m_plan = nullptr;
+    }
+  }
+
+  int count() const { return m_count; }
+
+  void execute(spectral_slab_type& i_spectral, spatial_slab_type& o_spatial) {
+    execute(i_spectral, 0, o_spatial, 0);
+  }
+
+  // Converts spectral fields [i_spectralBegin, i_spectralBegin + count())
+  // into spatial fields [i_spatialBegin, i_spatialBegin + count()).
+  void execute(spectral_slab_type& i_spectral, int i_spectralBegin,
+               spatial_slab_type& o_spatial, int i_spatialBegin) {
+    EWAV_ASSERT((i_spectralBegin >= 0) && (i_spatialBegin >= 0) &&
+                  (i_spectralBegin + m_count <= i_spectral.count()) &&
+                  (i_spatialBegin + m_count <= o_spatial.count()) &&
+                  (i_spectral.fieldStride() == m_spectralStride) &&
+                  (o_spatial.fieldStride() == m_spatialStride) &&
+                  (o_spatial[0].width() == m_width + 1) &&
+                  (o_spatial[0].height() == m_height + 1),
+                "Mismatched spectral and spatial slabs");
+
+    T* spatial = o_spatial.data() + (m_spatialStride * i_spatialBegin);
+    FFT::execute_dft_c2r(
+      m_plan, i_spectral.data() + (m_spectralStride * i_spectralBegin),
+      spatial);
+
+    // Fill in the repeated borders.
+    {
+      CopyWrappedBorders<T> F;
+      F.Data        = spatial;
+      F.Width       = m_width;
+      F.Height      = m_height;
+      F.FieldStride = m_spatialStride;
+      tbb::parallel_for(
+        tbb::blocked_range<int>(0, m_count * (m_height + 1)), F);
+    }
+  }
+
+protected:
+  int m_width;
+  int m_height;
+  int m_count;
+  std::size_t m_spectralStride;
+  std::size_t m_spatialStride;
+  FftwPlanKey m_planKey;
+  plan_type m_plan;
+};
+
+//-*****************************************************************************
+// Two-for-one conversion of pairs of real fields. The input slab holds pairs
+// of unpadded real fields, which are the real and imaginary parts of
+// full (not half) complex spectra, in the order re0, im0, re1, im1, ...
+// Each complex spectrum is the packed spectrum Z = A + iB of two real
+// fields a and b, whose spectra A and B are Hermitian. The backward
+// transform of Z is then a + ib, and the split-array plan writes a and b
+// straight into consecutive fields of a padded spatial slab. This trades
+// the c2r transforms of BatchSpectralToPaddedSpatial2D for half as many c2c
+// transforms, at the cost of full (rather than half) spectra.
+//
+// As with BatchSpectralToPaddedSpatial2D, a count can be given, and the
+// plan executed on any run of that many spatial fields. An odd count leaves
+// the last field without a partner; it is packed with B = 0 and transformed
+// into a pair of scratch fields, and its real half is copied out. Its
+// imaginary half is just rounding noise.
+template <typename T>
+class PackedSpectralToPaddedSpatial2D {
+public:
+  typedef FftwWrapperT<T> FFT;
+  typedef typename FFT::plan_type plan_type;
+  typedef FieldSlab2D<RealSpatialField2D<T> > packed_slab_type;
+  typedef FieldSlab2D<RealSpatialField2D<T> > spatial_slab_type;
+
+  PackedSpectralToPaddedSpatial2D(packed_slab_type& i_packed,
+                                  spatial_slab_type& o_spatial,
+                                  int i_numThreads = -1, int i_count = -1,
+                                  spatial_slab_type* o_oddScratch = nullptr,
+                                  const FftPlanOptions& i_options =
+                                    FftPlanOptions())
+      : m_width(o_spatial[0].unpaddedWidth())
+      , m_height(o_spatial[0].unpaddedHeight())
+      , m_count(i_count < 0 ? o_spatial.count() : i_count)
+      , m_packedStride(i_packed.fieldStride())
+      , m_spatialStride(o_spatial.fieldStride())
+      , m_oddScratch(o_oddScratch)
+      , m_plan(nullptr)
+      , m_oddPlan(nullptr) {
+    EWAV_ASSERT((m_count > 0) && (m_count <= o_spatial.count()) &&
+                  (2 * numPairs() <= i_packed.count()),
+                "Mismatched packed and spatial slab counts");
+    EWAV_ASSERT((i_packed[0].width() == m_width) &&
+                  (i_packed[0].height() == m_height) &&
+                  (o_spatial[0].padding() == 1),
+                "Mismatched packed and spatial sizes");
+    EWAV_ASSERT(((m_count % 2) == 0) ||
+                  (m_oddScratch && (m_oddScratch->count() >= 2) &&
+                   ((*m_oddScratch)[0].width() == o_spatial[0].width()) &&
+                   ((*m_oddScratch)[0].height() == o_spatial[0].height())),
+                "Odd packed transforms need two padded scratch fields");
+
+    if (i_numThreads <= 0) {
+      i_numThreads = std::thread::hardware_concurrency();
+    }
+
+    // We're creating out-of-place transforms that destroy input.
+    T* packed  = i_packed.data();
+    T* spatial = o_spatial.data();
+    FftwPlanKey key;
+    key.kind         = kSplitBackwardPaddedManyPlanKind;
+    key.width        = m_width;
+    key.height       = m_height;
+    key.widthPad     = 1;
+    key.heightPad    = 1;
+    key.inDist       = 2 * m_packedStride;
+    key.inSplit      = m_packedStride;
+    key.inAlignment  = FFT::alignment_of(packed);
+    key.outAlignment = FFT::alignment_of(spatial);
+    key.numThreads   = i_numThreads;
+    key.flags        = FFTW_DESTROY_INPUT;
+    key.rigor        = i_options.rigor;
+    if (m_count / 2 > 0) {
+      m_planKey          = key;
+      m_planKey.howmany  = m_count / 2;
+      m_planKey.outDist  = 2 * m_spatialStride;
+      m_planKey.outSplit = m_spatialStride;
+      m_plan             = FftwPlanCacheT<T>::Acquire(
+        m_planKey, i_options, [&](unsigned int i_flags) {
+          return FFT::plan_guru_split_dft_backward_output_padded_many(
+            m_width, m_height, 1, 1, m_count / 2,
+            2 * m_packedStride, 2 * m_spatialStride, packed,
+            packed + m_packedStride, spatial, spatial + m_spatialStride,
+            i_flags);
+        });
+    }
+    if (m_count % 2) {
+      // Both halves of the odd transform go to the scratch fields, so that
+      // the distance between them is the same wherever the plan is run.
+      T* scratch                      = m_oddScratch->data();
+      const std::size_t scratchStride = m_oddScratch->fieldStride();
+      m_oddPlanKey                    = key;
+      m_oddPlanKey.howmany            = 1;
+      m_oddPlanKey.outDist            = 2 * scratchStride;
+      m_oddPlanKey.outSplit           = scratchStride;
+      m_oddPlanKey.outAlignment       = FFT::alignment_of(scratch);
+      m_oddPlan                       = FftwPlanCacheT<T>::Acquire(
+        m_oddPlanKey, i_options, [&](unsigned int i_flags) {
+          return FFT::plan_guru_split_dft_backward_output_padded_many(
+            m_width, m_height, 1, 1, 1, 2 * m_packedStride,
+            2 * scratchStride, packed, packed + m_packedStride, scratch,
+            scratch + scratchStride, i_flags);
+        });
+    }
+  }
+
+  ~PackedSpectralToPaddedSpatial2D() {
+    if (m_plan) {
+      FftwPlanCacheT<T>::Release(m_planKey);
+      m_plan = nullptr;
+    }
+    if (m_oddPlan) {
+      FftwPlanCacheT<T>::Release(m_oddPlanKey);
+      m_oddPlan = nullptr;
+    }
+  }
+
+  int count() const { return m_count; }
+
+  // Number of packed spectra (pairs of packed fields) consumed.
+  int numPairs() const { return (m_count + 1) / 2; }
+
+  void execute(packed_slab_type& i_packed, spatial_slab_type& o_spatial) {
+    execute(i_packed, 0, o_spatial, 0);
+  }
+
+  // Converts the packed spectra starting at packed field i_packedBegin,
+  // which must be even, into spatial fields
+  // [i_spatialBegin, i_spatialBegin + count()).
+  void execute(packed_slab_type& i_packed, int i_packedBegin,
+               spatial_slab_type& o_spatial, int i_spatialBegin) {
+    EWAV_ASSERT((i_packedBegin >= 0) && ((i_packedBegin % 2) == 0) &&
+                  (i_spatialBegin >= 0) &&
+                  (i_packedBegin + 2 * numPairs() <= i_packed.count()) &&
+                  (i_spatialBegin + m_count <= o_spatial.count()) &&
+                  (i_packed.fieldStride() == m_packedStride) &&
+                  (o_spatial.fieldStride() == m_spatialStride) &&
+                  (o_spatial[0].width() == m_width + 1) &&
+                  (o_spatial[0].height() == m_height + 1),
+                "Mismatched packed and spatial slabs");
+
+    T* packed  = i_packed.data() + (m_packedStride * i_packedBegin);
+    T* spatial = o_spatial.data() + (m_spatialStride * i_spatialBegin);
+    if (m_plan) {
+      FFT::execute_split_dft_backward(m_plan, packed, packed + m_packedStride,
+                                      spatial, spatial + m_spatialStride);
+    }
+    if (m_oddPlan) {
+      const std::size_t last = std::size_t(m_count - 1);
+      T* oddPacked           = packed + (m_packedStride * last);
+      T* scratch             = m_oddScratch->data();
+      FFT::execute_split_dft_backward(
+        m_oddPlan, oddPacked, oddPacked + m_packedStride, scratch,
+        scratch + m_oddScratch->fieldStride());
+
+      CopyFieldRows<T> F;
+      F.From    = scratch;
+      F.To      = spatial + (m_spatialStride * last);
+      F.RowSize = m_width + 1;
+      tbb::parallel_for(tbb::blocked_range<int>(0, m_height), F);
+    }
+
+    // Fill in the repeated borders.
+    {
+      CopyWrappedBorders<T> F;
+      F.Data        = spatial;
+      F.Width       = m_width;
+      F.Height      = m_height;
+      F.FieldStride = m_spatialStride;
+      tbb::parallel_for(
+        tbb::blocked_range<int>(0, m_count * (m_height + 1)), F);
+    }
+  }
+
+protected:
+  int m_width;
+  int m_height;
+  int m_count;
+  std::size_t m_packedStride;
+  std::size_t m_spatialStride;
+  spatial_slab_type* m_oddScratch;
+  FftwPlanKey m_planKey;
   plan_type m_plan;
+  FftwPlanKey m_oddPlanKey;
+  plan_type m_oddPlan;
 };
 
 //-*****************************************************************************
@@ -0,0 +1,213 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#ifndef _EncinoWaves_SpectralStats_h_
+#define _EncinoWaves_SpectralStats_h_
+
+#include "Foundation.h"
+#include "Basics.h"
+#include "SpectralSpatialField.h"
+#include "Parameters.h"
+#include "InitialState.h"
+
+namespace EncinoWaves {
+
+//-*****************************************************************************
+// Statistics of the propagated fields that come straight from the height
+// spectrum, by Parseval's theorem, without transforming it: the mean of the
+// Nx x Ny periodic height field is its DC bin, and its variance is the sum of
+// |H(k)|^2 over the other bins. Dxx, Dyy and Dxy have spectra of kx^2/|k|,
+// ky^2/|k| and kx ky/|k| times H(k), so their second moments are sums of
+// the same powers, weighted.
+//
+// MinE is -(A - B) of the Jacobian J = I - pinch * [Dxx Dxy; Dxy Dyy],
+// with A half its trace and B half the spread of its eigenvalues. MinE
+// itself isn't linear in the spectrum, but A is, and B^2 is quadratic, so
+// the mean and standard deviation of A and the mean of B^2 are exact. By
+// Jensen's inequality the mean of B is at most the root mean of B^2, which
+// bounds the mean of MinE from above.
+//
+// Only the stored half spectrum is visited. Bins with 0 < kx < Nx/2 stand
+// for themselves and their conjugates at -k, so count twice. The kx = 0
+// column, and the kx = Nx/2 column when Nx is even, hold both k and -k, and
+// are first made Hermitian the way the c2r transform does implicitly, by
+// averaging each bin with the conjugate of its partner. In the kx = Nx/2
+// column the partner is stored with kx rather than -kx, which flips the sign
+// of kx ky, so Dxy takes the difference instead. Rows are summed in double
+// precision, and the row sums added in order, so the results don't depend on
+// threading.
+//
+// The spatial Stats work over the (Nx+1) x (Ny+1) padded fields, which repeat
+// the first row and column, so they differ slightly from these.
+template <typename T>
+struct SpectralStats {
+  typedef std::complex<T> complex_type;
+
+  T MeanHeight;
+  T StdDevHeight;
+
+  T MeanJacobianTrace;
+  T StdDevJacobianTrace;
+  T RmsJacobianSpread;
+  T MaxMeanMinE;
+
+  // Exact moments of the fields that i_hspec, a propagated height spectrum,
+  // transforms to. The pinch defaults to the one propagate uses for MinE.
+  SpectralStats(const Parameters<T>& i_params,
+                const ComplexSpectralField2D<T>& i_hspec,
+                T i_pinch = T(1.25)) {
+    const complex_type* h = i_hspec.cdata();
+    const GridSize size   = i_params.gridSize();
+    EWAV_ASSERT(i_hspec.width() == (size.Width / 2) + 1 &&
+                  i_hspec.height() == size.Height,
+                "Height spectrum doesn't match the parameters");
+    compute(i_params, size, i_pinch,
+            [h](std::size_t i_index, std::size_t i_partner, bool i_selfConj,
+                double& o_even, double& o_odd, complex_type& o_dc) {
+              if (!i_selfConj) {
+                o_even = o_odd = 2.0 * std::norm(h[i_index]);
+                return;
+              }
+              const complex_type hp = std::conj(h[i_partner]);
+              o_dc   = T(0.5) * (h[i_index] + hp);
+              o_even = std::norm(o_dc);
+              o_odd  = std::norm(T(0.5) * (h[i_index] - hp));
+            });
+  }
+
+  // Moments of the fields propagated from i_istate, averaged over time.
+  // Each bin's height is P e^(i w t) + N e^(-i w t), whose cross term
+  // averages away, leaving the powers of P and N.
+  SpectralStats(const Parameters<T>& i_params, const InitialState<T>& i_istate,
+                T i_pinch = T(1.25)) {
+    const complex_type* p = i_istate.HSpectralPos.cdata();
+    const complex_type* n = i_istate.HSpectralNeg.cdata();
+    compute(i_params, i_istate.Size, i_pinch,
+            [p, n](std::size_t i_index, std::size_t i_partner,
+                   bool i_selfConj, double& o_even, double& o_odd,
+                   complex_type& o_dc) {
+              if (!i_selfConj) {
+                o_even = o_odd =
+                  2.0 * (std::norm(p[i_index]) + std::norm(n[i_index]));
+                return;
+              }
+              const complex_type np = std::conj(n[i_partner]);
+              const complex_type pp = std::conj(p[i_partner]);
+              o_dc   = T(0.5) * ((p[i_index] + np) + (n[i_index] + pp));
+              o_even = std::norm(T(0.5) * (p[i_index] + np)) +
+                       std::norm(T(0.5) * (n[i_index] + pp));
+              o_odd = std::norm(T(0.5) * (p[i_index] - np)) +
+                      std::norm(T(0.5) * (n[i_index] - pp));
+            });
+  }
+
+protected:
+  // i_power(index, partnerIndex, selfConjugate, even, odd, dc) gives the
+  // power of a bin over the full plane, of its Hermitian part, and of its
+  // anti-Hermitian part, which only differ in the self conjugate columns.
+  // It also sets dc to the bin's Hermitian value there, used at DC.
+  template <typename POWER>
+  void compute(const Parameters<T>& i_params, const GridSize& i_size,
+               T i_pinch, const POWER& i_power) {
+    const int Nx                = i_size.Width;
+    const int Ny                = i_size.Height;
+    const std::size_t width     = std::size_t(Nx / 2) + 1;
+    const std::size_t nyquistX  = (Nx % 2) == 0 ? width - 1 : width;
+    const Imath::Vec2<T> domain = i_params.domainSize();
+    const double dKx            = TAU<double> / double(domain[0]);
+    const double dKy            = TAU<double> / double(domain[1]);
+
+    // Per row: height power, and the powers of Dxx + Dyy, Dxx - Dyy & Dxy.
+    enum { kH, kTrace, kDiff, kDxy, kNumSums };
+    std::vector<double> rows(std::size_t(Ny) * kNumSums, 0.0);
+    complex_type dc(0, 0);
+
+    tbb::parallel_for(
+      tbb::blocked_range<int>(0, Ny), [&](const tbb::blocked_range<int>& r) {
+        for (int j = r.begin(); j != r.end(); ++j) {
+          const int realJ     = j <= (Ny / 2) ? j : j - Ny;
+          const double ky     = double(realJ) * dKy;
+          const std::size_t y = std::size_t(j);
+          const std::size_t partnerY = std::size_t((Ny - j) % Ny);
+          double* sums = rows.data() + (y * kNumSums);
+          for (std::size_t i = 0; i < width; ++i) {
+            const bool selfConj = (i == 0) || (i == nyquistX);
+            double power    = 0.0;
+            double oddPower = 0.0;
+            complex_type c(0, 0);
+            i_power((y * width) + i, (partnerY * width) + i, selfConj, power,
+                    oddPower, c);
+            if (i == 0 && j == 0) {
+              dc = c;
+              continue;
+            }
+            const double kx   = double(i) * dKx;
+            const double kMag = std::hypot(kx, ky);
+            const double lxx  = kx * kx / kMag;
+            const double lyy  = ky * ky / kMag;
+            const double lxy  = kx * ky / kMag;
+            sums[kH] += power;
+            sums[kTrace] += sqr(lxx + lyy) * power;
+            sums[kDiff] += sqr(lxx - lyy) * power;
+            sums[kDxy] += sqr(lxy) * (i == nyquistX ? oddPower : power);
+          }
+        }
+      });
+
+    double totals[kNumSums] = {0.0, 0.0, 0.0, 0.0};
+    for (int j = 0; j < Ny; ++j) {
+      for (int s = 0; s < kNumSums; ++s) {
+        totals[s] += rows[(std::size_t(j) * kNumSums) + s];
+      }
+    }
+
+    // Derivative spectra are zero at DC, so A has a mean of exactly one.
+    const double pinch2  = sqr(double(i_pinch));
+    MeanHeight           = dc.real();
+    StdDevHeight         = T(std::sqrt(totals[kH]));
+    MeanJacobianTrace    = T(1);
+    StdDevJacobianTrace  = T(std::sqrt(pinch2 * totals[kTrace] / 4.0));
+    RmsJacobianSpread    =
+      T(std::sqrt(pinch2 * ((totals[kDiff] / 4.0) + totals[kDxy])));
+    MaxMeanMinE = RmsJacobianSpread - MeanJacobianTrace;
+  }
+};
+
+//-*****************************************************************************
+typedef SpectralStats<float> SpectralStatsf;
+typedef SpectralStats<double> SpectralStatsd;
+
+}  // namespace EncinoWaves
+
+#endif
@@ -40,125 +40,119 @@
 namespace EncinoWaves {
 
 //-*****************************************************************************
+// Count, min, max, mean and sum of squared deviations from the mean of a set
+// of values, which merge with those of another set by the pairwise update
+// of Chan, Golub & LeVeque, so variances can be reduced without the
+// cancellation of summing squares.
 template <typename T>
-struct MinMaxSum {
-  T min;
-  T max;
-  T sum;
-  MinMaxSum()
-    : min(std::numeric_limits<T>::max())
-    , max(-std::numeric_limits<T>::max())
-    , sum(T(0)) {}
-
-  MinMaxSum(const MinMaxSum<T>& i_s, tbb::split)
-    : min(std::numeric_limits<T>::max())
-    , max(-std::numeric_limits<T>::max())
-    , sum(T(0)) {}
-
-  void operator()(const tbb::blocked_range<const T*>& i_range) {
-    T tmin = min;
-    T tmax = max;
-    T tsum = sum;
-    for (const T* a = i_range.begin(); a != i_range.end(); ++a) {
-      T ai = *a;
-      if (ai < tmin) {
-        tmin = ai;
-      }
-      if (ai > tmax) {
-        tmax = ai;
-      }
+struct Moments {
+  std::size_t Count;
+  T Min;
+  T Max;
+  T Mean;
+  T M2;
+
+  Moments()
+    : Count(0)
+    , Min(std::numeric_limits<T>::max())
+    , Max(-std::numeric_limits<T>::max())
+    , Mean(T(0))
+    , M2(T(0)) {}
+
+  // The moments of a block of values, from its sum and then its squared
+  // deviations, the second loop running over values still in cache.
+  Moments(const T* i_values, std::size_t i_size)
+    : Count(i_size)
+    , Min(std::numeric_limits<T>::max())
+    , Max(-std::numeric_limits<T>::max())
+    , Mean(T(0))
+    , M2(T(0)) {
+    if (i_size == 0) {
+      return;
+    }
+    T tmin = Min;
+    T tmax = Max;
+    T tsum = T(0);
+    for (std::size_t i = 0; i < i_size; ++i) {
+      const T ai = i_values[i];
+      tmin = std::min(tmin, ai);
+      tmax = std::max(tmax, ai);
       tsum += ai;
     }
-    min = tmin;
-    max = tmax;
-    sum = tsum;
-  }
-  void join(const MinMaxSum<T>& i_rhs) {
-    min = std::min(min, i_rhs.min);
-    max = std::max(max, i_rhs.max);
-    sum += i_rhs.sum;
+    const T mean = tsum / T(i_size);
+    T tm2 = T(0);
+    for (std::size_t i = 0; i < i_size; ++i) {
+      tm2 += sqr(i_values[i] - mean);
+    }
+    Min  = tmin;
+    Max  = tmax;
+    Mean = mean;
+    M2   = tm2;
   }
-};
-
-//-*****************************************************************************
-template <typename T>
-void ParallelMinMaxSum(const T* i_values, std::size_t i_size, T& o_min,
-                       T& o_max, T& o_sum) {
-  MinMaxSum<T> mms;
-  tbb::parallel_reduce(
-    tbb::blocked_range<const T*>(i_values, i_values + i_size), mms);
-  o_min = mms.min;
-  o_max = mms.max;
-  o_sum = mms.sum;
-}
 
-//-*****************************************************************************
-template <typename T>
-struct Sum {
-  T value;
-  Sum()
-    : value(T(0)) {}
-  Sum(const Sum<T>& i_s, tbb::split)
-    : value(T(0)) {}
-  void operator()(const tbb::blocked_range<const T*>& i_range) {
-    T temp = value;
-    for (const T* a = i_range.begin(); a != i_range.end(); ++a) {
-      temp += *a;
+  void merge(const Moments<T>& i_rhs) {
+    if (i_rhs.Count == 0) {
+      return;
     }
-    value = temp;
+    if (Count == 0) {
+      *this = i_rhs;
+      return;
+    }
+    const T na    = T(Count);
+    const T nb    = T(i_rhs.Count);
+    const T n     = na + nb;
+    const T delta = i_rhs.Mean - Mean;
+    Mean += delta * (nb / n);
+    M2 += i_rhs.M2 + sqr(delta) * (na * nb / n);
+    Min = std::min(Min, i_rhs.Min);
+    Max = std::max(Max, i_rhs.Max);
+    Count += i_rhs.Count;
   }
-  void join(const Sum<T>& i_rhs) { value += i_rhs.value; }
-};
 
-//-*****************************************************************************
-template <typename T>
-T ParallelSum(const T* i_values, std::size_t i_size) {
-  Sum<T> sum;
-  tbb::parallel_reduce(
-    tbb::blocked_range<const T*>(i_values, i_values + i_size), sum);
-  return sum.value;
-}
+  T variance() const { return Count > 0 ? M2 / T(Count) : T(0); }
+  T stdDev() const { return std::sqrt(variance()); }
+};
 
 //-*****************************************************************************
-template <typename T>
-T ParallelMean(const T* i_values, std::size_t i_size) {
-  typedef typename singular_value_type<T>::type denom_type;
-
-  return ParallelSum(i_values, i_size) / denom_type(i_size);
-}
+// Values per block of ParallelMoments. Blocks are the leaves of its
+// reduction tree, so this fixes its results, whatever the thread count.
+constexpr std::size_t kMomentsBlockSize = 4096;
 
 //-*****************************************************************************
+// The moments of i_numFields arrays of i_size values each, in one pass over
+// all of them. The arrays are cut into fixed blocks, whose moments are
+// computed in parallel, then merged pairwise in a fixed tree, so the
+// results are bit for bit the same however the blocks were scheduled.
 template <typename T>
-struct VarianceSum {
-  T value;
-  T mean;
-  explicit VarianceSum(const T& i_mean)
-    : value(T(0))
-    , mean(i_mean) {}
-  VarianceSum(const VarianceSum<T>& i_v, tbb::split)
-    : value(T(0))
-    , mean(i_v.mean) {}
-  void operator()(const tbb::blocked_range<const T*>& i_range) {
-    T temp = value;
-    for (const T* a = i_range.begin(); a != i_range.end(); ++a) {
-      temp += sqr(*a - mean);
+void ParallelMoments(const T* const* i_fields, int i_numFields,
+                     std::size_t i_size, Moments<T>* o_moments) {
+  const std::size_t numBlocks =
+    (i_size + kMomentsBlockSize - 1) / kMomentsBlockSize;
+  std::vector<Moments<T>> blocks(numBlocks * i_numFields);
+
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, numBlocks),
+                    [&](const tbb::blocked_range<std::size_t>& i_range) {
+                      for (std::size_t b = i_range.begin();
+                           b != i_range.end(); ++b) {
+                        const std::size_t begin = b * kMomentsBlockSize;
+                        const std::size_t size =
+                          std::min(kMomentsBlockSize, i_size - begin);
+                        for (int f = 0; f < i_numFields; ++f) {
+                          blocks[f * numBlocks + b] =
+                            Moments<T>(i_fields[f] + begin, size);
+                        }
+                      }
+                    });
+
+  for (int f = 0; f < i_numFields; ++f) {
+    Moments<T>* fb = blocks.data() + f * numBlocks;
+    for (std::size_t stride = 1; stride < numBlocks; stride *= 2) {
+      for (std::size_t b = 0; b + stride < numBlocks; b += 2 * stride) {
+        fb[b].merge(fb[b + stride]);
+      }
     }
-    value = temp;
+    o_moments[f] = numBlocks > 0 ? fb[0] : Moments<T>();
   }
-  void join(const VarianceSum<T>& i_rhs) { value += i_rhs.value; }
-};
-
-//-*****************************************************************************
-template <typename T>
-T ParallelStdDev(T i_mean, const T* i_values, std::size_t i_size) {
-  typedef typename singular_value_type<T>::type denom_type;
-
-  VarianceSum<T> vsum(i_mean);
-  tbb::parallel_reduce(
-    tbb::blocked_range<const T*>(i_values, i_values + i_size), vsum);
-  T variance = std::abs(vsum.value / denom_type(i_size));
-
-  return std::sqrt(variance);
 }
 
 //-*****************************************************************************
@@ -167,38 +161,31 @@ struct Stats {
   T MinHeight;
   T MaxHeight;
   T MeanHeight;
+  T StdDevHeight;
 
+  T MinMinE;
+  T MaxMinE;
   T MeanMinE;
   T StdDevMinE;
 
-#if 0
-    explicit Stats( const PropagatedState<T>& i_waves )
-    {
-        ParallelMinMaxSum<T>( i_waves.Height.cdata(), i_waves.Height.size(),
-                              MinHeight, MaxHeight, MeanHeight );
-        MeanHeight /= T( i_waves.Height.size() );
-
-        MeanMinE = ParallelMean<T>( i_waves.MinE.cdata(), i_waves.MinE.size() );
-        StdDevMinE =
-            ParallelStdDev<T>( MeanMinE,
-                               i_waves.MinE.cdata(), i_waves.MinE.size() );
-
-        std::cout <<
-                  ( boost::format( "Height (min, max, mean): (%f, %f, %f)" )
-                    % MinHeight % MaxHeight % MeanHeight ) << std::endl <<
-                  ( boost::format( "MinE (mean, stddev): (%f, %f)" )
-                    % MeanMinE % StdDevMinE ) << std::endl;
-    }
-#endif
-
+  // Both fields are reduced together in a single pass, and the results
+  // don't depend on the number of threads.
   Stats(const RealSpatialField2D<T>& Height,
         const RealSpatialField2D<T>& MinE) {
-    ParallelMinMaxSum<T>(Height.cdata(), Height.size(), MinHeight, MaxHeight,
-                         MeanHeight);
-    MeanHeight /= T(Height.size());
-
-    MeanMinE   = ParallelMean<T>(MinE.cdata(), MinE.size());
-    StdDevMinE = ParallelStdDev<T>(MeanMinE, MinE.cdata(), MinE.size());
+    EWAV_ASSERT(Height.size() == MinE.size(), "Mismatched stats fields");
+    const T* fields[2] = {Height.cdata(), MinE.cdata()};
+    Moments<T> moments[2];
+    ParallelMoments<T>(fields, 2, Height.size(), moments);
+
+    MinHeight    = moments[0].Min;
+    MaxHeight    = moments[0].Max;
+    MeanHeight   = moments[0].Mean;
+    StdDevHeight = moments[0].stdDev();
+
+    MinMinE    = moments[1].Min;
+    MaxMinE    = moments[1].Max;
+    MeanMinE   = moments[1].Mean;
+    StdDevMinE = moments[1].stdDev();
 
     // std::cout <<
     //          ( boost::format( "Height (min, max, mean): (%f, %f, %f)" )
@@ -186,6 +186,11 @@ int main(int argc, char *argv[]) {
       ->default_value( params.troughDampingSoftWidth ),
       "Trough damping soft width." )
 
+    ( "loopPeriod",
+      po::value<float>( &params.loopPeriod )
+      ->default_value( params.loopPeriod ),
+      "Loop period in seconds, or zero for no loop." )
+
     ( "random",
       po::value<int>( &random )
       ->default_value( random ),
@@ -45,6 +45,7 @@ Mesh::Mesh(const ewav::Parametersf& i_wparams, const Sky::Parameters& i_sparams,
            const DrawParameters& i_dparams)
   : m_params(i_wparams)
   , m_drawParams(i_dparams)
+  , m_wavesFrame(nullptr)
   , m_frame(1)
   , m_vertexArrayObject(0) {
   //-*************************************************************************
@@ -52,34 +53,27 @@ Mesh::Mesh(const ewav::Parametersf& i_wparams, const Sky::Parameters& i_sparams,
   //-*************************************************************************
 
   // Create initial state...
-  m_wavesInitialState.reset(new ewav::InitialStatef(m_params));
+  m_wavesNoise.reset(new ewav::InitialStateNoisef(m_params));
+  m_wavesInitialState.reset(new ewav::InitialStatef(m_params, *m_wavesNoise));
   N = m_wavesInitialState->HSpectralPos.height();
   std::cout << "Created Initial State. " << std::endl
             << "Resolution: " << N << " x " << N << std::endl;
 
-  // Create propagated state.
-  m_wavesPropagatedState.reset(new ewav::PropagatedStatef(m_params));
-  std::cout << "Created Propagated State. " << std::endl;
-
-  // Create propagation
-  m_wavesPropagation.reset(new ewav::Propagationf(m_params));
+  // Create propagation, with normals, and a ring of three frames.
+  m_wavesPropagation.reset(
+    new ewav::AsyncPropagationf(m_params, 3, ewav::kAllChannels, true));
+  m_wavesPropagation->setInitialState(m_wavesInitialState.get());
   std::cout << "Created Propagation." << std::endl;
 
-  // Init propagated state.
+  // Init propagated state and normals.
   float time = float(m_frame) / 24.0;
-  m_wavesPropagation->propagate(m_params, *m_wavesInitialState,
-                                *m_wavesPropagatedState, time);
+  m_wavesPropagation->request(m_params, time);
+  acquireFrame();
   std::cout << "Propagated to start frame" << std::endl;
 
-  // Compute normals.
-  m_normals.resize((N + 1) * (N + 1));
-  ewav::ComputeNormals<float>(m_params, *m_wavesPropagatedState,
-                              &(m_normals.front()));
-  std::cout << "Computed normals." << std::endl;
-
   // Gather stats.
-  m_wavesStats.reset(new ewav::Statsf(m_wavesPropagatedState->Height,
-                                      m_wavesPropagatedState->MinE));
+  m_wavesStats.reset(new ewav::Statsf(m_wavesFrame->State.Height,
+                                      m_wavesFrame->State.MinE));
   std::cout << "Gathered stats." << std::endl;
 
   //-*************************************************************************
@@ -171,7 +165,7 @@ Mesh::Mesh(const ewav::Parametersf& i_wparams, const Sky::Parameters& i_sparams,
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[H_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer H");
   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * dataSize,
-               m_wavesPropagatedState->Height.cdata(), GL_DYNAMIC_DRAW);
+               m_wavesFrame->State.Height.cdata(), GL_DYNAMIC_DRAW);
   UtilGL::CheckErrors("glBufferData H");
   glEnableVertexAttribArray(H_BUFFER);
   UtilGL::CheckErrors("glEnableVertexAttribArray H");
@@ -182,7 +176,7 @@ Mesh::Mesh(const ewav::Parametersf& i_wparams, const Sky::Parameters& i_sparams,
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[DX_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer DX");
   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * dataSize,
-               m_wavesPropagatedState->Dx.cdata(), GL_DYNAMIC_DRAW);
+               m_wavesFrame->State.Dx.cdata(), GL_DYNAMIC_DRAW);
   UtilGL::CheckErrors("glBufferData DX");
   glEnableVertexAttribArray(DX_BUFFER);
   UtilGL::CheckErrors("glEnableVertexAttribArray DX");
@@ -193,7 +187,7 @@ Mesh::Mesh(const ewav::Parametersf& i_wparams, const Sky::Parameters& i_sparams,
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[DY_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer DY");
   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * dataSize,
-               m_wavesPropagatedState->Dy.cdata(), GL_DYNAMIC_DRAW);
+               m_wavesFrame->State.Dy.cdata(), GL_DYNAMIC_DRAW);
   UtilGL::CheckErrors("glBufferData DY");
   glEnableVertexAttribArray(DY_BUFFER);
   UtilGL::CheckErrors("glEnableVertexAttribArray DY");
@@ -204,7 +198,7 @@ Mesh::Mesh(const ewav::Parametersf& i_wparams, const Sky::Parameters& i_sparams,
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[MINE_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer MINE");
   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * dataSize,
-               m_wavesPropagatedState->MinE.cdata(), GL_DYNAMIC_DRAW);
+               m_wavesFrame->State.MinE.cdata(), GL_DYNAMIC_DRAW);
   UtilGL::CheckErrors("glBufferData MINE");
   glEnableVertexAttribArray(MINE_BUFFER);
   UtilGL::CheckErrors("glEnableVertexAttribArray MINE");
@@ -214,8 +208,8 @@ Mesh::Mesh(const ewav::Parametersf& i_wparams, const Sky::Parameters& i_sparams,
   // Normals buffer.
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[NORMALS_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer NORMALS");
-  glBufferData(GL_ARRAY_BUFFER, sizeof(V3f) * dataSize, &(m_normals.front()),
-               GL_DYNAMIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(V3f) * dataSize,
+               &(m_wavesFrame->Normals.front()), GL_DYNAMIC_DRAW);
   UtilGL::CheckErrors("glBufferData NORMALS");
   glEnableVertexAttribArray(NORMALS_BUFFER);
   UtilGL::CheckErrors("glEnableVertexAttribArray NORMALS");
@@ -256,7 +250,8 @@ Mesh::~Mesh() {
 //-*****************************************************************************
 void Mesh::step() {
   ++m_frame;
-  propagateAtFrame();
+  acquireFrame();
+  uploadFrame();
 }
 
 //-*****************************************************************************
@@ -351,6 +346,7 @@ void Mesh::setWavesParams(const ewav::Parametersf& i_wparams) {
   CHECK_INIT_CHANGE(filter.invert);
   CHECK_INIT_CHANGE(random.type);
   CHECK_INIT_CHANGE(random.seed);
+  CHECK_INIT_CHANGE(loopPeriod);
 
 #undef CHECK_INIT_CHANGE
 
@@ -369,15 +365,24 @@ void Mesh::setWavesParams(const ewav::Parametersf& i_wparams) {
       domainChange();
     }
 
-    // Create initial state...
-    m_wavesInitialState.reset(new ewav::InitialStatef(m_params));
+    // Create initial state, and only let go of the old one once the
+    // propagation is done with it. Changes to the waves other than to
+    // their random draws only re-evaluate the spectral envelope.
+    if (!m_wavesNoise->matches(m_params)) {
+      m_wavesNoise.reset(new ewav::InitialStateNoisef(m_params));
+      std::cout << "Reset Random Draws. " << std::endl;
+    }
+    std::unique_ptr<ewav::InitialStatef> istate(
+      new ewav::InitialStatef(m_params, *m_wavesNoise));
+    m_wavesPropagation->setInitialState(istate.get());
+    m_wavesInitialState = std::move(istate);
     std::cout << "Reset Initial State. " << std::endl;
 
     propagateAtFrame();
 
     // Gather stats.
-    m_wavesStats.reset(new ewav::Statsf(m_wavesPropagatedState->Height,
-                                        m_wavesPropagatedState->MinE));
+    m_wavesStats.reset(new ewav::Statsf(m_wavesFrame->State.Height,
+                                        m_wavesFrame->State.MinE));
     // std::cout << "Gathered stats." << std::endl;
   } else {
     CHECK_PROP_CHANGE(troughDamping);
@@ -388,8 +393,8 @@ void Mesh::setWavesParams(const ewav::Parametersf& i_wparams) {
     if (reProp) {
       propagateAtFrame();
       // Gather stats.
-      m_wavesStats.reset(new ewav::Statsf(m_wavesPropagatedState->Height,
-                                          m_wavesPropagatedState->MinE));
+      m_wavesStats.reset(new ewav::Statsf(m_wavesFrame->State.Height,
+                                          m_wavesFrame->State.MinE));
     }
   }
 
@@ -431,14 +436,27 @@ void Mesh::domainChange() {
 }
 
 //-*****************************************************************************
+// Propagates the current frame with the current parameters, discarding the
+// frame that was being propagated ahead, and draws it.
 void Mesh::propagateAtFrame() {
   float time = float(m_frame) / 24.0;
-  m_wavesPropagation->propagate(m_params, *m_wavesInitialState,
-                                *m_wavesPropagatedState, time);
+  m_wavesPropagation->request(m_params, time);
+  acquireFrame();
+  uploadFrame();
+}
 
-  ewav::ComputeNormals<float>(m_params, *m_wavesPropagatedState,
-                              &(m_normals.front()));
+//-*****************************************************************************
+// Waits for the last requested frame, which is usually done already, and
+// starts on the next one while this one is drawn.
+void Mesh::acquireFrame() {
+  m_wavesPropagation->wait();
+  m_wavesFrame = m_wavesPropagation->acquire();
+  float nextTime = float(m_frame + 1) / 24.0;
+  m_wavesPropagation->request(m_params, nextTime);
+}
 
+//-*****************************************************************************
+void Mesh::uploadFrame() {
   // Activate VAO
   glBindVertexArray(m_vertexArrayObject);
   UtilGL::CheckErrors("glBindVertexArray step");
@@ -449,35 +467,35 @@ void Mesh::propagateAtFrame() {
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[H_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer H");
   glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * dataSize,
-                  m_wavesPropagatedState->Height.cdata());
+                  m_wavesFrame->State.Height.cdata());
   UtilGL::CheckErrors("glBufferData H");
 
   // dx buffer.
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[DX_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer DX");
   glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * dataSize,
-                  m_wavesPropagatedState->Dx.cdata());
+                  m_wavesFrame->State.Dx.cdata());
   UtilGL::CheckErrors("glBufferData DX");
 
   // dy buffer.
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[DY_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer DY");
   glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * dataSize,
-                  m_wavesPropagatedState->Dy.cdata());
+                  m_wavesFrame->State.Dy.cdata());
   UtilGL::CheckErrors("glBufferData DY");
 
   // MinE buffer.
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[MINE_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer MINE");
   glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * dataSize,
-                  m_wavesPropagatedState->MinE.cdata());
+                  m_wavesFrame->State.MinE.cdata());
   UtilGL::CheckErrors("glBufferData MINE");
 
   // Normals buffer.
   glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffers[NORMALS_BUFFER]);
   UtilGL::CheckErrors("glBindBuffer NORMALS");
   glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(V3f) * dataSize,
-                  &(m_normals.front()));
+                  &(m_wavesFrame->Normals.front()));
   UtilGL::CheckErrors("glBufferData NORMALS");
 
   // Unbind
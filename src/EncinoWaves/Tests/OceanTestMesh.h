@@ -76,22 +76,28 @@ protected:
   void setWavesUniforms();
   void domainChange();
   void propagateAtFrame();
+  void acquireFrame();
+  void uploadFrame();
 
   // Waves parameters - sky params will be stored in sky
   ewav::Parametersf m_params;
   DrawParameters m_drawParams;
 
   // Waves system itself.
+  // The random draws of the initial state are kept, and only drawn again
+  // when the seed or the type of random distribution changes.
+  std::unique_ptr<ewav::InitialStateNoisef> m_wavesNoise;
   std::unique_ptr<ewav::InitialStatef> m_wavesInitialState;
-  std::unique_ptr<ewav::PropagatedStatef> m_wavesPropagatedState;
-  std::unique_ptr<ewav::Propagationf> m_wavesPropagation;
+  // Frames are propagated on the propagation's own thread, one frame
+  // ahead of the one being drawn.
+  std::unique_ptr<ewav::AsyncPropagationf> m_wavesPropagation;
+  const ewav::AsyncPropagatedFramef* m_wavesFrame;
   std::unique_ptr<ewav::Statsf> m_wavesStats;
   int N;
 
   // Non-changing arrays of the wave system.
   std::vector<V2f> m_vertsXY;
   std::vector<GLuint> m_indices;
-  std::vector<V3f> m_normals;
 
   // The time
   int m_frame;
@@ -0,0 +1,149 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// Best-of-n time, in seconds, to propagate a frame from i_istate.
+template <typename ISTATE>
+double timePropagate(const ewav::Parametersf& i_params,
+                     const ISTATE& i_istate, int i_iterations) {
+  ewav::Propagationf prop(i_params);
+  ewav::PropagatedStatef pstate(i_params);
+
+  double best = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    ewav::Timer timer;
+    prop.propagate(i_params, i_istate, pstate, 0.1f * float(iter + 1));
+    best = std::min(best, timer.elapsed());
+  }
+  return best;
+}
+
+//-*****************************************************************************
+// Best-of-n time, in seconds, of the spectral pass alone: reading the
+// initial spectra and writing all six propagated spectra, without the
+// transforms. This is the only part of a frame a compact state changes.
+template <typename ISTATE>
+double timeSpectra(const ewav::Parametersf& i_params, const ISTATE& i_istate,
+                   int i_iterations) {
+  using namespace ewav;
+  const int power = i_params.resolutionPowerOfTwo;
+  std::vector<std::unique_ptr<CSpectralField2Df>> specs;
+  for (int f = 0; f < kNumPropagatedFields; ++f) {
+    specs.emplace_back(new CSpectralField2Df(power));
+  }
+
+  double best = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    PROPSPECS<float> F{InitialSpectra<float>(i_istate)};
+    F.Phasor.Omega         = F.Initial.Omega;
+    F.Phasor.OmegaFoldRows = F.Initial.OmegaFoldRows;
+    F.Phasor.OmegaStride   = std::size_t(F.Initial.Size.Width / 2) + 1;
+    F.Phasor.Time          = 0.1f * float(iter + 1);
+    F.Filter               = nullptr;
+    F.HFiltSpecProp        = nullptr;
+    for (int f = 0; f < kNumPropagatedFields; ++f) {
+      F.Specs.SpecProp[f] = specs[f]->data();
+    }
+
+    Timer timer;
+    SpectralIterationFunctor<float, PROPSPECS<float>, PROPSPECS<float>> SIF(
+      &F, i_params.domain, specs[0]->height());
+    best = std::min(best, timer.elapsed());
+  }
+  return best;
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_CompactInitialState [iterations] [powerOfTwo ...]
+// Compares the memory of an initial state and a compact one, the time to
+// propagate a frame from each, and the time of the spectral pass alone,
+// which doesn't depend on the FFT. Defaults to N=4096.
+int main(int argc, char* argv[]) {
+  int iterations = 3;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(12);
+  }
+
+  for (int power : powers) {
+    ewav::Parametersf params;
+    params.resolutionPowerOfTwo = power;
+
+    double fullTime       = 0.0;
+    double fullSpectra    = 0.0;
+    std::size_t fullBytes = 0;
+    std::unique_ptr<ewav::CompactInitialStatef> compact;
+    {
+      ewav::InitialStatef istate(params);
+      fullBytes = (istate.HSpectralPos.size() + istate.HSpectralNeg.size()) *
+                    sizeof(std::complex<float>) +
+                  istate.Omega.size() * sizeof(float);
+      fullTime    = timePropagate(params, istate, iterations);
+      fullSpectra = timeSpectra(params, istate, iterations);
+      compact.reset(new ewav::CompactInitialStatef(istate));
+    }
+    const double compactTime = timePropagate(params, *compact, iterations);
+    const double compactSpectra = timeSpectra(params, *compact, iterations);
+
+    std::cout << "N = " << (1 << power) << std::endl
+              << (boost::format("  %-16s %9.1f MB %9.3f ms, spectra %9.3f ms") %
+                  "initial state" % (double(fullBytes) / 1048576.0) %
+                  (1000.0 * fullTime) % (1000.0 * fullSpectra))
+              << std::endl
+              << (boost::format("  %-16s %9.1f MB %9.3f ms, spectra %9.3f ms") %
+                  "compact" % (double(compact->memorySize()) / 1048576.0) %
+                  (1000.0 * compactTime) % (1000.0 * compactSpectra))
+              << std::endl
+              << (boost::format("  spectral pass: %+.1f%%") %
+                  (100.0 * (compactSpectra / fullSpectra - 1.0)))
+              << std::endl;
+  }
+
+  return 0;
+}
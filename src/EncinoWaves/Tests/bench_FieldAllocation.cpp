@@ -0,0 +1,133 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// Best-of-n times, in seconds, for making a propagated state and a
+// propagation, and for propagate on them, with the fields first touched as
+// i_allocation says.
+void timeAllocation(ewav::FieldAllocation i_allocation,
+                    const ewav::Parametersf& i_params,
+                    const ewav::InitialStatef& i_istate, int i_iterations,
+                    double& o_allocateTime, double& o_propagateTime) {
+  ewav::SetFieldAllocation(i_allocation);
+  o_allocateTime  = 1.0e30;
+  o_propagateTime = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    ewav::Timer allocateTimer;
+    ewav::PropagatedStatef pstate(i_params);
+    ewav::Propagationf prop(i_params);
+    o_allocateTime = std::min(o_allocateTime, allocateTimer.elapsed());
+
+    for (int frame = 0; frame < 4; ++frame) {
+      ewav::Timer timer;
+      prop.propagate(i_params, i_istate, pstate, float(frame + 1) / 24.0f);
+      o_propagateTime = std::min(o_propagateTime, timer.elapsed());
+    }
+  }
+}
+
+//-*****************************************************************************
+void bench(int i_powerOfTwo, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+  params.troughDamping        = 0.5f;
+
+  ewav::InitialStatef istate(params);
+
+  // Whether the pages of a field can be interleaved here at all.
+  ewav::RSpatialField2Df probe(i_powerOfTwo, 1);
+  const bool interleaves =
+    ewav::InterleavePages(probe.data(), probe.size() * sizeof(float));
+
+  std::cout << "N = " << istate.resolution() << ", "
+            << tbb::this_task_arena::max_concurrency() << " threads, "
+            << (interleaves ? "interleaving" : "no interleaving, single node")
+            << std::endl;
+
+  const char* names[] = {"serial", "parallel", "interleaved"};
+  const ewav::FieldAllocation allocations[] = {
+    ewav::kSerialFieldAllocation, ewav::kParallelFieldAllocation,
+    ewav::kInterleavedFieldAllocation};
+  double propagateBase = 0.0;
+  for (int a = 0; a < 3; ++a) {
+    double allocateTime  = 0.0;
+    double propagateTime = 0.0;
+    timeAllocation(allocations[a], params, istate, i_iterations, allocateTime,
+                   propagateTime);
+    if (a == 0) {
+      propagateBase = propagateTime;
+    }
+    std::cout << (boost::format("  %-12s allocate %9.3f ms, "
+                                "propagate %9.3f ms (%5.2fx)") %
+                  names[a] % (1000.0 * allocateTime) %
+                  (1000.0 * propagateTime) % (propagateBase / propagateTime))
+              << std::endl;
+  }
+  ewav::SetFieldAllocation(ewav::kParallelFieldAllocation);
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_FieldAllocation [iterations] [powerOfTwo ...]
+// Times making the fields of propagate, and propagate itself, with the
+// fields first touched serially, in parallel, and interleaved over the NUMA
+// nodes. The differences in propagate only show on a machine with more
+// than one socket. Defaults to N=2048.
+int main(int argc, char* argv[]) {
+  int iterations = 3;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(11);
+  }
+
+  for (int power : powers) {
+    bench(power, iterations);
+  }
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// A line of /proc/meminfo, such as AnonHugePages, or -1 if there's none.
+long MemInfoKB(const std::string& i_name) {
+  std::ifstream meminfo("/proc/meminfo");
+  std::string name;
+  long value = 0;
+  std::string unit;
+  while (meminfo >> name >> value) {
+    std::getline(meminfo, unit);
+    if (name == i_name + ":") {
+      return value;
+    }
+  }
+  return -1;
+}
+
+//-*****************************************************************************
+// Best-of-n times, in seconds, for the batched transform of all six
+// propagated fields and for a whole propagate, on fields backed by i_pages.
+// Also reports how much of the memory the kernel backed with huge pages.
+void timePages(ewav::FieldPages i_pages, const ewav::Parametersf& i_params,
+               const ewav::InitialStatef& i_istate, int i_iterations,
+               double& o_fftTime, double& o_propagateTime,
+               long& o_hugeKB) {
+  ewav::SetFieldPages(i_pages);
+  const long anonBefore     = MemInfoKB("AnonHugePages");
+  const long explicitBefore = MemInfoKB("HugePages_Free");
+  {
+    ewav::Propagationf prop(i_params);
+    ewav::PropagatedStatef pstate(i_params);
+
+    o_fftTime       = 1.0e30;
+    o_propagateTime = 1.0e30;
+    for (int iter = 0; iter < i_iterations; ++iter) {
+      const float time = float(iter + 1) / 24.0f;
+      {
+        ewav::Timer timer;
+        prop.propagate(i_params, i_istate, pstate, time);
+        o_propagateTime = std::min(o_propagateTime, timer.elapsed());
+      }
+      {
+        ewav::Propagationf::converter_type& conv =
+          prop.converter(ewav::kNumPropagatedFields);
+        ewav::Timer timer;
+        conv.execute(*prop.Spectra, pstate.Fields);
+        o_fftTime = std::min(o_fftTime, timer.elapsed());
+      }
+    }
+
+    const long hugePageKB = long(ewav::kHugePageSize / 1024);
+    o_hugeKB = std::max(0L, MemInfoKB("AnonHugePages") - anonBefore) +
+               (hugePageKB *
+                std::max(0L, explicitBefore - MemInfoKB("HugePages_Free")));
+  }
+  ewav::SetFieldPages(ewav::kSmallFieldPages);
+}
+
+//-*****************************************************************************
+void bench(int i_powerOfTwo, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+
+  ewav::InitialStatef istate(params);
+
+  std::cout << "N = " << istate.resolution() << ", huge pages reserved: "
+            << MemInfoKB("HugePages_Total") << std::endl;
+  const char* names[] = {"small", "transparent", "explicit"};
+  const ewav::FieldPages pages[] = {ewav::kSmallFieldPages,
+                                    ewav::kTransparentHugeFieldPages,
+                                    ewav::kExplicitHugeFieldPages};
+  double fftBase       = 0.0;
+  double propagateBase = 0.0;
+  for (int p = 0; p < 3; ++p) {
+    double fftTime       = 0.0;
+    double propagateTime = 0.0;
+    long hugeKB          = 0;
+    timePages(pages[p], params, istate, i_iterations, fftTime,
+              propagateTime, hugeKB);
+    if (p == 0) {
+      fftBase       = fftTime;
+      propagateBase = propagateTime;
+    }
+    std::cout << (boost::format("  %-12s fft %9.3f ms (%5.2fx), "
+                                "propagate %9.3f ms (%5.2fx), "
+                                "%6ld MB in huge pages") %
+                  names[p] % (1000.0 * fftTime) % (fftBase / fftTime) %
+                  (1000.0 * propagateTime) %
+                  (propagateBase / propagateTime) % (hugeKB / 1024))
+              << std::endl;
+  }
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_HugePages [iterations] [powerOfTwo ...]
+// Times the transforms and propagate with the fields on small pages, on
+// transparent huge pages, and on explicit huge pages, which need a pool
+// reserved with /proc/sys/vm/nr_hugepages, and otherwise fall back to
+// transparent ones. Defaults to N=4096.
+int main(int argc, char* argv[]) {
+  int iterations = 5;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(12);
+  }
+
+  for (int power : powers) {
+    bench(power, iterations);
+  }
+
+  return 0;
+}
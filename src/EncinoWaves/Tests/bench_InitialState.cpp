@@ -0,0 +1,123 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// Best-of-n time, in seconds, to make the initial state with i_spreading.
+double timeInitialState(ewav::DirectionalSpreadingType i_spreading,
+                        int i_powerOfTwo, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo      = i_powerOfTwo;
+  params.directionalSpreading.type = i_spreading;
+
+  double best = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    ewav::Timer timer;
+    ewav::InitialStatef istate(params);
+    best = std::min(best, timer.elapsed());
+  }
+  return best;
+}
+
+//-*****************************************************************************
+// Best-of-n time, in seconds, to make the initial state with i_spreading
+// from random draws cached beforehand, as after a change to the wind.
+double timeCachedInitialState(ewav::DirectionalSpreadingType i_spreading,
+                              int i_powerOfTwo, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo      = i_powerOfTwo;
+  params.directionalSpreading.type = i_spreading;
+  ewav::InitialStateNoisef noise(params);
+
+  double best = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    ewav::Timer timer;
+    ewav::InitialStatef istate(params, noise);
+    best = std::min(best, timer.elapsed());
+  }
+  return best;
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_InitialState [iterations] [powerOfTwo ...]
+// Times making the initial state with each directional spreading model,
+// drawing its random numbers and from cached ones.
+// Defaults to N=4096.
+int main(int argc, char* argv[]) {
+  int iterations = 3;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(12);
+  }
+
+  const char* names[] = {"pos cos theta squared", "Mitsuyasu", "Hasselmann",
+                         "Donelan Banner"};
+  const ewav::DirectionalSpreadingType spreadings[] = {
+    ewav::kPosCosThetaSqrDirectionalSpreading,
+    ewav::kMitsuyasuDirectionalSpreading, ewav::kHasselmannDirectionalSpreading,
+    ewav::kDonelanBannerDirectionalSpreading};
+
+  for (int power : powers) {
+    std::vector<double> times;
+    std::vector<double> cachedTimes;
+    for (int s = 0; s < 4; ++s) {
+      times.push_back(timeInitialState(spreadings[s], power, iterations));
+      cachedTimes.push_back(
+        timeCachedInitialState(spreadings[s], power, iterations));
+    }
+    std::cout << "N = " << (1 << power) << "  (drawn, cached draws)"
+              << std::endl;
+    for (int s = 0; s < 4; ++s) {
+      std::cout << (boost::format("  %-22s %9.3f ms %9.3f ms") % names[s] %
+                    (1000.0 * times[s]) % (1000.0 * cachedTimes[s]))
+                << std::endl;
+    }
+  }
+
+  return 0;
+}
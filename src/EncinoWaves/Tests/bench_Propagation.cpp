@@ -0,0 +1,142 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// Best-of-n time for a propagate, in seconds.
+double timePropagate(ewav::Propagationf& io_prop,
+                     const ewav::Parametersf& i_params,
+                     const ewav::InitialStatef& i_istate,
+                     ewav::PropagatedStatef& o_pstate, int i_iterations) {
+  double best = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    ewav::Timer timer;
+    io_prop.propagate(i_params, i_istate, o_pstate,
+                      float(iter + 1) / 24.0f);
+    best = std::min(best, timer.elapsed());
+  }
+  return best;
+}
+
+//-*****************************************************************************
+void bench(int i_powerOfTwo, float i_troughDamping, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+  params.troughDamping = i_troughDamping;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef pstate(params);
+  ewav::Propagationf prop(params);
+
+  prop.setTransform(ewav::kRealPropagationTransform);
+  const double realTime =
+      timePropagate(prop, params, istate, pstate, i_iterations);
+
+  ewav::PropagatedStatef heightState(params, ewav::kHeightChannel);
+  const double heightTime =
+      timePropagate(prop, params, istate, heightState, i_iterations);
+
+  prop.setTransform(ewav::kPackedComplexPropagationTransform);
+  const double packedTime =
+      timePropagate(prop, params, istate, pstate, i_iterations);
+
+  // Per frame time of propagateBatch, in passes of 4 frames.
+  double batchTime = 1.0e30;
+  if (i_troughDamping == 0.0f) {
+    const int numFrames = 8;
+    std::vector<float> times;
+    std::vector<std::unique_ptr<ewav::PropagatedStatef>> states;
+    std::vector<ewav::PropagatedStatef*> statePtrs;
+    for (int f = 0; f < numFrames; ++f) {
+      times.push_back(float(f + 1) / 24.0f);
+      states.emplace_back(new ewav::PropagatedStatef(params));
+      statePtrs.push_back(states.back().get());
+    }
+    for (int iter = 0; iter < std::max(i_iterations / numFrames, 1); ++iter) {
+      ewav::Timer timer;
+      prop.propagateBatch(params, istate, times.data(), statePtrs.data(),
+                          numFrames);
+      batchTime = std::min(batchTime, timer.elapsed() / numFrames);
+    }
+  }
+
+  std::cout << "N = " << istate.resolution()
+            << ", trough damping = " << i_troughDamping << std::endl
+            << (boost::format("  real:    %8.3f ms") % (1000.0 * realTime))
+            << std::endl
+            << (boost::format("  packed:  %8.3f ms, speedup: %.2fx") %
+                (1000.0 * packedTime) % (realTime / packedTime))
+            << std::endl
+            << (boost::format("  height:  %8.3f ms, speedup: %.2fx") %
+                (1000.0 * heightTime) % (realTime / heightTime))
+            << std::endl;
+  if (i_troughDamping == 0.0f) {
+    std::cout << (boost::format("  batch:   %8.3f ms/frame, speedup: %.2fx") %
+                  (1000.0 * batchTime) % (realTime / batchTime))
+              << std::endl;
+  }
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_Propagation [iterations] [powerOfTwo ...]
+// Defaults to N=2048 and N=4096, each with and without trough damping.
+int main(int argc, char* argv[]) {
+  int iterations = 10;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(11);
+    powers.push_back(12);
+  }
+
+  for (int power : powers) {
+    bench(power, 0.0f, iterations);
+    bench(power, 0.5f, iterations);
+  }
+
+  return 0;
+}
@@ -0,0 +1,185 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// The baseline: the newest state behind a mutex, as a shared pointer that
+// readers copy. The writer makes a new state for every publish.
+struct MutexPublisher {
+  ewav::Parametersf Params;
+  std::mutex Mutex;
+  std::shared_ptr<const ewav::PropagatedStatef> Newest;
+  std::shared_ptr<ewav::PropagatedStatef> Writing;
+
+  explicit MutexPublisher(const ewav::Parametersf& i_params)
+    : Params(i_params) {}
+
+  std::shared_ptr<const ewav::PropagatedStatef> acquire() {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Newest;
+  }
+
+  ewav::PropagatedStatef& beginWrite() {
+    Writing = std::make_shared<ewav::PropagatedStatef>(Params);
+    return *Writing;
+  }
+
+  void publish() {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Newest = std::move(Writing);
+  }
+};
+
+//-*****************************************************************************
+// Samples a few heights of a snapshot, as a gameplay thread would.
+float sample(const ewav::PropagatedStatef& i_state, std::size_t i_seed) {
+  const float* h = i_state.Height.cdata();
+  const std::size_t size = i_state.Height.size();
+  float sum = 0.0f;
+  for (int i = 0; i < 4; ++i) {
+    sum += h[(i_seed * 7919 + i * 104729) % size];
+  }
+  return sum;
+}
+
+//-*****************************************************************************
+// One writer propagating and publishing while i_numReaders readers acquire
+// a snapshot, sample it and let it go, for i_seconds. Reports reads per
+// second over all readers, and frames per second of the writer.
+template <typename PUBLISHER, typename ACQUIRE, typename PUBLISH>
+void contend(const char* i_name, PUBLISHER& i_publisher, int i_numReaders,
+             const ewav::Parametersf& i_params,
+             const ewav::InitialStatef& i_istate, double i_seconds,
+             const ACQUIRE& i_acquire, const PUBLISH& i_publish) {
+  ewav::Propagationf prop(i_params, 1);
+  std::atomic<bool> done(false);
+  std::atomic<long> reads(0);
+  std::atomic<float> sink(0.0f);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < i_numReaders; ++r) {
+    readers.emplace_back([&, r] {
+      long count = 0;
+      float sum = 0.0f;
+      while (!done.load(std::memory_order_relaxed)) {
+        sum += i_acquire(i_publisher, std::size_t(r + count));
+        ++count;
+      }
+      reads += count;
+      sink = sum;
+    });
+  }
+
+  ewav::Timer timer;
+  long frames = 0;
+  while (timer.elapsed() < i_seconds) {
+    const float time = float(frames) / 24.0f;
+    prop.propagate(i_params, i_istate, i_publisher.beginWrite(), time);
+    i_publish(i_publisher, time);
+    ++frames;
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  const double elapsed = timer.elapsed();
+
+  std::cout << (boost::format("  %-9s %3d readers: %10.3f M reads/s, "
+                              "%8.1f frames/s") %
+                i_name % i_numReaders % (1.0e-6 * reads.load() / elapsed) %
+                (frames / elapsed))
+            << std::endl;
+}
+
+//-*****************************************************************************
+void bench(int i_powerOfTwo, double i_seconds, int i_maxReaders) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+  ewav::InitialStatef istate(params);
+
+  std::cout << "N = " << istate.resolution() << std::endl;
+  for (int n = 1; n <= i_maxReaders; n *= 2) {
+    {
+      ewav::SnapshotPublisherf publisher(params);
+      contend("snapshot", publisher, n, params, istate, i_seconds,
+              [](ewav::SnapshotPublisherf& p, std::size_t i_seed) {
+                ewav::PropagatedSnapshotReff snapshot = p.acquire();
+                return snapshot ? sample(snapshot.state(), i_seed) : 0.0f;
+              },
+              [](ewav::SnapshotPublisherf& p, float i_time) {
+                p.publish(i_time);
+              });
+    }
+    {
+      MutexPublisher publisher(params);
+      contend("mutex", publisher, n, params, istate, i_seconds,
+              [](MutexPublisher& p, std::size_t i_seed) {
+                std::shared_ptr<const ewav::PropagatedStatef> state =
+                  p.acquire();
+                return state ? sample(*state, i_seed) : 0.0f;
+              },
+              [](MutexPublisher& p, float) { p.publish(); });
+    }
+  }
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_SnapshotPublisher [seconds] [maxReaders] [powerOfTwo]
+// One writer thread propagates and publishes while 1, 2, 4 ... maxReaders
+// reader threads grab and sample the newest snapshot, with the lock-free
+// snapshot publisher and with a mutex around a shared pointer. Defaults to
+// half a second per run, twice as many readers as cores, and N=128.
+int main(int argc, char* argv[]) {
+  double seconds = 0.5;
+  if (argc > 1) {
+    seconds = atof(argv[1]);
+  }
+  int maxReaders = 2 * std::thread::hardware_concurrency();
+  if (argc > 2) {
+    maxReaders = atoi(argv[2]);
+  }
+  int power = 7;
+  if (argc > 3) {
+    power = atoi(argv[3]);
+  }
+
+  bench(power, seconds, maxReaders);
+  return 0;
+}
@@ -0,0 +1,217 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+typedef float real_type;
+typedef std::complex<real_type> complex_type;
+
+//-*****************************************************************************
+// Runs the six separate spectral passes that propagate used to make, one per
+// output spectrum, each one re-streaming the propagated height spectrum.
+struct SeparatePasses {
+  ewav::CSpectralField2Df HSpec;
+  ewav::CSpectralField2Df DxSpec;
+  ewav::CSpectralField2Df DySpec;
+  ewav::CSpectralField2Df DxxSpec;
+  ewav::CSpectralField2Df DyySpec;
+  ewav::CSpectralField2Df DxySpec;
+
+  explicit SeparatePasses(int i_powerOfTwo)
+    : HSpec(i_powerOfTwo)
+    , DxSpec(i_powerOfTwo)
+    , DySpec(i_powerOfTwo)
+    , DxxSpec(i_powerOfTwo)
+    , DyySpec(i_powerOfTwo)
+    , DxySpec(i_powerOfTwo) {}
+
+  void run(const ewav::InitialStatef& i_istate, real_type i_domain,
+           real_type i_time) {
+    using namespace ewav;
+    const int N = HSpec.height();
+    {
+      HSPEC<real_type> F;
+      F.HSpecPos  = i_istate.HSpectralPos.cdata();
+      F.HSpecNeg  = i_istate.HSpectralNeg.cdata();
+      F.Omega     = i_istate.Omega.cdata();
+      F.HSpecProp = HSpec.data();
+      F.Time      = i_time;
+      SpectralIterationFunctor<real_type, HSPEC<real_type>, HSPEC<real_type>>
+        SIF(&F, i_domain, N);
+    }
+    {
+      DXXSPEC<real_type> F;
+      F.HSpecProp   = HSpec.cdata();
+      F.DxxSpecProp = DxxSpec.data();
+      SpectralIterationFunctor<real_type, DXXSPEC<real_type>,
+                               DXXSPEC<real_type>>
+        SIF(&F, i_domain, N);
+    }
+    {
+      DYYSPEC<real_type> F;
+      F.HSpecProp   = HSpec.cdata();
+      F.DyySpecProp = DyySpec.data();
+      SpectralIterationFunctor<real_type, DYYSPEC<real_type>,
+                               DYYSPEC<real_type>>
+        SIF(&F, i_domain, N);
+    }
+    {
+      DXYSPEC<real_type> F;
+      F.HSpecProp   = HSpec.cdata();
+      F.DxySpecProp = DxySpec.data();
+      SpectralIterationFunctor<real_type, DXYSPEC<real_type>,
+                               DXYSPEC<real_type>>
+        SIF(&F, i_domain, N);
+    }
+    {
+      DXSPEC<real_type> F;
+      F.HSpecProp  = HSpec.cdata();
+      F.DxSpecProp = DxSpec.data();
+      SpectralIterationFunctor<real_type, DXSPEC<real_type>,
+                               DXSPEC<real_type>>
+        SIF(&F, i_domain, N);
+    }
+    {
+      DYSPEC<real_type> F;
+      F.HSpecProp  = HSpec.cdata();
+      F.DySpecProp = DySpec.data();
+      SpectralIterationFunctor<real_type, DYSPEC<real_type>,
+                               DYSPEC<real_type>>
+        SIF(&F, i_domain, N);
+    }
+  }
+
+  void runFused(const ewav::InitialStatef& i_istate, real_type i_domain,
+                real_type i_time) {
+    using namespace ewav;
+    PROPSPECS<real_type> F{InitialSpectra<real_type>(i_istate)};
+    F.Phasor.Omega        = i_istate.Omega.cdata();
+    F.Phasor.Time         = i_time;
+    F.Phasor.TimeStep     = 0;
+    F.Phasor.PrevPhasor   = nullptr;
+    F.Phasor.NextPhasor   = nullptr;
+    F.Phasor.PhasorStep   = nullptr;
+    F.Filter              = nullptr;
+    F.HFiltSpecProp       = nullptr;
+    F.Specs.SpecProp[kHeightField] = HSpec.data();
+    F.Specs.SpecProp[kDxField]     = DxSpec.data();
+    F.Specs.SpecProp[kDyField]     = DySpec.data();
+    F.Specs.SpecProp[kDxxField]    = DxxSpec.data();
+    F.Specs.SpecProp[kDyyField]    = DyySpec.data();
+    F.Specs.SpecProp[kMinEField]   = DxySpec.data();
+    SpectralIterationFunctor<real_type, PROPSPECS<real_type>,
+                             PROPSPECS<real_type>>
+      SIF(&F, i_domain, HSpec.height());
+  }
+};
+
+//-*****************************************************************************
+void bench(int i_powerOfTwo, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+
+  ewav::InitialStatef istate(params);
+  SeparatePasses passes(i_powerOfTwo);
+  const int N = istate.resolution();
+
+  // Bytes moved per bin. Separate: HSPEC reads pos, neg & omega and writes
+  // h, then five passes each read h and write one spectrum. Fused: reads
+  // pos, neg & omega once and writes all six spectra.
+  const double bins = double(istate.HSpectralPos.size());
+  const double c    = sizeof(complex_type);
+  const double r    = sizeof(real_type);
+  const double separateBytes = bins * ((3.0 * c + r) + 5.0 * (2.0 * c));
+  const double fusedBytes    = bins * (2.0 * c + r + 6.0 * c);
+
+  double separateTime = 1.0e30;
+  double fusedTime    = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    const real_type time = real_type(iter + 1) / real_type(24);
+    {
+      ewav::Timer timer;
+      passes.run(istate, params.domain, time);
+      separateTime = std::min(separateTime, timer.elapsed());
+    }
+    {
+      ewav::Timer timer;
+      passes.runFused(istate, params.domain, time);
+      fusedTime = std::min(fusedTime, timer.elapsed());
+    }
+  }
+
+  std::cout << "N = " << N << std::endl
+            << (boost::format("  separate: %8.3f ms, %8.1f MB, %6.2f GB/s") %
+                (1000.0 * separateTime) % (separateBytes / 1.0e6) %
+                (separateBytes / (1.0e9 * separateTime)))
+            << std::endl
+            << (boost::format("  fused:    %8.3f ms, %8.1f MB, %6.2f GB/s") %
+                (1000.0 * fusedTime) % (fusedBytes / 1.0e6) %
+                (fusedBytes / (1.0e9 * fusedTime)))
+            << std::endl
+            << (boost::format("  traffic saved: %.1f%%, speedup: %.2fx") %
+                (100.0 * (1.0 - fusedBytes / separateBytes)) %
+                (separateTime / fusedTime))
+            << std::endl;
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_SpectralKernels [iterations] [powerOfTwo ...]
+// Defaults to N=2048 and N=4096.
+int main(int argc, char* argv[]) {
+  int iterations = 10;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(11);
+    powers.push_back(12);
+  }
+
+  for (int power : powers) {
+    bench(power, iterations);
+  }
+
+  return 0;
+}
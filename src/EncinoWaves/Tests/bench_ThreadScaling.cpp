@@ -0,0 +1,137 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+
+#include <EncinoWaves/All.h>
+
+#include <tbb/task_arena.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// Best-of-n times, in seconds, for the batched transform of all six
+// propagated fields and for a whole propagate, with both the TBB stages and
+// FFTW's loops confined to an arena of i_numThreads threads.
+void timeThreads(int i_numThreads, const ewav::Parametersf& i_params,
+                 const ewav::InitialStatef& i_istate, int i_iterations,
+                 double& o_fftTime, double& o_propagateTime) {
+  tbb::task_arena arena(i_numThreads);
+  arena.execute([&] {
+    ewav::Propagationf prop(i_params, i_numThreads);
+    ewav::PropagatedStatef pstate(i_params);
+
+    o_fftTime       = 1.0e30;
+    o_propagateTime = 1.0e30;
+    for (int iter = 0; iter < i_iterations; ++iter) {
+      const float time = float(iter + 1) / 24.0f;
+      {
+        ewav::Timer timer;
+        prop.propagate(i_params, i_istate, pstate, time);
+        o_propagateTime = std::min(o_propagateTime, timer.elapsed());
+      }
+      {
+        ewav::Propagationf::converter_type& conv =
+          prop.converter(ewav::kNumPropagatedFields);
+        ewav::Timer timer;
+        conv.execute(*prop.Spectra, pstate.Fields);
+        o_fftTime = std::min(o_fftTime, timer.elapsed());
+      }
+    }
+  });
+}
+
+//-*****************************************************************************
+void bench(int i_powerOfTwo, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+
+  ewav::InitialStatef istate(params);
+
+  const int maxThreads = std::thread::hardware_concurrency();
+  std::vector<int> threadCounts;
+  for (int n = 1; n < maxThreads; n *= 2) {
+    threadCounts.push_back(n);
+  }
+  threadCounts.push_back(maxThreads);
+
+  std::cout << "N = " << istate.resolution() << std::endl;
+  double fftBase       = 0.0;
+  double propagateBase = 0.0;
+  for (int n : threadCounts) {
+    double fftTime       = 0.0;
+    double propagateTime = 0.0;
+    timeThreads(n, params, istate, i_iterations, fftTime, propagateTime);
+    if (n == 1) {
+      fftBase       = fftTime;
+      propagateBase = propagateTime;
+    }
+    std::cout << (boost::format("  %3d threads: fft %8.3f ms (%5.2fx, %3.0f%%),"
+                                " propagate %8.3f ms (%5.2fx, %3.0f%%)") %
+                  n % (1000.0 * fftTime) % (fftBase / fftTime) %
+                  (100.0 * fftBase / (fftTime * n)) %
+                  (1000.0 * propagateTime) % (propagateBase / propagateTime) %
+                  (100.0 * propagateBase / (propagateTime * n)))
+              << std::endl;
+  }
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_ThreadScaling [iterations] [powerOfTwo ...]
+// Times the transforms and propagate at thread counts doubling from 1 to
+// all cores, reporting speedup and parallel efficiency against 1 thread.
+// Defaults to N=2048.
+int main(int argc, char* argv[]) {
+  int iterations = 10;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(11);
+  }
+
+  for (int power : powers) {
+    bench(power, iterations);
+  }
+
+  return 0;
+}
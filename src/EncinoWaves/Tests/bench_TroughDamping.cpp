@@ -0,0 +1,246 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+typedef float real_type;
+
+//-*****************************************************************************
+// The fields the tail of trough damping reads and writes: the filtered MinE,
+// and the filtered and output height, dx and dy.
+struct DampingFields {
+  std::vector<real_type> FiltMinE;
+  std::vector<real_type> Interpolant;
+  std::vector<real_type> Filt[3];
+  std::vector<real_type> Out[3];
+
+  explicit DampingFields(std::size_t i_size)
+    : FiltMinE(i_size)
+    , Interpolant(i_size) {
+    for (int f = 0; f < 3; ++f) {
+      Filt[f].resize(i_size);
+      Out[f].resize(i_size);
+    }
+    std::mt19937 gen(54321);
+    std::normal_distribution<real_type> normal;
+    for (std::size_t i = 0; i < i_size; ++i) {
+      FiltMinE[i] = normal(gen);
+      for (int f = 0; f < 3; ++f) {
+        Filt[f][i] = normal(gen);
+        Out[f][i] = normal(gen);
+      }
+    }
+  }
+};
+
+//-*****************************************************************************
+template <typename F>
+void setConversion(F& o_f) {
+  o_f.GainMinE = real_type(0.5);
+  o_f.BiasMinE = real_type(0.25);
+  o_f.MinClipE = real_type(0.0);
+  o_f.MaxClipE = real_type(1.1);
+  o_f.MinInterpolant = real_type(0.25);
+}
+
+//-*****************************************************************************
+// The tail as propagate used to run it: one sweep converting MinE to the
+// interpolant in place, then one blend sweep per field, with TBB's default
+// grain size.
+void runSeparate(DampingFields& io_fields) {
+  using namespace ewav;
+  const std::size_t size = io_fields.FiltMinE.size();
+  std::copy(io_fields.FiltMinE.begin(), io_fields.FiltMinE.end(),
+            io_fields.Interpolant.begin());
+  {
+    ConvertMinEToInterpolant<real_type> F;
+    setConversion(F);
+    F.MinE_And_Interpolant = io_fields.Interpolant.data();
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, size), F);
+  }
+  for (int f = 0; f < 3; ++f) {
+    InterpolateIntoB<real_type> F;
+    F.A = io_fields.Filt[f].data();
+    F.B = io_fields.Out[f].data();
+    F.Interpolant = io_fields.Interpolant.data();
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, size), F);
+  }
+}
+
+//-*****************************************************************************
+// The tail as propagate runs it now, in one sweep.
+void runFused(DampingFields& io_fields) {
+  using namespace ewav;
+  const std::size_t size = io_fields.FiltMinE.size();
+  DampTroughs<real_type> F;
+  setConversion(F);
+  F.FiltMinE = io_fields.FiltMinE.data();
+  for (int f = 0; f < 3; ++f) {
+    F.Filt[f] = io_fields.Filt[f].data();
+    F.Out[f] = io_fields.Out[f].data();
+  }
+  tbb::parallel_for(
+    tbb::blocked_range<std::size_t>(0, size, StreamingGrainSize(size)), F);
+}
+
+//-*****************************************************************************
+void bench(int i_powerOfTwo, int i_iterations) {
+  const std::size_t N = std::size_t(1) << i_powerOfTwo;
+  const std::size_t size = N * N;
+  DampingFields separateFields(size);
+  DampingFields fusedFields(size);
+
+  // Bytes moved per element. Separate: the conversion reads and writes the
+  // interpolant, then each blend reads it, reads a filtered field and reads
+  // and writes an output. Fused: reads MinE once, and reads a filtered field
+  // and reads and writes an output per field.
+  const double r = sizeof(real_type);
+  const double separateBytes = double(size) * (2.0 * r + 3.0 * (4.0 * r));
+  const double fusedBytes = double(size) * (r + 3.0 * (3.0 * r));
+
+  double separateTime = 1.0e30;
+  double fusedTime = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    {
+      ewav::Timer timer;
+      runSeparate(separateFields);
+      separateTime = std::min(separateTime, timer.elapsed());
+    }
+    {
+      ewav::Timer timer;
+      runFused(fusedFields);
+      fusedTime = std::min(fusedTime, timer.elapsed());
+    }
+  }
+
+  std::cout << "N = " << N << std::endl
+            << (boost::format("  separate: %8.3f ms, %8.1f MB, %6.2f GB/s") %
+                (1000.0 * separateTime) % (separateBytes / 1.0e6) %
+                (separateBytes / (1.0e9 * separateTime)))
+            << std::endl
+            << (boost::format("  fused:    %8.3f ms, %8.1f MB, %6.2f GB/s") %
+                (1000.0 * fusedTime) % (fusedBytes / 1.0e6) %
+                (fusedBytes / (1.0e9 * fusedTime)))
+            << std::endl
+            << (boost::format("  traffic saved: %.1f%%, speedup: %.2fx") %
+                (100.0 * (1.0 - fusedBytes / separateBytes)) %
+                (separateTime / fusedTime))
+            << std::endl;
+}
+
+//-*****************************************************************************
+// Whole frames of propagate: undamped, damped in full and damped at reduced
+// resolution, with the default damping band.
+void benchPropagate(int i_powerOfTwo, int i_iterations) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+  params.troughDamping = 0.5f;
+  ewav::Parametersf undampedParams = params;
+  undampedParams.troughDamping = 0.0f;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef pstate(params);
+  ewav::Propagationf fullProp(params);
+  ewav::Propagationf reducedProp(params);
+  reducedProp.setReducedTroughDamping(true);
+
+  double undampedTime = 1.0e30;
+  double fullTime = 1.0e30;
+  double reducedTime = 1.0e30;
+  for (int iter = 0; iter < i_iterations; ++iter) {
+    const float time = float(iter + 1) / 24.0f;
+    {
+      ewav::Timer timer;
+      fullProp.propagate(undampedParams, istate, pstate, time);
+      undampedTime = std::min(undampedTime, timer.elapsed());
+    }
+    {
+      ewav::Timer timer;
+      fullProp.propagate(params, istate, pstate, time);
+      fullTime = std::min(fullTime, timer.elapsed());
+    }
+    {
+      ewav::Timer timer;
+      reducedProp.propagate(params, istate, pstate, time);
+      reducedTime = std::min(reducedTime, timer.elapsed());
+    }
+  }
+
+  std::cout << "propagate, N = " << (1 << i_powerOfTwo) << ", damping at "
+            << reducedProp.reducedTroughDampingSize(params).Width << std::endl
+            << (boost::format("  undamped:        %8.3f ms") %
+                (1000.0 * undampedTime))
+            << std::endl
+            << (boost::format("  damped in full:  %8.3f ms") %
+                (1000.0 * fullTime))
+            << std::endl
+            << (boost::format("  damped, reduced: %8.3f ms") %
+                (1000.0 * reducedTime))
+            << std::endl;
+}
+
+//-*****************************************************************************
+// Usage: bench_ewav_TroughDamping [iterations] [powerOfTwo ...]
+// Defaults to N=1024, N=2048 and N=4096.
+int main(int argc, char* argv[]) {
+  int iterations = 10;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  std::vector<int> powers;
+  for (int i = 2; i < argc; ++i) {
+    powers.push_back(atoi(argv[i]));
+  }
+  if (powers.empty()) {
+    powers.push_back(10);
+    powers.push_back(11);
+    powers.push_back(12);
+  }
+
+  for (int power : powers) {
+    bench(power, iterations);
+  }
+  for (int power : powers) {
+    benchPropagate(power, iterations);
+  }
+
+  return 0;
+}
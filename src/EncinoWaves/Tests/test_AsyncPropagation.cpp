@@ -0,0 +1,144 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+int frameOf(const ewav::AsyncPropagatedFramef* i_frame) {
+  return i_frame ? int(std::round(i_frame->Time * 24.0f)) : -1;
+}
+
+//-*****************************************************************************
+float maxDifference(const ewav::PropagatedStatef& i_a,
+                    const ewav::PropagatedStatef& i_b) {
+  float maxDiff = 0.0f;
+  for (int f = 0; f < i_a.Fields.count(); ++f) {
+    const ewav::RSpatialField2Df& a = i_a.Fields[f];
+    const ewav::RSpatialField2Df& b = i_b.Fields[f];
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      maxDiff = std::max(maxDiff, std::abs(a.cdata()[i] - b.cdata()[i]));
+    }
+  }
+  return maxDiff;
+}
+
+//-*****************************************************************************
+// Propagates a handful of times synchronously, then drives the asynchronous
+// propagation with a ring of i_numFrames frames, both one frame at a time
+// and by requesting faster than frames are consumed, and checks that every
+// acquired frame matches the synchronous state of its time and stays intact
+// while the next one is computed.
+void testAsync(int i_numFrames, float i_troughDamping) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 6;
+  params.troughDamping = i_troughDamping;
+
+  ewav::InitialStatef istate(params);
+  ewav::Propagationf prop(params);
+  const int numTimes = 8;
+  std::vector<std::unique_ptr<ewav::PropagatedStatef>> expected;
+  std::vector<std::vector<Imath::V3f>> expectedNormals(numTimes);
+  for (int t = 0; t < numTimes; ++t) {
+    expected.emplace_back(new ewav::PropagatedStatef(params));
+    prop.propagate(params, istate, *expected[t], float(t) / 24.0f);
+    expectedNormals[t].resize(expected[t]->Height.size());
+    ewav::ComputeNormals(params, *expected[t], expectedNormals[t].data());
+  }
+
+  ewav::AsyncPropagationf async(params, i_numFrames, ewav::kAllChannels,
+                                true);
+  EWAV_ASSERT(!async.acquire(), "Expected no frame before any request");
+  async.setInitialState(&istate);
+
+  float maxDiff = 0.0f;
+  auto check = [&](const ewav::AsyncPropagatedFramef* i_frame) {
+    const int t = frameOf(i_frame);
+    EWAV_ASSERT(t >= 0 && t < numTimes, "Bad frame time: " << i_frame->Time);
+    maxDiff = std::max(maxDiff, maxDifference(*expected[t], i_frame->State));
+    for (std::size_t i = 0; i < i_frame->Normals.size(); ++i) {
+      const Imath::V3f d = i_frame->Normals[i] - expectedNormals[t][i];
+      maxDiff = std::max(maxDiff, d.length());
+    }
+  };
+
+  // Consume frame t while frame t + 1 is computed.
+  async.request(params, 0.0f);
+  async.wait();
+  for (int t = 0; t < numTimes; ++t) {
+    const ewav::AsyncPropagatedFramef* frame = async.acquire();
+    EWAV_ASSERT(frameOf(frame) == t, "Expected frame " << t);
+    if (t + 1 < numTimes) {
+      async.request(params, float(t + 1) / 24.0f);
+    }
+    check(frame);
+    async.wait();
+    if (i_numFrames > 2) {
+      // The acquired frame survives the next one being published.
+      check(frame);
+    }
+  }
+
+  // Request faster than frames are consumed, which drops some of them.
+  for (int iter = 0; iter < 64; ++iter) {
+    async.request(params, float(iter % numTimes) / 24.0f);
+    if (const ewav::AsyncPropagatedFramef* frame = async.acquire()) {
+      check(frame);
+    }
+  }
+  async.wait();
+  const ewav::AsyncPropagatedFramef* last = async.acquire();
+  EWAV_ASSERT(frameOf(last) == 63 % numTimes,
+              "Expected the frame of the last request");
+  check(last);
+  async.release();
+
+  std::cout << "Async propagation, " << i_numFrames
+            << " frames, trough damping " << i_troughDamping
+            << ", max difference from synchronous: " << maxDiff << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-5f, "Async propagation doesn't match.");
+}
+
+//-*****************************************************************************
+int main(int argc, char* argv[]) {
+  testAsync(3, 0.0f);
+  testAsync(2, 0.0f);
+  testAsync(3, 0.5f);
+  return 0;
+}
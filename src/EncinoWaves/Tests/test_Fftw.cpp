@@ -38,7 +38,11 @@
 #include <tbb/blocked_range.h>
 #include <tbb/blocked_range2d.h>
 
+#include <atomic>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <thread>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -90,6 +94,267 @@ struct RandFillFunctor {
   }
 };
 
+//-*****************************************************************************
+// Check that a batched transform of a slab of spectra matches transforming
+// each spectrum on its own.
+void testBatch(int i_powerOfTwo, int i_count) {
+  ewav::FieldSlab2D<ewav::CSpectralField2Df> spectra(i_count, i_powerOfTwo);
+  ewav::FieldSlab2D<ewav::RSpatialField2Df> batched(i_count, i_powerOfTwo, 1);
+  ewav::CSpectralField2Df single(i_powerOfTwo);
+  ewav::RSpatialField2Df singleSpatial(i_powerOfTwo, 1);
+  int N = single.height();
+
+  ewav::SpectralToPaddedSpatial2D<float> convert(single, singleSpatial);
+  ewav::BatchSpectralToPaddedSpatial2D<float> batchConvert(spectra, batched);
+
+  for (int f = 0; f < i_count; ++f) {
+    RandFillFunctor F;
+    F.Spectral = spectra[f].data();
+    F.StrideJ  = spectra[f].stride();
+    F.N        = N;
+    F.Domain   = 1000.0f;
+    F.Seed     = 54321 + f;
+    tbb::blocked_range2d<int> range{0, spectra[f].height(), 1,
+                                    0, spectra[f].width(),  512};
+    tbb::parallel_for(range, F);
+  }
+
+  // The transforms destroy their input, so convert the singles first from
+  // copies.
+  std::vector<std::vector<float>> expected(i_count);
+  for (int f = 0; f < i_count; ++f) {
+    std::copy(spectra[f].cbegin(), spectra[f].cend(), single.begin());
+    convert.execute(single, singleSpatial);
+    expected[f].assign(singleSpatial.cbegin(), singleSpatial.cend());
+  }
+
+  batchConvert.execute(spectra, batched);
+
+  float maxErr = 0.0f;
+  for (int f = 0; f < i_count; ++f) {
+    for (std::size_t i = 0; i < expected[f].size(); ++i) {
+      maxErr =
+        std::max(maxErr, std::abs(expected[f][i] - batched[f].cdata()[i]));
+    }
+  }
+  std::cout << "Batched " << i_count << " transforms of " << N << " x " << N
+            << ", max difference from single: " << maxErr << std::endl;
+  EWAV_ASSERT(maxErr < 1.0e-6f, "Batched transform doesn't match single.");
+}
+
+//-*****************************************************************************
+// Check that measured plans fall back to estimate when there's no wisdom,
+// that wisdom is written when allowed, and that it's used once it exists.
+void testWisdom(int i_powerOfTwo) {
+  typedef ewav::FftwWrapperT<float> FFT;
+
+  ewav::CSpectralField2Df spectral(i_powerOfTwo);
+  ewav::RSpatialField2Df spatial(i_powerOfTwo, 1);
+  const int N        = spectral.height();
+  const int nthreads = 2;
+
+  ewav::FftPlanOptions options;
+  options.rigor           = ewav::kMeasurePlannerRigor;
+  options.wisdomDirectory = ".";
+  const std::string filename =
+    ewav::FftwWisdomT<float>::Filename(options.wisdomDirectory, N, N,
+                                       nthreads);
+  EWAV_ASSERT(filename != ewav::FftwWisdomT<float>::Filename(
+                              options.wisdomDirectory, N + N / 2, N, nthreads),
+              "Grids of different widths share a wisdom file.");
+  std::remove(filename.c_str());
+  ewav::FftwWisdomT<float>::Forget();
+
+  // Makes a plan and reports whether it had to fall back to estimate.
+  auto plan = [&](bool& o_estimated) {
+    o_estimated = false;
+    FFT::plan_type p = ewav::FftwPlanT<float>(
+      N, N, nthreads, options, FFTW_DESTROY_INPUT, [&](unsigned int i_flags) {
+        o_estimated = (i_flags & FFTW_WISDOM_ONLY) == 0 &&
+                      (i_flags & FFTW_ESTIMATE) != 0;
+        return FFT::plan_guru_dft_c2r_output_padded(
+          N, N, 1, 1, spectral.data(), spatial.data(), i_flags);
+      });
+    FFT::destroy_plan(p);
+  };
+
+  bool estimated = false;
+  plan(estimated);
+  EWAV_ASSERT(estimated, "Expected an estimated plan without wisdom.");
+  EWAV_ASSERT(!std::ifstream(filename.c_str()).good(),
+              "Wisdom shouldn't be written unless allowed.");
+
+  options.planWithoutWisdom = true;
+  plan(estimated);
+  EWAV_ASSERT(!estimated, "Expected a measured plan.");
+  EWAV_ASSERT(std::ifstream(filename.c_str()).good(),
+              "Expected wisdom to be written to: " << filename);
+
+  // Start over, as a new process would, and load the wisdom from the file.
+  ewav::FftwWisdomT<float>::Forget();
+  options.planWithoutWisdom = false;
+  plan(estimated);
+  EWAV_ASSERT(!estimated, "Expected a plan from wisdom.");
+
+  // Plans from wisdom transform the same as estimated ones.
+  RandFillFunctor F;
+  F.Spectral = spectral.data();
+  F.StrideJ  = spectral.stride();
+  F.N        = N;
+  F.Domain   = 1000.0f;
+  F.Seed     = 12345;
+  tbb::blocked_range2d<int> range{0, spectral.height(), 1,
+                                  0, spectral.width(),  512};
+  std::vector<Cf> input;
+
+  tbb::parallel_for(range, F);
+  input.assign(spectral.cbegin(), spectral.cend());
+  ewav::SpectralToPaddedSpatial2D<float> estimateConvert(spectral, spatial,
+                                                         nthreads);
+  estimateConvert.execute(spectral, spatial);
+  std::vector<float> expected(spatial.cbegin(), spatial.cend());
+
+  ewav::SpectralToPaddedSpatial2D<float> wisdomConvert(spectral, spatial,
+                                                       nthreads, options);
+  std::copy(input.begin(), input.end(), spectral.begin());
+  wisdomConvert.execute(spectral, spatial);
+
+  float maxErr = 0.0f;
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    maxErr = std::max(maxErr, std::abs(expected[i] - spatial.cdata()[i]));
+  }
+  std::cout << "Wisdom plan of " << N << " x " << N
+            << ", max difference from estimate: " << maxErr << std::endl;
+  EWAV_ASSERT(maxErr < 1.0e-5f, "Wisdom plan doesn't match estimate.");
+
+  // A wisdom directory that can't be written to still gives a measured
+  // plan, and only warns.
+  ewav::FftwWisdomT<float>::Forget();
+  options.wisdomDirectory   = "./ewav_no_such_directory";
+  options.planWithoutWisdom = true;
+  plan(estimated);
+  EWAV_ASSERT(!estimated, "Expected a measured plan without saved wisdom.");
+
+  std::remove(filename.c_str());
+  ewav::FftwWisdomT<float>::Forget();
+}
+
+//-*****************************************************************************
+// Check that converters of the same geometry share one cached plan, across
+// converters alive at once and ones made after others are gone.
+void testPlanCache(int i_powerOfTwo) {
+  typedef ewav::FftwPlanCacheT<float> Cache;
+  Cache::Clear();
+  const std::size_t before = Cache::Size();
+
+  ewav::FieldSlab2D<ewav::CSpectralField2Df> spectraA(3, i_powerOfTwo);
+  ewav::FieldSlab2D<ewav::RSpatialField2Df> spatialA(3, i_powerOfTwo, 1);
+  ewav::FieldSlab2D<ewav::CSpectralField2Df> spectraB(3, i_powerOfTwo);
+  ewav::FieldSlab2D<ewav::RSpatialField2Df> spatialB(3, i_powerOfTwo, 1);
+  {
+    ewav::BatchSpectralToPaddedSpatial2D<float> a(spectraA, spatialA, 1);
+    ewav::BatchSpectralToPaddedSpatial2D<float> b(spectraB, spatialB, 1);
+    EWAV_ASSERT(Cache::Size() == before + 1,
+                "Converters of the same geometry should share a plan.");
+
+    ewav::BatchSpectralToPaddedSpatial2D<float> c(spectraB, spatialB, 1, 2);
+    EWAV_ASSERT(Cache::Size() == before + 2,
+                "Converters of different geometry shouldn't share a plan.");
+  }
+  EWAV_ASSERT(Cache::Size() == before + 2, "Unused plans should be kept.");
+
+  {
+    ewav::BatchSpectralToPaddedSpatial2D<float> a(spectraA, spatialA, 1);
+    EWAV_ASSERT(Cache::Size() == before + 2,
+                "Rebuilt converters should reuse cached plans.");
+    Cache::Clear();
+    EWAV_ASSERT(Cache::Size() == before + 1,
+                "Clear should keep plans in use.");
+  }
+  Cache::Clear();
+  EWAV_ASSERT(Cache::Size() == before, "Clear should destroy unused plans.");
+  std::cout << "Plan cache shared plans of " << spectraA[0].height() << " x "
+            << spectraA[0].height() << std::endl;
+}
+
+//-*****************************************************************************
+// Check that a plan being made doesn't block acquiring a cached plan of
+// another key, and that acquiring the same key waits for it and shares it.
+void testPlanCacheConcurrency(int i_powerOfTwo) {
+  typedef ewav::FftwWrapperT<float> FFT;
+  typedef ewav::FftwPlanCacheT<float> Cache;
+  Cache::Clear();
+  const std::size_t before = Cache::Size();
+
+  ewav::CSpectralField2Df spectral(i_powerOfTwo);
+  ewav::RSpatialField2Df spatial(i_powerOfTwo, 1);
+  const int N = spectral.height();
+  auto makePlan = [&](unsigned int i_flags) {
+    return FFT::plan_guru_dft_c2r_output_padded(
+      N, N, 1, 1, spectral.data(), spatial.data(), i_flags);
+  };
+
+  ewav::FftPlanOptions options;
+  ewav::FftwPlanKey keyA;
+  keyA.kind       = ewav::kPaddedC2RPlanKind;
+  keyA.width      = N;
+  keyA.height     = N;
+  keyA.numThreads = 1;
+  ewav::FftwPlanKey keyB = keyA;
+  keyB.numThreads        = 2;
+
+  const FFT::plan_type planB = Cache::Acquire(keyB, options, makePlan);
+
+  // Plan A slowly: hold its planning until the cached plan B has been
+  // acquired again, giving up after a few seconds.
+  std::atomic<bool> acquiredB{false};
+  bool sawB               = false;
+  FFT::plan_type planA    = nullptr;
+  std::thread plannerA([&]() {
+    planA = Cache::Acquire(keyA, options, [&](unsigned int i_flags) {
+      for (int i = 0; i < 500 && !acquiredB; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      sawB = acquiredB;
+      return makePlan(i_flags);
+    });
+  });
+  while (Cache::Size() < before + 2) {
+    std::this_thread::yield();
+  }
+
+  FFT::plan_type sharedA = nullptr;
+  std::thread waiterA([&]() {
+    sharedA = Cache::Acquire(keyA, options, [](unsigned int) {
+      EWAV_FAIL("Plan A was planned twice.");
+      return FFT::plan_type(nullptr);
+    });
+  });
+
+  const FFT::plan_type hitB =
+    Cache::Acquire(keyB, options, [](unsigned int) {
+      EWAV_FAIL("Cached plan B was planned again.");
+      return FFT::plan_type(nullptr);
+    });
+  acquiredB = true;
+  plannerA.join();
+  waiterA.join();
+
+  EWAV_ASSERT(sawB, "Acquiring a cached plan waited for another's planning.");
+  EWAV_ASSERT(hitB == planB, "Expected the cached plan B.");
+  EWAV_ASSERT(planA && sharedA == planA,
+              "Acquirers of the same key should share its plan.");
+
+  Cache::Release(keyA);
+  Cache::Release(keyA);
+  Cache::Release(keyB);
+  Cache::Release(keyB);
+  Cache::Clear();
+  EWAV_ASSERT(Cache::Size() == before, "Clear should destroy unused plans.");
+  std::cout << "Plan cache acquired a cached plan while planning another"
+            << std::endl;
+}
+
 //-*****************************************************************************
 int main(int argc, char* argv[]) {
   int powerOfTwo = 12;
@@ -125,5 +390,10 @@ int main(int argc, char* argv[]) {
   std::cout << "Converted to spatial." << std::endl
             << "Spatial midpoint: " << spatial[N / 2][N / 2] << std::endl;
 
+  testBatch(8, ewav::kNumPropagatedFields);
+  testWisdom(8);
+  testPlanCache(8);
+  testPlanCacheConcurrency(8);
+
   return 0;
 }
\ No newline at end of file
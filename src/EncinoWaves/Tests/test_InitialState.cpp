@@ -36,7 +36,11 @@
 
 #include <boost/program_options.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -56,6 +60,256 @@ void doTest(const ewav::Parametersf& i_params) {
             << "Omega: " << istate.Omega[N / 4][N / 4] << std::endl;
 }
 
+//-*****************************************************************************
+// Philox4x32-10 must reproduce the known answers of its authors' Random123.
+void testPhilox() {
+  typedef ewav::Philox4x32 P;
+  struct Case {
+    P::counter_type counter;
+    P::key_type key;
+    P::counter_type expected;
+  };
+  const Case cases[] = {
+    {{{0, 0, 0, 0}},
+     {{0, 0}},
+     {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}},
+    {{{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+     {{0xffffffff, 0xffffffff}},
+     {{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}},
+    {{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+     {{0xa4093822, 0x299f31d0}},
+     {{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}}};
+
+  for (const Case& c : cases) {
+    EWAV_ASSERT(P::generate(c.counter, c.key) == c.expected,
+                "Philox4x32-10 doesn't match its known answers.");
+  }
+  std::cout << "Philox4x32-10 matches its known answers." << std::endl;
+}
+
+//-*****************************************************************************
+// The amplitudes of NormalRandom must be standard normal, and its phases
+// uniform over a full turn.
+void testNormalRandom() {
+  ewav::NormalRandom<double> random;
+  double sum        = 0.0;
+  double sumSqr     = 0.0;
+  double phaseSum   = 0.0;
+  double minPhase   = 1.0e10;
+  double maxPhase   = -1.0e10;
+  const int N       = 256;
+  std::size_t count = 0;
+  for (int j = -N; j < N; ++j) {
+    for (int i = 0; i < N; ++i) {
+      random.seed(i, j);
+      for (int d = 0; d < 2; ++d) {
+        const double amp   = random.nextAmp();
+        const double phase = random.nextPhase();
+        sum += amp;
+        sumSqr += amp * amp;
+        phaseSum += phase;
+        minPhase = std::min(minPhase, phase);
+        maxPhase = std::max(maxPhase, phase);
+        ++count;
+      }
+    }
+  }
+  const double mean      = sum / double(count);
+  const double variance  = sumSqr / double(count) - mean * mean;
+  const double phaseMean = phaseSum / double(count);
+  std::cout << "Normal random mean: " << mean << ", variance: " << variance
+            << ", phase mean: " << phaseMean << std::endl;
+  EWAV_ASSERT(std::abs(mean) < 0.01 && std::abs(variance - 1.0) < 0.01,
+              "Normal random draws aren't standard normal.");
+  EWAV_ASSERT(minPhase > 0.0 && maxPhase < ewav::TAU<double> &&
+                std::abs(phaseMean - ewav::PI<double>) < 0.01,
+              "Random phases aren't uniform over a full turn.");
+}
+
+//-*****************************************************************************
+// Whether two initial states are the same, bit for bit.
+bool sameInitialState(const ewav::InitialStatef& i_a,
+                      const ewav::InitialStatef& i_b) {
+  const std::size_t size = i_a.HSpectralPos.size();
+  return i_b.HSpectralPos.size() == size &&
+         std::equal(i_a.HSpectralPos.cdata(), i_a.HSpectralPos.cdata() + size,
+                    i_b.HSpectralPos.cdata()) &&
+         std::equal(i_a.HSpectralNeg.cdata(), i_a.HSpectralNeg.cdata() + size,
+                    i_b.HSpectralNeg.cdata()) &&
+         std::equal(i_a.Omega.cdata(), i_a.Omega.cdata() + size,
+                    i_b.Omega.cdata());
+}
+
+//-*****************************************************************************
+// How many floats apart i_a and i_b are. Zeros of either sign are the same,
+// and a NaN is far from everything.
+std::int64_t ulpDistance(float i_a, float i_b) {
+  std::int32_t a, b;
+  std::memcpy(&a, &i_a, sizeof(a));
+  std::memcpy(&b, &i_b, sizeof(b));
+  const std::int64_t orderedA = a < 0 ? -std::int64_t(a & 0x7fffffff) : a;
+  const std::int64_t orderedB = b < 0 ? -std::int64_t(b & 0x7fffffff) : b;
+  return std::abs(orderedA - orderedB);
+}
+
+//-*****************************************************************************
+// The largest distance in ulps between any component of two initial states.
+std::int64_t initialStateUlps(const ewav::InitialStatef& i_a,
+                              const ewav::InitialStatef& i_b) {
+  const std::size_t size = i_a.HSpectralPos.size();
+  EWAV_ASSERT(i_b.HSpectralPos.size() == size,
+              "Initial states differ in size.");
+  const std::complex<float>* specs[][2] = {
+    {i_a.HSpectralPos.cdata(), i_b.HSpectralPos.cdata()},
+    {i_a.HSpectralNeg.cdata(), i_b.HSpectralNeg.cdata()}};
+  std::int64_t ulps = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    for (const auto& spec : specs) {
+      ulps = std::max({ulps, ulpDistance(spec[0][i].real(), spec[1][i].real()),
+                       ulpDistance(spec[0][i].imag(), spec[1][i].imag())});
+    }
+    ulps = std::max(ulps,
+                    ulpDistance(i_a.Omega.cdata()[i], i_b.Omega.cdata()[i]));
+  }
+  return ulps;
+}
+
+//-*****************************************************************************
+// The initial state must be the same, bit for bit, however many threads
+// make it.
+void testThreadIndependence(const ewav::Parametersf& i_params) {
+  tbb::task_arena oneThread(1);
+  tbb::task_arena allThreads;
+  ewav::InitialStatef serial(i_params, &oneThread);
+  ewav::InitialStatef parallel(i_params, &allThreads);
+  EWAV_ASSERT(sameInitialState(serial, parallel),
+              "Initial state depends on the number of threads.");
+  std::cout << "Initial state is the same on 1 and "
+            << allThreads.max_concurrency() << " threads." << std::endl;
+}
+
+//-*****************************************************************************
+// An initial state made from cached random draws must be the same, bit for
+// bit, as one which draws them, after any change to the parameters that
+// leaves the draws alone.
+void testCachedNoise(ewav::Parametersf i_params) {
+  for (ewav::RandomType type : {ewav::kNormalRandom, ewav::kLogNormalRandom}) {
+    i_params.random.type = type;
+    ewav::InitialStateNoisef noise(i_params);
+
+    ewav::Parametersf params = i_params;
+    for (int change = 0; change < 3; ++change) {
+      if (change == 1) {
+        params.windSpeed *= 1.5f;
+        params.directionalSpreading.type =
+          ewav::kDonelanBannerDirectionalSpreading;
+      } else if (change == 2) {
+        params.depth           = 20.0f;
+        params.dispersion.type = ewav::kFiniteDepthDispersion;
+      }
+      EWAV_ASSERT(noise.matches(params), "Cached draws should still match.");
+      ewav::InitialStatef drawn(params);
+      ewav::InitialStatef cached(params, noise);
+      EWAV_ASSERT(sameInitialState(drawn, cached),
+                  "Initial state from cached draws differs.");
+    }
+
+    params.random.seed += 1;
+    EWAV_ASSERT(!noise.matches(params), "Cached draws shouldn't match.");
+  }
+  std::cout << "Initial states from cached draws match." << std::endl;
+}
+
+//-*****************************************************************************
+// Makes the initial state of i_params bin by bin, through the processor's
+// four argument operator() and SpectralIterationFunctor, as it was made
+// before the radial terms were shared. The parameters must select a
+// capillary dispersion, a TMA spectrum, a smooth invertible band-pass filter
+// and normal random draws, along with SPREADING.
+template <typename SPREADING>
+void makePerBinInitialState(const ewav::Parametersf& i_params,
+                            ewav::InitialStatef& o_state) {
+  typedef ewav::InitialStateHelper<
+    ewav::CapillaryDispersion<float>, ewav::TMASpectrum<float>, SPREADING,
+    ewav::SmoothInvertibleBandPassFilter<float>, ewav::NormalRandom<float>,
+    float>
+    F_type;
+  typedef typename F_type::Processor P_type;
+
+  const ewav::CapillaryDispersion<float> dispersion(i_params);
+  const ewav::TMASpectrum<float> spectrum(i_params);
+  const SPREADING spreading(i_params);
+  const ewav::SmoothInvertibleBandPassFilter<float> filter(i_params);
+  const ewav::NormalRandom<float> random(i_params);
+
+  // Anything left unwritten won't match.
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::fill(o_state.HSpectralPos.data(),
+            o_state.HSpectralPos.data() + o_state.HSpectralPos.size(),
+            std::complex<float>(nan, nan));
+  std::fill(o_state.HSpectralNeg.data(),
+            o_state.HSpectralNeg.data() + o_state.HSpectralNeg.size(),
+            std::complex<float>(nan, nan));
+  std::fill(o_state.Omega.data(), o_state.Omega.data() + o_state.Omega.size(),
+            nan);
+
+  F_type F;
+  F.Dispersion           = &dispersion;
+  F.Spectrum             = &spectrum;
+  F.DirectionalSpreading = &spreading;
+  F.Filter               = &filter;
+  F.Random               = &random;
+  F.HSpectralPos         = o_state.HSpectralPos.data();
+  F.HSpectralNeg         = o_state.HSpectralNeg.data();
+  F.Omega                = o_state.Omega.data();
+  F.RhoG                 = i_params.gravity;
+  F.Domain               = i_params.domainSize()[0];
+  F.Size                 = o_state.Size;
+  ewav::SpectralIterationFunctor<float, F_type, P_type> SIF(
+    &F, i_params.domainSize()[0], i_params.domainSize()[1], o_state.Size);
+}
+
+//-*****************************************************************************
+// Sharing the radial terms of rows j and -j must give the same initial
+// state as evaluating every bin on its own, for every spreading model, with
+// and without swell, on square and odd rectangular grids. The arithmetic is
+// the same, but -ffast-math lets the compiler arrange it differently where
+// it is inlined. A term an ulp off carries through the products of a bin
+// to about two ulps, so allow a little more than that.
+template <typename SPREADING>
+void testRadialTerms(ewav::DirectionalSpreadingType i_type,
+                     const char* i_name) {
+  ewav::Parametersf params;
+  params.dispersion.type           = ewav::kCapillaryDispersion;
+  params.spectrum.type             = ewav::kTMASpectrum;
+  params.directionalSpreading.type = i_type;
+  params.filter.type               = ewav::kSmoothInvertibleBandPassFilter;
+  params.random.type               = ewav::kNormalRandom;
+
+  const int grids[][2] = {{64, 64}, {45, 27}};
+  std::int64_t maxUlps = 0;
+  for (const auto& grid : grids) {
+    params.resolutionX = grid[0];
+    params.resolutionY = grid[1];
+    params.domainY     = params.domain * float(grid[1]) / float(grid[0]);
+    for (float swell : {-0.5f, 0.0f, 0.5f}) {
+      params.directionalSpreading.swell = swell;
+      ewav::InitialStatef radial(params);
+      ewav::InitialStatef perBin(params);
+      makePerBinInitialState<SPREADING>(params, perBin);
+      const std::int64_t ulps = initialStateUlps(radial, perBin);
+      maxUlps                 = std::max(maxUlps, ulps);
+      EWAV_ASSERT(ulps <= 4,
+                  i_name << " initial state on a " << grid[0] << "x"
+                         << grid[1] << " grid with swell " << swell
+                         << " is " << ulps
+                         << " ulps from per-bin evaluation.");
+    }
+  }
+  std::cout << i_name << " radial terms match per-bin evaluation to "
+            << maxUlps << " ulps." << std::endl;
+}
+
 //-*****************************************************************************
 int main(int argc, char* argv[]) {
   ewav::Parametersf params;
@@ -216,6 +470,18 @@ int main(int argc, char* argv[]) {
   params.random.type = (ewav::RandomType)random;
   params.random.seed = seed;
 
+  testPhilox();
+  testNormalRandom();
+  testThreadIndependence(params);
+  testCachedNoise(params);
+  testRadialTerms<ewav::PosCosSquaredDirectionalSpreading<float>>(
+    ewav::kPosCosThetaSqrDirectionalSpreading, "Pos cos theta squared");
+  testRadialTerms<ewav::MitsuyasuDirectionalSpreading<float>>(
+    ewav::kMitsuyasuDirectionalSpreading, "Mitsuyasu");
+  testRadialTerms<ewav::HasselmannDirectionalSpreading<float>>(
+    ewav::kHasselmannDirectionalSpreading, "Hasselmann");
+  testRadialTerms<ewav::DonelanBannerDirectionalSpreading<float>>(
+    ewav::kDonelanBannerDirectionalSpreading, "Donelan Banner");
   doTest(params);
 
   return 0;
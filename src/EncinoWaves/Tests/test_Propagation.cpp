@@ -35,11 +35,967 @@
 #include <EncinoWaves/All.h>
 
 #include <iostream>
+#include <random>
 #include <stdio.h>
 #include <stdlib.h>
 
 namespace ewav = EncinoWaves;
 
+//-*****************************************************************************
+// The largest difference between the fields of i_channels that both states
+// have. If io_maxValue is given, it is raised to the largest magnitude of
+// those fields of i_a.
+float MaxFieldDifference(const ewav::PropagatedStatef& i_a,
+                         const ewav::PropagatedStatef& i_b,
+                         unsigned int i_channels = ewav::kAllChannels,
+                         float* io_maxValue = nullptr) {
+  float maxDiff = 0.0f;
+  for (int f = 0; f < ewav::kNumPropagatedFields; ++f) {
+    const ewav::PropagatedField field = ewav::PropagatedField(f);
+    if (!(i_channels & (1u << f)) || !i_a.has(field) || !i_b.has(field)) {
+      continue;
+    }
+    const ewav::RSpatialField2Df& a = i_a.field(field);
+    const ewav::RSpatialField2Df& b = i_b.field(field);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      maxDiff = std::max(maxDiff, std::abs(a.cdata()[i] - b.cdata()[i]));
+      if (io_maxValue) {
+        *io_maxValue = std::max(*io_maxValue, std::abs(a.cdata()[i]));
+      }
+    }
+  }
+  return maxDiff;
+}
+
+//-*****************************************************************************
+// The height spectrum of i_istate propagated to i_time, which is zero at DC.
+ewav::CSpectralField2Df PropagatedHeightSpectrum(
+    const ewav::InitialStatef& i_istate, float i_time) {
+  const ewav::GridSize size = i_istate.Size;
+  ewav::CSpectralField2Df hspec(size);
+  const int width = hspec.width();
+  for (int j = 0; j < size.Height; ++j) {
+    for (int i = 0; i < width; ++i) {
+      const std::size_t index = (std::size_t(j) * width) + i;
+      const float omegaT = i_istate.Omega.cdata()[index] * i_time;
+      const std::complex<float> fwd(std::cos(omegaT), -std::sin(omegaT));
+      hspec.data()[index] =
+          (i == 0 && j == 0)
+              ? std::complex<float>(0.0f)
+              : (i_istate.HSpectralPos.cdata()[index] * fwd) +
+                    (i_istate.HSpectralNeg.cdata()[index] * std::conj(fwd));
+    }
+  }
+  return hspec;
+}
+
+//-*****************************************************************************
+// The real fields of i_numSpecs half spectra of i_size at (i_x, i_y), summed
+// directly. Self conjugate columns stand for themselves, the rest for their
+// conjugates as well.
+void DirectSum(const std::vector<std::complex<double>>* i_specs,
+               int i_numSpecs, const ewav::GridSize& i_size, int i_x, int i_y,
+               double* o_sums) {
+  const int width = (i_size.Width / 2) + 1;
+  std::fill(o_sums, o_sums + i_numSpecs, 0.0);
+  for (int j = 0; j < i_size.Height; ++j) {
+    const int realJ = j <= i_size.Height / 2 ? j : j - i_size.Height;
+    for (int i = 0; i < width; ++i) {
+      const bool selfConj = (i == 0) || (i * 2 == i_size.Width);
+      const double phase =
+          ewav::TAU<double> * ((double(i) * i_x / i_size.Width) +
+                               (double(realJ) * i_y / i_size.Height));
+      const std::complex<double> rot((selfConj ? 1.0 : 2.0) * std::cos(phase),
+                                     (selfConj ? 1.0 : 2.0) * std::sin(phase));
+      const std::size_t index = (std::size_t(j) * width) + i;
+      for (int s = 0; s < i_numSpecs; ++s) {
+        o_sums[s] += (i_specs[s][index] * rot).real();
+      }
+    }
+  }
+}
+
+//-*****************************************************************************
+// The fused pass must make the same derivative fields as the separate
+// per-derivative passes it replaced. Their spectra are made here as those
+// passes made them, and summed directly.
+void testDerivatives(ewav::PropagationTransform i_transform) {
+  ewav::Parametersf params;
+  params.resolutionX = 48;
+  params.resolutionY = 32;
+  params.domain = 100.0f;
+  params.domainY = 60.0f;
+  const ewav::GridSize size = params.gridSize();
+  const float time = 0.75f;
+  const float pinch = 1.25f;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef pstate(params);
+  ewav::Propagationf prop(params, -1, i_transform);
+  prop.propagate(params, istate, pstate, time);
+
+  // Dx, Dy, Dxx, Dyy and Dxy, as DXSPEC, DYSPEC, DXXSPEC, DYYSPEC and
+  // DXYSPEC made them.
+  enum { kDx, kDy, kDxx, kDyy, kDxy, kNumSpecs };
+  const ewav::CSpectralField2Df hspec = PropagatedHeightSpectrum(istate, time);
+  const int width = hspec.width();
+  std::vector<std::complex<double>> specs[kNumSpecs];
+  for (int s = 0; s < kNumSpecs; ++s) {
+    specs[s].assign(hspec.size(), std::complex<double>(0.0));
+  }
+  for (int j = 0; j < size.Height; ++j) {
+    const int realJ = j <= size.Height / 2 ? j : j - size.Height;
+    const double ky = double(realJ) * ewav::TAU<double> / params.domainY;
+    for (int i = 0; i < width; ++i) {
+      if (i == 0 && j == 0) {
+        continue;
+      }
+      const double kx = double(i) * ewav::TAU<double> / params.domain;
+      const double kMag = std::hypot(kx, ky);
+      const std::size_t index = (std::size_t(j) * width) + i;
+      const std::complex<double> h(hspec.cdata()[index]);
+      specs[kDx][index] = std::complex<double>(0.0, -kx / kMag) * h;
+      specs[kDy][index] = std::complex<double>(0.0, -ky / kMag) * h;
+      specs[kDxx][index] = ((kx * kx) / kMag) * h;
+      specs[kDyy][index] = ((ky * ky) / kMag) * h;
+      specs[kDxy][index] = ((kx * ky) / kMag) * h;
+    }
+  }
+
+  // Dxx and Dyy are left in the propagation's scratch.
+  const ewav::RSpatialField2Df* fields[] = {
+      &pstate.Dx, &pstate.Dy, &(*prop.MinEScratch)[0], &(*prop.MinEScratch)[1],
+      &pstate.MinE};
+  double maxDiff[kNumSpecs] = {};
+  double maxVal[kNumSpecs] = {};
+  for (int y = 0; y < size.Height; ++y) {
+    for (int x = 0; x < size.Width; ++x) {
+      double sums[kNumSpecs];
+      DirectSum(specs, kNumSpecs, size, x, y, sums);
+
+      // MinE from Dxx, Dyy and Dxy, as ComputeMinE makes it.
+      const double jxx = 1.0 - (pinch * sums[kDxx]);
+      const double jyy = 1.0 - (pinch * sums[kDyy]);
+      const double jxy = -pinch * sums[kDxy];
+      sums[kDxy] = -(((jxx + jyy) / 2.0) -
+                     (std::sqrt(((jxx - jyy) * (jxx - jyy)) +
+                                (4.0 * jxy * jxy)) /
+                      2.0));
+
+      for (int s = 0; s < kNumSpecs; ++s) {
+        maxDiff[s] = std::max(
+            maxDiff[s], std::abs(sums[s] - (*fields[s])[y][x]));
+        maxVal[s] = std::max(maxVal[s], std::abs(sums[s]));
+      }
+    }
+  }
+
+  const char* names[] = {"Dx", "Dy", "Dxx", "Dyy", "MinE"};
+  for (int s = 0; s < kNumSpecs; ++s) {
+    std::cout << "Derivatives, transform " << i_transform << ", " << names[s]
+              << " max difference from direct sum: " << maxDiff[s]
+              << " (max value: " << maxVal[s] << ")" << std::endl;
+    EWAV_ASSERT(maxDiff[s] <= 1.0e-4 * std::max(1.0, maxVal[s]),
+                names[s] << " doesn't match the separate passes.");
+  }
+}
+
+//-*****************************************************************************
+// The packed complex transform must reproduce the real transform, with and
+// without trough damping.
+void testPackedTransform(float i_troughDamping) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 8;
+  params.troughDamping = i_troughDamping;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef realState(params);
+  ewav::PropagatedStatef packedState(params);
+  ewav::Propagationf realProp(params, -1, ewav::kRealPropagationTransform);
+  ewav::Propagationf packedProp(params, -1,
+                                ewav::kPackedComplexPropagationTransform);
+
+  float maxDiff = 0.0f;
+  float maxVal = 0.0f;
+  for (int frame = 1; frame < 4; ++frame) {
+    float ftime = float(frame) / 24.0f;
+    realProp.propagate(params, istate, realState, ftime);
+    packedProp.propagate(params, istate, packedState, ftime);
+    maxDiff = std::max(maxDiff, MaxFieldDifference(realState, packedState,
+                                                   ewav::kAllChannels,
+                                                   &maxVal));
+  }
+
+  std::cout << "Packed transform, trough damping " << i_troughDamping
+            << ", max difference: " << maxDiff << " (max value: " << maxVal
+            << ")" << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-4f * std::max(1.0f, maxVal),
+              "Packed transform doesn't match real transform.");
+}
+
+//-*****************************************************************************
+// Fixed time step playback against direct evaluation of the phase. Reports
+// the accumulated error at each resync interval, and requires it to stay
+// well below the size of the waves. Playback starts at i_startFrame, and
+// must step, rather than resync, between resync intervals.
+float testFixedTimeStep(ewav::PropagationTransform i_transform,
+                        int i_resyncInterval, int i_numFrames,
+                        int i_startFrame = 0) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 8;
+
+  const float dt = 1.0f / 24.0f;
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef directState(params);
+  ewav::PropagatedStatef steppedState(params);
+  ewav::Propagationf directProp(params, -1, i_transform);
+  ewav::Propagationf steppedProp(params, -1, i_transform);
+  steppedProp.setFixedTimeStep(dt, i_resyncInterval);
+
+  float maxDiff = 0.0f;
+  float maxVal = 0.0f;
+  int resyncs = 0;
+  for (int frame = 0; frame < i_numFrames; ++frame) {
+    float ftime = float(i_startFrame + frame) * dt;
+    directProp.propagate(params, istate, directState, ftime);
+    steppedProp.propagate(params, istate, steppedState, ftime);
+    maxDiff = std::max(maxDiff, MaxFieldDifference(directState, steppedState,
+                                                   ewav::kDisplacementChannels,
+                                                   &maxVal));
+    if (frame > 0 && steppedProp.StepsSinceResync == 0) {
+      ++resyncs;
+    }
+
+    if ((frame + 1) % 32 == 0) {
+      std::cout << "Fixed time step, resync interval " << i_resyncInterval
+                << ", frame " << (i_startFrame + frame)
+                << ", max accumulated error: " << maxDiff
+                << " (max value: " << maxVal << ")" << std::endl;
+    }
+  }
+
+  EWAV_ASSERT(resyncs <= (i_numFrames - 1) / (i_resyncInterval + 1),
+              "Fixed time step resynced " << resyncs << " times in "
+                                          << i_numFrames << " frames from "
+                                          << "frame " << i_startFrame);
+  return maxDiff / std::max(1.0f, maxVal);
+}
+
+//-*****************************************************************************
+// Fixed time step playback must resync when given a new initial state, even
+// one that reuses the memory of the state it replaces, and when told that
+// the omegas of its state changed in place.
+void testFixedTimeStepNewState(ewav::PropagationTransform i_transform) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 7;
+  ewav::Parametersf otherParams = params;
+  otherParams.gravity = params.gravity * 0.5f;
+
+  const float dt = 1.0f / 24.0f;
+  ewav::PropagatedStatef directState(params);
+  ewav::PropagatedStatef steppedState(params);
+  ewav::Propagationf directProp(params, -1, i_transform);
+  ewav::Propagationf steppedProp(params, -1, i_transform);
+  steppedProp.setFixedTimeStep(dt, 1 << 30);
+
+  std::unique_ptr<ewav::InitialStatef> istate(new ewav::InitialStatef(params));
+  const float* oldOmega = istate->Omega.cdata();
+  for (int frame = 0; frame < 3; ++frame) {
+    steppedProp.propagate(params, *istate, steppedState, float(frame) * dt);
+  }
+
+  istate.reset();
+  istate.reset(new ewav::InitialStatef(otherParams));
+  const bool reused = istate->Omega.cdata() == oldOmega;
+  directProp.propagate(otherParams, *istate, directState, 3.0f * dt);
+  steppedProp.propagate(otherParams, *istate, steppedState, 3.0f * dt);
+  float maxVal = 0.0f;
+  const float newStateDiff = MaxFieldDifference(
+      directState, steppedState, ewav::kDisplacementChannels, &maxVal);
+
+  for (std::size_t i = 0; i < istate->Omega.size(); ++i) {
+    istate->Omega.data()[i] *= 1.5f;
+  }
+  steppedProp.resetTimeStep();
+  directProp.propagate(otherParams, *istate, directState, 4.0f * dt);
+  steppedProp.propagate(otherParams, *istate, steppedState, 4.0f * dt);
+  const float resetDiff = MaxFieldDifference(
+      directState, steppedState, ewav::kDisplacementChannels, &maxVal);
+
+  std::cout << "Fixed time step, transform " << i_transform
+            << ", new state (memory reused: " << reused
+            << ") max difference: " << newStateDiff
+            << ", after reset: " << resetDiff << " (max value: " << maxVal
+            << ")" << std::endl;
+  EWAV_ASSERT(newStateDiff <= 1.0e-5f * std::max(1.0f, maxVal),
+              "Fixed time step didn't resync for a new state.");
+  EWAV_ASSERT(resetDiff <= 1.0e-5f * std::max(1.0f, maxVal),
+              "Fixed time step didn't resync after a reset.");
+}
+
+//-*****************************************************************************
+// A state with only some channels must get the same fields as a full state,
+// whichever transform is used, and with trough damping on.
+void testChannels(ewav::PropagationTransform i_transform,
+                  unsigned int i_channels) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 7;
+  params.troughDamping = 0.5f;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef fullState(params);
+  ewav::PropagatedStatef partialState(params, i_channels);
+  ewav::Propagationf prop(params, -1, i_transform);
+
+  prop.propagate(params, istate, fullState, 0.5f);
+  prop.propagate(params, istate, partialState, 0.5f);
+
+  for (int f = 0; f < ewav::kNumPropagatedFields; ++f) {
+    const ewav::PropagatedField field = ewav::PropagatedField(f);
+    const bool wanted =
+        (ewav::ResolvePropagatedChannels(i_channels) & (1 << f)) != 0;
+    EWAV_ASSERT(partialState.has(field) == wanted,
+                "Wrong channels in partial state");
+    if (!wanted) {
+      EWAV_ASSERT(partialState.field(field).size() == 0,
+                  "Unwanted field was allocated");
+    }
+  }
+  const float maxDiff = MaxFieldDifference(fullState, partialState);
+
+  std::cout << "Channels " << i_channels << ", transform " << i_transform
+            << ", fields: " << partialState.Fields.count()
+            << ", max difference: " << maxDiff << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-5f, "Partial state doesn't match full state.");
+}
+
+//-*****************************************************************************
+// Propagation only allocates the spectra of the channels it is asked for,
+// the damping fields once damping is on, for the channels damping reads,
+// and the scratch for MinE once MinE is made.
+void testChannelAllocation() {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 6;
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef state(params, ewav::kHeightChannel);
+  ewav::Propagationf prop(params);
+  EWAV_ASSERT(!prop.Spectra && !prop.HFiltSpec && !prop.FiltState,
+              "Propagation allocated before propagating.");
+
+  prop.propagate(params, istate, state, 0.5f);
+  EWAV_ASSERT(prop.Spectra && prop.Spectra->count() == 1,
+              "Wrong number of spectra for height only.");
+  EWAV_ASSERT(!prop.HFiltSpec && !prop.FiltState,
+              "Damping fields allocated without damping.");
+  EWAV_ASSERT(!prop.MinEScratch, "MinE scratch allocated without MinE.");
+
+  params.troughDamping = 0.5f;
+  prop.propagate(params, istate, state, 0.5f);
+  EWAV_ASSERT(prop.HFiltSpec && prop.FiltState &&
+                  prop.FiltState->Channels ==
+                      ewav::ResolvePropagatedChannels(ewav::kHeightChannel |
+                                                      ewav::kMinEChannel),
+              "Wrong damping fields for height only.");
+  std::cout << "Channel allocation, height only: " << prop.Spectra->count()
+            << " spectra, damping channels " << prop.FiltState->Channels
+            << std::endl;
+
+  // A MinE only state holds MinE alone. Dxx and Dyy are made in the
+  // propagation's scratch, once, and reused.
+  params.troughDamping = 0.0f;
+  ewav::PropagatedStatef foam(params, ewav::kMinEChannel);
+  EWAV_ASSERT(foam.Fields.count() == 1 && foam.has(ewav::kMinEField),
+              "MinE only state should hold one field.");
+  prop.propagate(params, istate, foam, 0.5f);
+  EWAV_ASSERT(prop.MinEScratch && prop.MinEScratch->count() == 2 &&
+                  (*prop.MinEScratch)[0].gridSize() == params.gridSize(),
+              "Wrong MinE scratch.");
+  const float* scratch = prop.MinEScratch->cdata();
+  prop.propagate(params, istate, foam, 1.5f);
+  EWAV_ASSERT(prop.MinEScratch->cdata() == scratch,
+              "MinE scratch was made again.");
+  std::cout << "Channel allocation, MinE only: " << foam.Fields.count()
+            << " field" << std::endl;
+}
+
+//-*****************************************************************************
+// An instance with a thread budget runs in its own arena, and an initial
+// state, propagation and normals made in that arena match unbounded ones.
+void testThreadBudget(int i_numThreads) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 7;
+  params.troughDamping = 0.5f;
+
+  ewav::Propagationf boundedProp(params, i_numThreads);
+  EWAV_ASSERT(boundedProp.arena() &&
+                  boundedProp.arena()->max_concurrency() == i_numThreads,
+              "Expected an arena of " << i_numThreads << " threads");
+  ewav::Propagationf prop(params);
+  EWAV_ASSERT(!prop.arena(), "Expected no arena without a thread budget");
+
+  ewav::InitialStatef boundedIState(params, boundedProp.arena());
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef boundedState(params);
+  ewav::PropagatedStatef state(params);
+  boundedProp.propagate(params, boundedIState, boundedState, 0.5f);
+  prop.propagate(params, istate, state, 0.5f);
+
+  const std::size_t numNormals = state.Height.size();
+  std::vector<Imath::V3f> boundedNormals(numNormals);
+  std::vector<Imath::V3f> normals(numNormals);
+  ewav::ComputeNormals(params, boundedState, boundedNormals.data(),
+                       boundedProp.arena());
+  ewav::ComputeNormals(params, state, normals.data());
+
+  float maxDiff = MaxFieldDifference(state, boundedState);
+  for (std::size_t i = 0; i < numNormals; ++i) {
+    maxDiff = std::max(maxDiff, (normals[i] - boundedNormals[i]).length());
+  }
+
+  std::cout << "Thread budget " << i_numThreads
+            << ", max difference from unbounded: " << maxDiff << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-5f, "Bounded instance doesn't match.");
+}
+
+//-*****************************************************************************
+// A batch of frames must match propagating each frame on its own, for
+// evenly and unevenly spaced times, and for passes that don't divide the
+// number of frames. It must also leave fixed time step playback alone.
+void testBatch(float i_troughDamping, bool i_evenlySpaced) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 7;
+  params.troughDamping = i_troughDamping;
+
+  const int numFrames = 5;
+  ewav::InitialStatef istate(params);
+  ewav::Propagationf prop(params);
+  std::vector<float> times;
+  std::vector<std::unique_ptr<ewav::PropagatedStatef>> states;
+  std::vector<ewav::PropagatedStatef*> statePtrs;
+  for (int f = 0; f < numFrames; ++f) {
+    times.push_back(i_evenlySpaced ? 0.5f + float(f) / 24.0f
+                                   : 0.5f + float(f * f) / 24.0f);
+    states.emplace_back(new ewav::PropagatedStatef(params));
+    statePtrs.push_back(states.back().get());
+  }
+  ewav::PropagatedStatef expected(params);
+  prop.setFixedTimeStep(1.0f / 24.0f);
+  prop.propagate(params, istate, expected, 0.25f);
+  prop.propagate(params, istate, expected, 0.25f + 1.0f / 24.0f);
+  const int stepsSinceResync = prop.StepsSinceResync;
+  const int currentPhasor = prop.CurrentPhasor;
+  const float lastTime = prop.LastTime;
+  const std::uint64_t lastGeneration = prop.LastGeneration;
+
+  prop.propagateBatch(params, istate, times.data(), statePtrs.data(),
+                      numFrames, ewav::kAllChannels, 2);
+
+  EWAV_ASSERT(prop.StepsSinceResync == stepsSinceResync &&
+                  prop.CurrentPhasor == currentPhasor &&
+                  prop.LastTime == lastTime &&
+                  prop.LastGeneration == lastGeneration && stepsSinceResync,
+              "Batch changed fixed time step playback.");
+  prop.setFixedTimeStep(0.0f);
+
+  float maxDiff = 0.0f;
+  for (int f = 0; f < numFrames; ++f) {
+    prop.propagate(params, istate, expected, times[f]);
+    maxDiff = std::max(maxDiff, MaxFieldDifference(expected, *states[f]));
+  }
+
+  std::cout << "Batch of " << numFrames << " frames, trough damping "
+            << i_troughDamping << ", evenly spaced " << i_evenlySpaced
+            << ", max difference: " << maxDiff << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-5f, "Batch doesn't match single frames.");
+}
+
+//-*****************************************************************************
+// Propagates an initial state with a loop period by looking phases up in the
+// loop table and by evaluating them, and checks that the loop repeats.
+void testLoop(ewav::PropagationTransform i_transform) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 7;
+  params.loopPeriod = 20.0f;
+  const int loopFrames = 480;
+
+  ewav::InitialStatef istate(params);
+  const float quantum = float(M_TAU) / params.loopPeriod;
+  float maxOffset = 0.0f;
+  for (std::size_t i = 0; i < istate.Omega.size(); ++i) {
+    const float m = istate.Omega.cdata()[i] / quantum;
+    maxOffset = std::max(maxOffset, std::abs(m - std::round(m)));
+  }
+  EWAV_ASSERT(maxOffset < 1.0e-3f,
+              "Omega isn't quantized to the loop period: " << maxOffset);
+
+  ewav::Propagationf loopProp(params, -1, i_transform);
+  loopProp.setLoopFrames(loopFrames);
+  ewav::Propagationf prop(params, -1, i_transform);
+  ewav::PropagatedStatef loopState(params);
+  ewav::PropagatedStatef repeatState(params);
+  ewav::PropagatedStatef state(params);
+
+  float maxDiff = 0.0f;
+  bool repeats = true;
+  const int frames[] = {0, 1, 37, 240, 479};
+  for (int frame : frames) {
+    const float time = params.loopPeriod * float(frame) / float(loopFrames);
+    loopProp.propagate(params, istate, loopState, time);
+    loopProp.propagate(params, istate, repeatState, time + params.loopPeriod);
+    prop.propagate(params, istate, state, time);
+    maxDiff = std::max(maxDiff, MaxFieldDifference(state, loopState));
+    repeats = repeats && MaxFieldDifference(loopState, repeatState) == 0.0f;
+  }
+
+  std::cout << "Loop of " << loopFrames << " frames, transform "
+            << i_transform << ", max difference from evaluated phases: "
+            << maxDiff << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-4f, "Loop table doesn't match.");
+  EWAV_ASSERT(repeats, "Loop doesn't repeat exactly.");
+}
+
+//-*****************************************************************************
+// The fused DampTroughs sweep must blend the damped fields as the separate
+// ConvertMinEToInterpolant and InterpolateIntoB sweeps it replaced did, bar
+// the rounding of a fused multiply-add, and leave fields that are off alone.
+void testDampTroughs() {
+  const std::size_t size = 65 * 65;
+  std::mt19937 gen(54321);
+  std::normal_distribution<float> normal;
+  std::vector<float> filtMinE(size);
+  std::vector<float> filt[3];
+  std::vector<float> separate[3];
+  for (int f = 0; f < 3; ++f) {
+    filt[f].resize(size);
+    separate[f].resize(size);
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    filtMinE[i] = normal(gen);
+    for (int f = 0; f < 3; ++f) {
+      filt[f][i] = normal(gen);
+      separate[f][i] = normal(gen);
+    }
+  }
+  std::vector<float> fused[3] = {separate[0], separate[1], separate[2]};
+
+  const float gain = 0.5f;
+  const float bias = 0.25f;
+  const float minInterpolant = 0.25f;
+  std::vector<float> interpolant = filtMinE;
+  {
+    ewav::ConvertMinEToInterpolant<float> F;
+    F.GainMinE = gain;
+    F.BiasMinE = bias;
+    F.MinClipE = 0.0f;
+    F.MaxClipE = 1.1f;
+    F.MinInterpolant = minInterpolant;
+    F.MinE_And_Interpolant = interpolant.data();
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, size), F);
+  }
+  for (int f = 0; f < 2; ++f) {
+    ewav::InterpolateIntoB<float> F;
+    F.A = filt[f].data();
+    F.B = separate[f].data();
+    F.Interpolant = interpolant.data();
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, size), F);
+  }
+
+  // Dy is off.
+  {
+    ewav::DampTroughs<float> F;
+    F.GainMinE = gain;
+    F.BiasMinE = bias;
+    F.MinClipE = 0.0f;
+    F.MaxClipE = 1.1f;
+    F.MinInterpolant = minInterpolant;
+    F.FiltMinE = filtMinE.data();
+    for (int f = 0; f < 3; ++f) {
+      F.Filt[f] = f < 2 ? filt[f].data() : nullptr;
+      F.Out[f] = f < 2 ? fused[f].data() : nullptr;
+    }
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, size,
+                                        ewav::StreamingGrainSize(size)),
+        F);
+  }
+
+  float maxDiff = 0.0f;
+  for (int f = 0; f < 3; ++f) {
+    for (std::size_t i = 0; i < size; ++i) {
+      maxDiff = std::max(maxDiff, std::abs(separate[f][i] - fused[f][i]));
+    }
+  }
+  std::cout << "Damp troughs, max difference from separate sweeps: "
+            << maxDiff << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-6f,
+              "Fused trough damping doesn't match the separate sweeps.");
+}
+
+//-*****************************************************************************
+// Reduced-resolution trough damping against damping in full. Only the
+// damped fields may differ, and by well under the damping itself: the
+// interpolant misses the shortest waves, so the two can't match. Where the
+// band needs the full resolution they must be the same. Runs on i_grid, with
+// the same spacing along both axes, if it is given.
+void testReducedDamping(ewav::PropagationTransform i_transform,
+                        float i_smallWavelength, double i_maxRelError,
+                        const ewav::GridSize& i_grid = ewav::GridSize()) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 9;
+  params.resolutionX = i_grid.Width;
+  params.resolutionY = i_grid.Height;
+  if (i_grid.Width > 0) {
+    params.domainY = params.domain * float(i_grid.Height) / float(i_grid.Width);
+  }
+  params.troughDamping = 0.5f;
+  params.troughDampingSmallWavelength = i_smallWavelength;
+  params.troughDampingBigWavelength = 8.0f;
+  params.troughDampingSoftWidth = 4.0f;
+  ewav::Parametersf undampedParams = params;
+  undampedParams.troughDamping = 0.0f;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef fullState(params);
+  ewav::PropagatedStatef reducedState(params);
+  ewav::PropagatedStatef undampedState(params);
+  ewav::Propagationf fullProp(params, -1, i_transform);
+  ewav::Propagationf reducedProp(params, -1, i_transform);
+  reducedProp.setReducedTroughDamping(true);
+  const ewav::GridSize size = reducedProp.reducedTroughDampingSize(params);
+
+  double dampingSq = 0.0;
+  double errorSq = 0.0;
+  float maxUndampedDiff = 0.0f;
+  for (int frame = 1; frame < 4; ++frame) {
+    float ftime = float(frame) / 24.0f;
+    fullProp.propagate(params, istate, fullState, ftime);
+    reducedProp.propagate(params, istate, reducedState, ftime);
+    fullProp.propagate(undampedParams, istate, undampedState, ftime);
+
+    for (int f = ewav::kHeightField; f <= ewav::kDyField; ++f) {
+      const float* a = fullState.Fields[f].cdata();
+      const float* b = reducedState.Fields[f].cdata();
+      const float* u = undampedState.Fields[f].cdata();
+      for (std::size_t i = 0; i < fullState.Fields[f].size(); ++i) {
+        dampingSq += double(a[i] - u[i]) * double(a[i] - u[i]);
+        errorSq += double(a[i] - b[i]) * double(a[i] - b[i]);
+      }
+    }
+    maxUndampedDiff = std::max(
+        maxUndampedDiff,
+        MaxFieldDifference(fullState, reducedState,
+                           ewav::kAllChannels & ~ewav::kDisplacementChannels));
+  }
+
+  const double relError = std::sqrt(errorSq / dampingSq);
+  std::cout << "Reduced trough damping, transform " << i_transform
+            << ", small wavelength " << i_smallWavelength << ", resolution "
+            << size.Width << "x" << size.Height
+            << ", error relative to damping: "
+            << relError << std::endl;
+  EWAV_ASSERT(maxUndampedDiff == 0.0f,
+              "Reduced damping changed fields it doesn't damp.");
+  if (size != params.gridSize()) {
+    EWAV_ASSERT(relError <= i_maxRelError,
+                "Reduced damping too far from full: " << relError);
+
+    // The smaller propagation shares the arena, and only has the damping
+    // fields it reads.
+    const ewav::Propagationf& smaller = *reducedProp.ReducedDamping;
+    EWAV_ASSERT(!smaller.OwnedArena && smaller.arena() == reducedProp.arena(),
+                "Reduced damping made its own arena.");
+    EWAV_ASSERT(smaller.FiltState->Channels ==
+                    ewav::ResolvePropagatedChannels(ewav::kHeightChannel |
+                                                    ewav::kMinEChannel),
+                "Reduced damping has the wrong damping fields.");
+  } else {
+    EWAV_ASSERT(errorSq == 0.0, "Reduced damping didn't fall back.");
+  }
+}
+
+//-*****************************************************************************
+// Waves on a grid that isn't square, or whose sides aren't powers of two.
+// The height field must be the sum of the waves of the stored half spectrum,
+// evaluated directly at every sample, with a wrapped border, and its spread
+// must match the spectral stats. Normals and mip-mapping must take the grid.
+void testGrid(int i_width, int i_height, float i_domainX, float i_domainY,
+              ewav::PropagationTransform i_transform) {
+  ewav::Parametersf params;
+  params.resolutionX = i_width;
+  params.resolutionY = i_height;
+  params.domain = i_domainX;
+  params.domainY = i_domainY;
+  const ewav::GridSize size = params.gridSize();
+  const float time = 0.75f;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef pstate(params);
+  ewav::Propagationf prop(params, -1, i_transform);
+  prop.propagate(params, istate, pstate, time);
+  EWAV_ASSERT(istate.Size == size && pstate.Height.gridSize() == size,
+              "Wrong grid size.");
+
+  const ewav::CSpectralField2Df hspec = PropagatedHeightSpectrum(istate, time);
+  const std::vector<std::complex<double>> hspecd(hspec.cbegin(), hspec.cend());
+
+  double maxDiff = 0.0;
+  double maxVal = 0.0;
+  double sumSq = 0.0;
+  for (int y = 0; y < size.Height; ++y) {
+    for (int x = 0; x < size.Width; ++x) {
+      double sum;
+      DirectSum(&hspecd, 1, size, x, y, &sum);
+      maxDiff = std::max(maxDiff, std::abs(sum - pstate.Height[y][x]));
+      maxVal = std::max(maxVal, std::abs(sum));
+      sumSq += sum * sum;
+    }
+  }
+  bool wrapped = true;
+  for (int y = 0; y <= size.Height; ++y) {
+    wrapped = wrapped && pstate.Height[y][size.Width] == pstate.Height[y][0];
+  }
+  for (int x = 0; x <= size.Width; ++x) {
+    wrapped = wrapped && pstate.Height[size.Height][x] == pstate.Height[0][x];
+  }
+
+  const ewav::SpectralStatsf spectral(params, hspec);
+  const double stdDev = std::sqrt(sumSq / double(size.area()));
+
+  std::cout << "Grid " << size.Width << "x" << size.Height << ", domain "
+            << i_domainX << "x" << i_domainY << ", transform " << i_transform
+            << ", max difference from direct sum: " << maxDiff
+            << " (max value: " << maxVal << "), std dev: " << stdDev
+            << " (spectral: " << spectral.StdDevHeight << ")" << std::endl;
+  EWAV_ASSERT(maxDiff <= 1.0e-4 * std::max(1.0, maxVal),
+              "Height doesn't match the direct sum.");
+  EWAV_ASSERT(wrapped, "Border isn't wrapped.");
+  EWAV_ASSERT(std::abs(stdDev - spectral.StdDevHeight) <= 1.0e-4 * stdDev,
+              "Spectral stats don't match the grid.");
+
+  std::vector<Imath::V3f> normals(pstate.Height.size());
+  ewav::ComputeNormals(params, pstate, normals.data());
+  for (const Imath::V3f& n : normals) {
+    EWAV_ASSERT(std::abs(n.length() - 1.0f) < 1.0e-4f && n.z > 0.0f,
+                "Bad normal: " << n);
+  }
+
+  if ((size.Width % 2) == 0 && (size.Height % 2) == 0) {
+    ewav::PropagatedStatef down(
+        ewav::GridSize(size.Width / 2, size.Height / 2));
+    ewav::DownsampleState(pstate, down);
+    float mean = 0.0f;
+    for (int y = 0; y < size.Height; ++y) {
+      for (int x = 0; x < size.Width; ++x) {
+        mean += pstate.Height[y][x];
+      }
+    }
+    float downMean = 0.0f;
+    for (int y = 0; y < size.Height / 2; ++y) {
+      for (int x = 0; x < size.Width / 2; ++x) {
+        downMean += down.Height[y][x];
+      }
+    }
+    mean /= float(size.area());
+    downMean /= float(size.area() / 4);
+    EWAV_ASSERT(std::abs(mean - downMean) <= 1.0e-4f * float(maxVal),
+                "Mip-map doesn't keep the mean.");
+  }
+}
+
+//-*****************************************************************************
+// Fields allocated under any FieldAllocation policy must start out zeroed,
+// padding and all, and propagate bit for bit as under serial allocation.
+void testFieldAllocation(ewav::FieldAllocation i_allocation) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 8;
+  params.troughDamping = 0.5f;
+
+  ewav::SetFieldAllocation(ewav::kSerialFieldAllocation);
+  ewav::InitialStatef serialIstate(params);
+  ewav::PropagatedStatef serialState(params);
+  ewav::Propagationf serialProp(params);
+  serialProp.propagate(params, serialIstate, serialState, 0.5f);
+
+  ewav::SetFieldAllocation(i_allocation);
+  {
+    // A small field, made where a dirtied one just was, and large fields,
+    // which come fresh from the system.
+    const ewav::GridSize smallSize(16, 16);
+    {
+      ewav::RSpatialField2Df dirty(smallSize, 1);
+      std::fill(dirty.data(), dirty.data() + dirty.size(), 1.0f);
+    }
+    ewav::RSpatialField2Df field(smallSize, 1);
+    ewav::PropagatedStatef state(params);
+    bool zeroed = std::all_of(field.cbegin(), field.cend(),
+                              [](float i_v) { return i_v == 0.0f; });
+    for (int f = 0; f < state.Fields.count(); ++f) {
+      zeroed = zeroed && std::all_of(state.Fields[f].cbegin(),
+                                     state.Fields[f].cend(),
+                                     [](float i_v) { return i_v == 0.0f; });
+    }
+
+    ewav::InitialStatef istate(params);
+    ewav::Propagationf prop(params);
+    prop.propagate(params, istate, state, 0.5f);
+    const bool same = MaxFieldDifference(serialState, state) == 0.0f;
+
+    std::cout << "Field allocation " << i_allocation << ", zeroed: " << zeroed
+              << ", same as serial: " << same << std::endl;
+    EWAV_ASSERT(zeroed, "Fields weren't zeroed when allocated.");
+    EWAV_ASSERT(same, "Fields propagate differently by allocation.");
+  }
+  ewav::SetFieldAllocation(ewav::kParallelFieldAllocation);
+}
+
+//-*****************************************************************************
+// Fields on huge pages, which are mapped rather than allocated once they are
+// large enough, must propagate exactly as those on small pages.
+void testFieldPages(ewav::FieldPages i_pages) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 11;
+  params.troughDamping = 0.5f;
+
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef smallState(params);
+  ewav::Propagationf smallProp(params);
+
+  ewav::SetFieldPages(i_pages);
+  {
+    ewav::PropagatedStatef hugeState(params);
+    ewav::Propagationf hugeProp(params);
+    smallProp.propagate(params, istate, smallState, 0.5f);
+    hugeProp.propagate(params, istate, hugeState, 0.5f);
+
+    const bool same = MaxFieldDifference(smallState, hugeState) == 0.0f;
+    std::cout << "Field pages " << i_pages << ", same as small pages: "
+              << same << std::endl;
+    EWAV_ASSERT(same, "Huge page fields don't match.");
+  }
+  ewav::SetFieldPages(ewav::kSmallFieldPages);
+}
+
+//-*****************************************************************************
+// Blending two initial states which share their random draws must blend the
+// energy of each bin, and reproduce each state at its end of the blend.
+void testBlend(ewav::PropagationTransform i_transform) {
+  ewav::Parametersf paramsA;
+  paramsA.resolutionPowerOfTwo = 8;
+  paramsA.windSpeed = 10.0f;
+  ewav::Parametersf paramsB = paramsA;
+  paramsB.windSpeed = 20.0f;
+  paramsB.directionalSpreading.type = ewav::kDonelanBannerDirectionalSpreading;
+
+  ewav::InitialStateNoisef noise(paramsA);
+  ewav::InitialStatef istateA(paramsA, noise);
+  ewav::InitialStatef istateB(paramsB, noise);
+
+  // Energy of each bin.
+  const float t = 0.3f;
+  const ewav::InitialSpectra<float> blended(istateA, &istateB, t);
+  float maxEnergyErr = 0.0f;
+  for (std::size_t i = 0; i < istateA.HSpectralPos.size(); ++i) {
+    const float expected =
+        ((1.0f - t) * std::norm(istateA.HSpectralPos.cdata()[i])) +
+        (t * std::norm(istateB.HSpectralPos.cdata()[i]));
+    maxEnergyErr = std::max(maxEnergyErr,
+                            std::abs(std::norm(blended.pos(i)) - expected) /
+                                std::max(expected, 1.0e-30f));
+  }
+  std::cout << "Blend, transform " << i_transform
+            << ", max relative bin energy error: " << maxEnergyErr
+            << std::endl;
+  EWAV_ASSERT(maxEnergyErr < 1.0e-4f, "Blend doesn't preserve energy.");
+
+  // Each end of the blend.
+  ewav::Propagationf prop(paramsA, -1, i_transform);
+  ewav::PropagatedStatef blendState(paramsA);
+  ewav::PropagatedStatef state(paramsA);
+  const ewav::InitialStatef *ends[] = {&istateA, &istateB};
+  for (int e = 0; e < 2; ++e) {
+    prop.propagateBlend(paramsA, istateA, istateB, float(e), blendState,
+                        0.5f);
+    prop.propagate(paramsA, *ends[e], state, 0.5f);
+
+    float maxVal = 0.0f;
+    const float maxDiff =
+        MaxFieldDifference(state, blendState, ewav::kAllChannels, &maxVal);
+    std::cout << "  blend " << e << ", max difference: " << maxDiff
+              << " (max value: " << maxVal << ")" << std::endl;
+    EWAV_ASSERT(maxDiff <= 1.0e-4f * std::max(1.0f, maxVal),
+                "Blend doesn't match the initial state at its end.");
+  }
+}
+
+//-*****************************************************************************
+// A compact initial state must propagate to within its packing error of the
+// initial state it was packed from, with the same omegas.
+void testCompact(ewav::PropagationTransform i_transform, float i_troughDamping,
+                 float i_loopPeriod) {
+  ewav::Parametersf params;
+  params.resolutionX = 96;
+  params.resolutionY = 64;
+  params.domainY = 70.0f;
+  params.troughDamping = i_troughDamping;
+  params.loopPeriod = i_loopPeriod;
+
+  ewav::InitialStatef istate(params);
+  ewav::CompactInitialStatef compact(istate);
+
+  const int width = istate.Omega.width();
+  const int height = istate.Size.Height;
+  bool sameOmega = true;
+  float maxPackErr = 0.0f;
+  for (int j = 0; j < height; ++j) {
+    const int folded = ewav::CompactInitialStatef::FoldedRow(j, height);
+    for (int i = 0; i < width; ++i) {
+      const std::size_t index = (std::size_t(j) * width) + i;
+      sameOmega = sameOmega &&
+                  istate.Omega.cdata()[index] ==
+                      compact.Omega[(std::size_t(folded) * width) + i];
+      const std::complex<float> h = istate.HSpectralPos.cdata()[index];
+      const std::complex<float> u = compact.unpack(compact.PackedPos[index]);
+      const float component = std::max(std::abs(h.real()), std::abs(h.imag()));
+      if (component > 0.0f) {
+        maxPackErr = std::max(maxPackErr, std::abs(u - h) / component);
+      }
+    }
+  }
+
+  ewav::Propagationf prop(params, -1, i_transform);
+  prop.setLoopFrames(i_loopPeriod > 0 ? 24 : 0);
+  ewav::PropagatedStatef fullState(params);
+  ewav::PropagatedStatef compactState(params);
+  float maxDiff = 0.0f;
+  float maxVal = 0.0f;
+  for (int frame = 0; frame < 3; ++frame) {
+    const float time = i_loopPeriod > 0 ? float(frame) * i_loopPeriod / 24.0f
+                                        : 0.37f * float(frame);
+    prop.propagate(params, istate, fullState, time);
+    prop.propagate(params, compact, compactState, time);
+    maxDiff = std::max(maxDiff, MaxFieldDifference(fullState, compactState,
+                                                   ewav::kAllChannels,
+                                                   &maxVal));
+  }
+
+  const std::size_t fullBytes =
+      (istate.HSpectralPos.size() + istate.HSpectralNeg.size()) *
+          sizeof(std::complex<float>) +
+      istate.Omega.size() * sizeof(float);
+  std::cout << "Compact, transform " << i_transform << ", trough damping "
+            << i_troughDamping << ", loop " << i_loopPeriod
+            << ", bytes: " << compact.memorySize() << " of " << fullBytes
+            << ", max packing error: " << maxPackErr
+            << ", max difference: " << maxDiff << " (max value: " << maxVal
+            << ")" << std::endl;
+  EWAV_ASSERT(sameOmega, "Compact omegas differ.");
+  EWAV_ASSERT(maxPackErr < 3.5e-4f, "Compact packing error too large.");
+  EWAV_ASSERT(maxDiff <= 2.0e-3f * std::max(1.0f, maxVal),
+              "Compact initial state doesn't match initial state.");
+  EWAV_ASSERT(20 * compact.memorySize() < 11 * fullBytes,
+              "Compact initial state isn't compact.");
+}
+
 //-*****************************************************************************
 int main(int argc, char* argv[]) {
   ewav::Parametersf params;
@@ -71,5 +1027,79 @@ int main(int argc, char* argv[]) {
               << "MinE: " << pstate.MinE[N / 4][N / 4] << std::endl;
   }
 
+  testDerivatives(ewav::kRealPropagationTransform);
+  testDerivatives(ewav::kPackedComplexPropagationTransform);
+
+  testPackedTransform(0.0f);
+  testPackedTransform(0.5f);
+
+  // Without resyncing the drift just accumulates. Measure it, but only
+  // require it to be bounded when resyncing.
+  testFixedTimeStep(ewav::kRealPropagationTransform, 1 << 30, 256);
+  float err = testFixedTimeStep(ewav::kRealPropagationTransform, 32, 256);
+  EWAV_ASSERT(err < 1.0e-4f, "Fixed time step drift too large: " << err);
+  err = testFixedTimeStep(ewav::kPackedComplexPropagationTransform, 32, 96);
+  EWAV_ASSERT(err < 1.0e-4f, "Fixed time step drift too large: " << err);
+  // Ten minutes in, at 24 fps, a float time rounds by more than a
+  // thousandth of a step. The steps don't see that rounding, and the
+  // direct phases do, so they differ by a little more.
+  err = testFixedTimeStep(ewav::kRealPropagationTransform, 32, 96, 14400);
+  EWAV_ASSERT(err < 1.0e-3f, "Fixed time step drift too large: " << err);
+  testFixedTimeStepNewState(ewav::kRealPropagationTransform);
+  testFixedTimeStepNewState(ewav::kPackedComplexPropagationTransform);
+
+  const unsigned int channelMasks[] = {
+      ewav::kHeightChannel, ewav::kMinEChannel,
+      ewav::kHeightChannel | ewav::kDyChannel,
+      ewav::kDxChannel | ewav::kMinEChannel, ewav::kDisplacementChannels};
+  for (unsigned int channels : channelMasks) {
+    testChannels(ewav::kRealPropagationTransform, channels);
+    testChannels(ewav::kPackedComplexPropagationTransform, channels);
+  }
+  testChannelAllocation();
+
+  testThreadBudget(1);
+  testThreadBudget(2);
+
+  testBatch(0.0f, true);
+  testBatch(0.0f, false);
+  testBatch(0.5f, true);
+
+  testLoop(ewav::kRealPropagationTransform);
+  testLoop(ewav::kPackedComplexPropagationTransform);
+
+  testDampTroughs();
+
+  // The bounds are the measured errors, 0.256, 0.350 and 0.181, plus a
+  // margin. The 0.25 wavelength band doesn't fit a smaller grid, so that
+  // falls back to full damping.
+  testReducedDamping(ewav::kRealPropagationTransform, 2.0f, 0.27);
+  testReducedDamping(ewav::kPackedComplexPropagationTransform, 2.0f, 0.27);
+  testReducedDamping(ewav::kRealPropagationTransform, 6.0f, 0.37);
+  testReducedDamping(ewav::kRealPropagationTransform, 0.25f, 0.0);
+  testReducedDamping(ewav::kRealPropagationTransform, 2.0f, 0.19,
+                     ewav::GridSize(384, 256));
+
+  testGrid(45, 27, 100.0f, 60.0f, ewav::kRealPropagationTransform);
+  testGrid(45, 27, 100.0f, 60.0f, ewav::kPackedComplexPropagationTransform);
+  testGrid(96, 64, 150.0f, 100.0f, ewav::kRealPropagationTransform);
+  testGrid(96, 64, 150.0f, 100.0f, ewav::kPackedComplexPropagationTransform);
+  testGrid(24, 10, 50.0f, 50.0f, ewav::kRealPropagationTransform);
+
+  testFieldAllocation(ewav::kSerialFieldAllocation);
+  testFieldAllocation(ewav::kParallelFieldAllocation);
+  testFieldAllocation(ewav::kInterleavedFieldAllocation);
+
+  testFieldPages(ewav::kTransparentHugeFieldPages);
+  testFieldPages(ewav::kExplicitHugeFieldPages);
+
+  testBlend(ewav::kRealPropagationTransform);
+  testBlend(ewav::kPackedComplexPropagationTransform);
+
+  testCompact(ewav::kRealPropagationTransform, 0.0f, 0.0f);
+  testCompact(ewav::kPackedComplexPropagationTransform, 0.0f, 0.0f);
+  testCompact(ewav::kRealPropagationTransform, 0.5f, 0.0f);
+  testCompact(ewav::kRealPropagationTransform, 0.0f, 8.0f);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+void fill(ewav::PropagatedStatef& o_state, float i_value) {
+  for (int f = 0; f < o_state.Fields.count(); ++f) {
+    ewav::RSpatialField2Df& field = o_state.Fields[f];
+    std::fill(field.data(), field.data() + field.size(), i_value);
+  }
+}
+
+// Whether every value of every field is i_value.
+bool filledWith(const ewav::PropagatedStatef& i_state, float i_value) {
+  for (int f = 0; f < i_state.Fields.count(); ++f) {
+    const ewav::RSpatialField2Df& field = i_state.Fields[f];
+    for (std::size_t i = 0; i < field.size(); ++i) {
+      if (field.cdata()[i] != i_value) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//-*****************************************************************************
+// Held snapshots are never written, and released ones are reused.
+void testReuse() {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 3;
+  ewav::SnapshotPublisherf publisher(params);
+  EWAV_ASSERT(!publisher.acquire(), "Expected no snapshot before publishing");
+
+  fill(publisher.beginWrite(), 1.0f);
+  publisher.publish(1.0f);
+  ewav::PropagatedSnapshotReff first = publisher.acquire();
+  EWAV_ASSERT(first && first.sequence() == 1 && first.time() == 1.0f,
+              "Expected the first snapshot");
+
+  for (int i = 2; i < 100; ++i) {
+    fill(publisher.beginWrite(), float(i));
+    publisher.publish(float(i));
+    ewav::PropagatedSnapshotReff newest = publisher.acquire();
+    EWAV_ASSERT(filledWith(newest.state(), float(i)),
+                "Expected snapshot " << i);
+  }
+  EWAV_ASSERT(filledWith(first.state(), 1.0f),
+              "A held snapshot was written");
+  EWAV_ASSERT(publisher.poolSize() == 3,
+              "Expected a pool of 3, got " << publisher.poolSize());
+
+  ewav::PropagatedSnapshotReff copy = first;
+  first.reset();
+  fill(publisher.beginWrite(), 100.0f);
+  publisher.publish(100.0f);
+  EWAV_ASSERT(filledWith(copy.state(), 1.0f), "A copied snapshot was written");
+  copy.reset();
+  for (int i = 101; i < 104; ++i) {
+    fill(publisher.beginWrite(), float(i));
+    publisher.publish(float(i));
+  }
+  EWAV_ASSERT(publisher.poolSize() == 3, "Released snapshots weren't reused");
+  std::cout << "Snapshot reuse passed." << std::endl;
+}
+
+//-*****************************************************************************
+// One writer publishes snapshots filled with their sequence number as fast
+// as it can, while readers check that every snapshot they get is whole and
+// never older than the last one they got. Readers hold a few snapshots at
+// a time, so that the writer has to work around them.
+void testConcurrent(int i_numReaders, int i_numPublishes) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = 4;
+  ewav::SnapshotPublisherf publisher(params);
+  const int numHeld = 3;
+
+  std::atomic<bool> done(false);
+  std::atomic<int> failures(0);
+  std::atomic<long> reads(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < i_numReaders; ++r) {
+    readers.emplace_back([&] {
+      std::vector<ewav::PropagatedSnapshotReff> held(numHeld);
+      std::uint64_t lastSequence = 0;
+      long count = 0;
+      while (!done.load()) {
+        ++reads;
+        ewav::PropagatedSnapshotReff snapshot = publisher.acquire();
+        if (!snapshot) {
+          continue;
+        }
+        if (snapshot.sequence() < lastSequence ||
+            !filledWith(snapshot.state(), float(snapshot.sequence()))) {
+          ++failures;
+        }
+        lastSequence = snapshot.sequence();
+        held[count % numHeld] = snapshot;
+        ++count;
+        std::this_thread::yield();
+      }
+      for (const ewav::PropagatedSnapshotReff& snapshot : held) {
+        if (snapshot && !filledWith(snapshot.state(),
+                                    float(snapshot.sequence()))) {
+          ++failures;
+        }
+      }
+    });
+  }
+
+  // Keep publishing until the readers have had a fair go, even on one core.
+  const long minReads = 10 * long(i_numPublishes);
+  int publishes = 0;
+  while (publishes < i_numPublishes || reads.load() < minReads) {
+    ++publishes;
+    fill(publisher.beginWrite(), float(publishes));
+    publisher.publish(float(publishes) / 24.0f);
+    std::this_thread::yield();
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  // Each reader holds its snapshots, plus one it may be checking.
+  const std::size_t maxPool = i_numReaders * (numHeld + 1) + 2;
+  std::cout << "Snapshots, " << i_numReaders << " readers, "
+            << publishes << " publishes, " << reads.load()
+            << " reads, pool of " << publisher.poolSize() << std::endl;
+  EWAV_ASSERT(failures.load() == 0,
+              failures.load() << " torn or out of order snapshots");
+  EWAV_ASSERT(publisher.poolSize() <= maxPool,
+              "Pool grew to " << publisher.poolSize());
+}
+
+//-*****************************************************************************
+int main(int argc, char* argv[]) {
+  testReuse();
+  testConcurrent(1, 2000);
+  testConcurrent(4, 2000);
+  return 0;
+}
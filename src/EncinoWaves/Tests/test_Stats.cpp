@@ -0,0 +1,261 @@
+//-*****************************************************************************
+// Copyright 2015 Christopher Jon Horvath
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-*****************************************************************************
+
+//-*****************************************************************************
+// The basic architecture of these Waves is based on the TweakWaves application
+// written by Chris Horvath for Tweak Films in 2001.  This, in turn, was based
+// on the SIGGRAPH papers and courses by Jerry Tessendorf, and by the paper
+// "A Simple Fluid Solver based on the FTT" by Jos Stam.
+//
+// The TMA, JONSWAP, and Pierson Moskowitz Wave Spectra, as well as the
+// directional spreading functions are formulated based on the descriptions
+// given in "Ocean Waves: The Stochastic Approach",
+// by Michel K. Ochi, published by Cambridge Ocean Technology Series, 1998,2005.
+//
+// This library is written as a working implementation of the paper:
+// Christopher J. Horvath. 2015.
+// Empirical directional wave spectra for computer graphics.
+// In Proceedings of the 2015 Symposium on Digital Production (DigiPro '15),
+// Los Angeles, Aug. 8, 2015, pp. 29-39.
+//-*****************************************************************************
+
+#include <EncinoWaves/All.h>
+
+#include <tbb/task_arena.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ewav = EncinoWaves;
+
+//-*****************************************************************************
+// Double precision two pass reference.
+void reference(const ewav::RSpatialField2Df& i_field, double& o_min,
+               double& o_max, double& o_mean, double& o_stdDev) {
+  const std::size_t size = i_field.size();
+  o_min = o_max = i_field.cdata()[0];
+  double sum = 0.0;
+  for (std::size_t i = 0; i < size; ++i) {
+    const double v = i_field.cdata()[i];
+    o_min = std::min(o_min, v);
+    o_max = std::max(o_max, v);
+    sum += v;
+  }
+  o_mean = sum / double(size);
+  double m2 = 0.0;
+  for (std::size_t i = 0; i < size; ++i) {
+    m2 += ewav::sqr(double(i_field.cdata()[i]) - o_mean);
+  }
+  o_stdDev = std::sqrt(m2 / double(size));
+}
+
+//-*****************************************************************************
+bool sameBits(const ewav::Statsf& i_a, const ewav::Statsf& i_b) {
+  const float a[] = {i_a.MinHeight, i_a.MaxHeight, i_a.MeanHeight,
+                     i_a.StdDevHeight, i_a.MinMinE, i_a.MaxMinE,
+                     i_a.MeanMinE, i_a.StdDevMinE};
+  const float b[] = {i_b.MinHeight, i_b.MaxHeight, i_b.MeanHeight,
+                     i_b.StdDevHeight, i_b.MinMinE, i_b.MaxMinE,
+                     i_b.MeanMinE, i_b.StdDevMinE};
+  return memcmp(a, b, sizeof(a)) == 0;
+}
+
+//-*****************************************************************************
+// The fused stats match a double precision reference, and are bit for bit
+// the same in arenas of any number of threads.
+void testStats(int i_powerOfTwo) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef pstate(params);
+  ewav::Propagationf prop(params);
+  prop.propagate(params, istate, pstate, 1.5f);
+
+  const ewav::Statsf stats(pstate.Height, pstate.MinE);
+
+  double hmin, hmax, hmean, hstd, emin, emax, emean, estd;
+  reference(pstate.Height, hmin, hmax, hmean, hstd);
+  reference(pstate.MinE, emin, emax, emean, estd);
+  std::cout << "N = " << istate.resolution() << std::endl
+            << (boost::format("  Height (min, max, mean, stddev): "
+                              "(%f, %f, %g, %f)") %
+                stats.MinHeight % stats.MaxHeight % stats.MeanHeight %
+                stats.StdDevHeight)
+            << std::endl
+            << (boost::format("  MinE (min, max, mean, stddev): "
+                              "(%f, %f, %f, %f)") %
+                stats.MinMinE % stats.MaxMinE % stats.MeanMinE %
+                stats.StdDevMinE)
+            << std::endl;
+
+  EWAV_ASSERT(stats.MinHeight == float(hmin) && stats.MaxHeight == float(hmax)
+                && stats.MinMinE == float(emin) && stats.MaxMinE == float(emax),
+              "Bad min or max");
+  const double tol = 1.0e-5;
+  EWAV_ASSERT(std::abs(stats.MeanHeight - hmean) <= tol * hstd &&
+                std::abs(stats.StdDevHeight - hstd) <= tol * hstd,
+              "Bad height moments");
+  EWAV_ASSERT(std::abs(stats.MeanMinE - emean) <= tol * estd &&
+                std::abs(stats.StdDevMinE - estd) <= tol * estd,
+              "Bad MinE moments");
+
+  const int maxThreads = std::thread::hardware_concurrency();
+  for (int n : {1, 2, 3, 4, maxThreads}) {
+    tbb::task_arena arena(n);
+    arena.execute([&] {
+      const ewav::Statsf threaded(pstate.Height, pstate.MinE);
+      EWAV_ASSERT(sameBits(stats, threaded),
+                  "Stats differ in an arena of " << n << " threads");
+    });
+  }
+}
+
+//-*****************************************************************************
+// Moments over the unpadded N x N grid of a propagated state, in double
+// precision: height mean and variance, and the mean and variance of A and
+// the mean of B^2, where MinE = B - A, with A = 1 - pinch (Dxx + Dyy) / 2.
+struct GridMoments {
+  double MeanHeight   = 0.0;
+  double VarHeight    = 0.0;
+  double MeanTrace    = 0.0;
+  double VarTrace     = 0.0;
+  double MeanSpread2  = 0.0;
+  double MeanMinE     = 0.0;
+
+  // Dxx and Dyy are read from the scratch of the propagation that made
+  // i_state.
+  GridMoments(const ewav::PropagatedStatef& i_state,
+              const ewav::Propagationf& i_prop) {
+    const ewav::RSpatialField2Df& dxx = (*i_prop.MinEScratch)[0];
+    const ewav::RSpatialField2Df& dyy = (*i_prop.MinEScratch)[1];
+    const int N         = i_state.Height.unpaddedWidth();
+    const double pinch  = 1.25;
+    const double count  = double(N) * double(N);
+    for (int pass = 0; pass < 2; ++pass) {
+      for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
+          const double h = i_state.Height(x, y);
+          const double a = 1.0 - pinch * (dxx(x, y) + dyy(x, y)) / 2.0;
+          const double b = i_state.MinE(x, y) + a;
+          if (pass == 0) {
+            MeanHeight += h / count;
+            MeanTrace += a / count;
+            MeanSpread2 += b * b / count;
+            MeanMinE += i_state.MinE(x, y) / count;
+          } else {
+            VarHeight += ewav::sqr(h - MeanHeight) / count;
+            VarTrace += ewav::sqr(a - MeanTrace) / count;
+          }
+        }
+      }
+    }
+  }
+};
+
+//-*****************************************************************************
+// Propagates the height spectrum of i_istate to i_time.
+void propagateHeightSpectrum(const ewav::Parametersf& i_params,
+                             const ewav::InitialStatef& i_istate,
+                             float i_time, ewav::CSpectralField2Df& o_hspec) {
+  ewav::HSPEC<float> F;
+  F.HSpecPos  = i_istate.HSpectralPos.cdata();
+  F.HSpecNeg  = i_istate.HSpectralNeg.cdata();
+  F.Omega     = i_istate.Omega.cdata();
+  F.HSpecProp = o_hspec.data();
+  F.Time      = i_time;
+  ewav::SpectralIterationFunctor<float, ewav::HSPEC<float>, ewav::HSPEC<float>>
+    SIF(&F, i_params.domain, i_istate.resolution());
+}
+
+//-*****************************************************************************
+// The spectral stats of a propagated height spectrum match the moments of
+// the grid it transforms to. With omegas quantized to a loop, the cross
+// terms of each bin cancel over enough evenly spaced frames of the loop,
+// so the time averaged stats of the initial state are the mean of the
+// stats of those frames.
+void testSpectralStats(int i_powerOfTwo) {
+  ewav::Parametersf params;
+  params.resolutionPowerOfTwo = i_powerOfTwo;
+  params.loopPeriod           = 20.0f;
+  ewav::InitialStatef istate(params);
+  ewav::PropagatedStatef pstate(params);
+  ewav::Propagationf prop(params);
+  ewav::CSpectralField2Df hspec(i_powerOfTwo);
+
+  double maxErr = 0.0;
+  for (int f = 0; f < 8; ++f) {
+    const float time = 1.0f + 3.7f * float(f);
+    prop.propagate(params, istate, pstate, time);
+    propagateHeightSpectrum(params, istate, time, hspec);
+    const ewav::SpectralStatsf spectral(params, hspec);
+    const GridMoments grid(pstate, prop);
+
+    const double hstd = std::sqrt(grid.VarHeight);
+    const double astd = std::sqrt(grid.VarTrace);
+    const double errs[] = {
+      std::abs(spectral.MeanHeight - grid.MeanHeight) / hstd,
+      std::abs(spectral.StdDevHeight - hstd) / hstd,
+      std::abs(spectral.MeanJacobianTrace - grid.MeanTrace),
+      std::abs(spectral.StdDevJacobianTrace - astd) / astd,
+      std::abs(ewav::sqr(spectral.RmsJacobianSpread) - grid.MeanSpread2) /
+        grid.MeanSpread2};
+    for (double err : errs) {
+      maxErr = std::max(maxErr, err);
+    }
+    EWAV_ASSERT(grid.MeanMinE <= spectral.MaxMeanMinE,
+                "Mean MinE " << grid.MeanMinE << " above its bound "
+                             << spectral.MaxMeanMinE);
+  }
+
+  const int numFrames = 1024;
+  double varHeight    = 0.0;
+  double varTrace     = 0.0;
+  double spread2      = 0.0;
+  for (int f = 0; f < numFrames; ++f) {
+    const float time = params.loopPeriod * float(f) / float(numFrames);
+    propagateHeightSpectrum(params, istate, time, hspec);
+    const ewav::SpectralStatsf spectral(params, hspec);
+    varHeight += ewav::sqr(double(spectral.StdDevHeight)) / numFrames;
+    varTrace += ewav::sqr(double(spectral.StdDevJacobianTrace)) / numFrames;
+    spread2 += ewav::sqr(double(spectral.RmsJacobianSpread)) / numFrames;
+  }
+  const ewav::SpectralStatsf averaged(params, istate);
+  const double avgErrs[] = {
+    std::abs(ewav::sqr(averaged.StdDevHeight) / varHeight - 1.0),
+    std::abs(ewav::sqr(averaged.StdDevJacobianTrace) / varTrace - 1.0),
+    std::abs(ewav::sqr(averaged.RmsJacobianSpread) / spread2 - 1.0)};
+  double avgErr = 0.0;
+  for (double err : avgErrs) {
+    avgErr = std::max(avgErr, err);
+  }
+
+  std::cout << "Spectral stats, N = " << istate.resolution()
+            << ", max relative error per frame: " << maxErr
+            << ", of time average: " << avgErr << std::endl;
+  EWAV_ASSERT(maxErr < 1.0e-4, "Spectral stats don't match the grid");
+  EWAV_ASSERT(avgErr < 1.0e-4, "Time averaged spectral stats don't match");
+}
+
+//-*****************************************************************************
+int main(int argc, char* argv[]) {
+  testStats(4);
+  testStats(7);
+  testStats(10);
+  testSpectralStats(6);
+  testSpectralStats(8);
+  return 0;
+}